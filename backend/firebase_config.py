@@ -26,4 +26,5 @@ firebase_admin.initialize_app(cred, {
 
 # Get Realtime Database and Firestore instances
 rtdb = db.reference('/')
+devices_ref = db.reference('/devices')  # each node writes under /devices/<id>/
 firestore_db = firestore.client()
\ No newline at end of file
@@ -1,34 +1,43 @@
 import time
-from firebase_config import rtdb, firestore_db
+from firebase_config import devices_ref, firestore_db
 from telegram_bot import TelegramBot
 from datetime import datetime
 import threading
 import signal
 import sys
 
+DEVICE_SCAN_INTERVAL = 60  # seconds between looks for newly added devices
+
 class DataHandler:
     def __init__(self):
         self.telegram_bot = TelegramBot()
-        self.samples = []
+        self.samples = {}  # device id -> pending samples
         self.max_samples = 100
         self.enableFirebase = True
         self.enableTelegram = True
+        self.running = True
+        self.listeners = {}  # device id -> live node listener
+        self.lock = threading.Lock()  # guards self.samples; listeners run on one thread per device
         
     def stop(self):
         """Stop the data handler"""
         self.running = False
+        for listener in self.listeners.values():
+            listener.close()
         # Store any remaining samples
-        if self.samples:
-            self.store_in_firestore()
+        with self.lock:
+            pending, self.samples = self.samples, {}
+        for device_id, samples in pending.items():
+            self.store_in_firestore(device_id, samples)
 
-    def store_in_firestore(self):
-        if not self.samples:
+    def store_in_firestore(self, device_id, samples):
+        if not samples:
             return
             
         batch = firestore_db.batch()
         collection = firestore_db.collection('sensor_history')
         
-        for sample in self.samples:
+        for sample in samples:
             doc_ref = collection.document()
             batch.set(doc_ref, {
                 **sample,
@@ -36,26 +45,58 @@ class DataHandler:
             })
             
         batch.commit()
-        print(f"Stored {len(self.samples)} samples in Firestore")
-        self.samples = []  # Clear samples after storing
+        print(f"[{device_id}] Stored {len(samples)} samples in Firestore")
 
-    def handle_realtime_data(self, event):
-        """Handle new data from Realtime Database"""
-        if event.data:
-            print(f"STATUS:{event.data['status']['alertTriggered']} | Tilt:{event.data['sensors']['tilt']} | Gyro:{event.data['sensors']['gyro']} | Acc:{event.data['sensors']['accelerometer']}")
-            
-            event.data['timestamp'] = datetime.now()
+    def handle_device_data(self, device_id, data):
+        """Handle one live snapshot from a single device"""
+        print(f"[{device_id}] STATUS:{data['status']['alertTriggered']} | Tilt:{data['sensors']['tilt']} | Gyro:{data['sensors']['gyro']} | Acc:{data['sensors']['accelerometer']}")
 
-            if self.enableFirebase:            
-                self.samples.append(event.data)
-                if len(self.samples) >= self.max_samples:
-                    self.store_in_firestore()
-                if (self.enableTelegram):
-                    self.telegram_bot.handleChat(event.data)
+        data['deviceId'] = device_id
+        data['timestamp'] = datetime.now()
+
+        if self.enableFirebase:
+            # Only swap out a full batch under the lock; the commit and the
+            # Telegram calls go over the network and must not hold up the
+            # other devices' listeners
+            full = None
+            with self.lock:
+                samples = self.samples.setdefault(device_id, [])
+                samples.append(data)
+                if len(samples) >= self.max_samples:
+                    full = samples
+                    self.samples[device_id] = []
+            if full:
+                self.store_in_firestore(device_id, full)
+            if (self.enableTelegram):
+                self.telegram_bot.handleChat(data)
+
+    def handle_live_data(self, device_id, event):
+        """Handle a write to /devices/<id>/live"""
+        # The device replaces the whole node; the first event is its current value
+        if event.path != '/' or not isinstance(event.data, dict):
+            return
+        self.handle_device_data(device_id, event.data)
+
+    def watch_new_devices(self):
+        """Listen on the live node of every device not watched yet"""
+        # Shallow: only the device ids, never their history
+        devices = devices_ref.get(shallow=True) or {}
+        for device_id in devices:
+            if device_id in self.listeners:
+                continue
+            live_ref = devices_ref.child(device_id).child('live')
+            self.listeners[device_id] = live_ref.listen(
+                lambda event, device_id=device_id: self.handle_live_data(device_id, event))
+            print(f"[{device_id}] Listening for live data")
 
     def start_listening(self):
-        """Start listening to Firebase Realtime Database"""
-        rtdb.listen(self.handle_realtime_data)
+        """Listen per device on /devices/<id>/live
+
+        History and config under the same device are not in the listened
+        subtree, so their writes are never downloaded here."""
+        while self.running:
+            self.watch_new_devices()
+            time.sleep(DEVICE_SCAN_INTERVAL)
 
 def main():
     handler = DataHandler()
@@ -19,10 +19,10 @@ class TelegramBot:
         self.dispatcher = self.updater.dispatcher
         self.job_queue = self.updater.job_queue
         self.subscribed_users = set()
-        self.latest_sensor_data = {}  # Store latest sensor data here
+        self.latest_sensor_data = {}  # device id -> latest sensor data
         self.setup_handlers()
         self.lastSubscriptionMillis = 0
-        self.lastTriggerMillis = 0
+        self.lastTriggerMillis = {}  # device id -> last alert time
         
     def setup_handlers(self):
         self.dispatcher.add_handler(CommandHandler("start", self.start))
@@ -33,8 +33,8 @@ class TelegramBot:
 
     def send_periodic_update(self, context: CallbackContext):
         chat_id = context.job.context
-        if chat_id in self.subscribed_users:
-            message = self.format_sensor_data(self.latest_sensor_data)
+        if chat_id in self.subscribed_users and self.latest_sensor_data:
+            message = self.format_all_devices()
             context.bot.send_message(chat_id=chat_id, text="[Langganan] Status sensor:\n" + message)
         
     def subscribe(self, update: Update, context: CallbackContext):
@@ -83,12 +83,16 @@ class TelegramBot:
     
     def status(self, update: Update, context: CallbackContext):
         if self.latest_sensor_data:
-            message = self.format_sensor_data(self.latest_sensor_data)
+            message = self.format_all_devices()
             update.message.reply_text("Status sensor terkini:\n" + message)
         else:
             update.message.reply_text("Belum ada data sensor yang diterima.")
         pass
 
+    def format_all_devices(self):
+        # Listener threads add devices meanwhile; format a snapshot
+        return "\n\n".join(self.format_sensor_data(data) for data in list(self.latest_sensor_data.values()))
+
     def format_sensor_data(self, data):
         risk_level = data['status']['landslideRisk']
         header = {
@@ -100,6 +104,7 @@ class TelegramBot:
         sensors = data['sensors']
         message = (
             f"{header}\n"
+            f"Perangkat: {data.get('deviceId', '-')}\n"
             f"Peringatan: {'Aktif' if data['status']['alertTriggered'] else 'Tidak Aktif'}\n"
             "________________\n"
             f"Intensitas Hujan: {sensors['rainfall']:.2f}%\n"
@@ -119,20 +124,21 @@ class TelegramBot:
         return message
 
     def handleChat(self, sensor_data):
-        # Store the latest sensor data
-        self.latest_sensor_data = sensor_data
+        # Store the latest sensor data per device
+        device_id = sensor_data.get('deviceId', '-')
+        self.latest_sensor_data[device_id] = sensor_data
         self.lastSubscriptionMillis = time.time()
         message = self.format_sensor_data(sensor_data)
         
         if sensor_data['status']['alertTriggered']:
-            if time.time() - self.lastTriggerMillis > 3:
-                self.lastTriggerMillis = time.time()
+            if time.time() - self.lastTriggerMillis.get(device_id, 0) > 3:
+                self.lastTriggerMillis[device_id] = time.time()
                 self.updater.bot.send_message(chat_id=CHAT_ID, text="⚠️ ALERT:\n" + message)
-                for chat_id in self.subscribed_users:
+                for chat_id in list(self.subscribed_users):
                     self.updater.bot.send_message(chat_id=chat_id, text="⚠️ ALERT:\n" + message)
         elif time.time() - self.lastSubscriptionMillis > 3:
-            self.lastTriggerMillis = time.time()
-            for chat_id in self.subscribed_users:
+            self.lastTriggerMillis[device_id] = time.time()
+            for chat_id in list(self.subscribed_users):
                 self.updater.bot.send_message(chat_id=chat_id, text="⚠️ ALERT:\n" + message)
 
     def start_polling(self):
@@ -2,7 +2,9 @@
 #pragma once
 void setupActuators();
 void setupLCD();
-void writeLCD(const String& message);
+void writeLCD(const char *message);
+// Backlight and display off before deep sleep
+void powerDownDisplay();
 void setupServo();
 void writeServo1(int angle);
 void writeServo2(int angle);
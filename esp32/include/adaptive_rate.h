@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include "runtime_config.h"
+#include "snapshot.h"
+
+// Risk-adaptive rate policy. The classifier picks a profile from the risk
+// level and the recent trend; the profile sets the sensor rate, the
+// vibration RMS window, the upload interval and whether the radio may
+// sleep. Escalation is immediate. Stepping down waits RATE_HOLD_MS after
+// the last time the stronger condition was seen, one profile at a time, so
+// a slope hovering near a threshold does not flap between rates.
+
+enum RateProfile : uint8_t {
+  RATE_FULL = 0,   // warning/danger (and unknown): full rate, lowest latency
+  RATE_WATCH,      // safe, but close to a threshold or trending towards one
+  RATE_SAFE,       // dry and still: slow and frugal
+  RATE_PROFILE_COUNT
+};
+// RATE_FULL is 0 so raw recordings and mesh frames without a profile read
+// as the original fixed full rate
+
+struct RatePolicy {
+  uint16_t sampleRateHz;      // sensor task
+  uint8_t vibrationWindow;    // samples in the vibration RMS window
+  uint32_t uploadIntervalMs;  // Firebase live upload, or leaf frames to the gateway
+  bool radioPowerSave;        // WiFi modem sleep between uploads (standalone nodes)
+};
+
+#define RATE_HOLD_MS 300000                 // 5 min before stepping down a profile
+#define RATE_WATCH_FRACTION 0.7f            // "close" = 70% of a warning threshold
+#define RATE_TREND_WINDOW_MS 60000          // trend measured over 1 min windows
+#define RATE_TILT_TREND_DEG_PER_MIN 0.5f
+#define RATE_MOISTURE_TREND_PCT_PER_MIN 2.0f
+
+const RatePolicy& ratePolicy(RateProfile profile);
+const char* rateProfileName(RateProfile profile);
+
+struct AdaptiveRate {
+  RateProfile profile;
+  uint32_t profileSinceMs;
+  uint32_t holdUntilMs;        // earliest time to step down
+  uint32_t transitions;
+  bool hasBaseline;            // trend start values taken
+  uint32_t trendStartMs;
+  float trendStartTilt;        // degrees
+  float trendStartMoisture;    // percent
+  float tiltTrend;             // degrees per minute over the last full window
+  float moistureTrend;         // percent per minute over the last full window
+};
+
+void adaptiveRateInit(AdaptiveRate &rate, uint32_t nowMs);
+// Feeds one classification; returns true when the profile changed
+bool adaptiveRateUpdate(AdaptiveRate &rate, const RiskThresholds &thresholds, RiskLevel level,
+                        const SensorSample &sample, uint32_t nowMs);
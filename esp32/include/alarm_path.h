@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include "runtime_config.h"
+#include "snapshot.h"
+
+// Decision and latency accounting for the alarm fast path (alarm_task.h).
+// Two inputs drive the buzzer and servos:
+//   - the fast path: every acquired sample is checked against the danger
+//     thresholds in the sensor task, and a hit turns the outputs on at once
+//     and holds them for ALARM_FAST_HOLD_MS after the last hit
+//   - the classifier in the loop, which also weighs trends and anomalies
+// The outputs are on while either asks for them, except in silent mode.
+
+#define ALARM_DEADLINE_US 10000      // acquisition to outputs written
+#define ALARM_FAST_HOLD_MS 3000      // long enough for the loop to catch up and take over
+#define ALARM_LATENCY_BUCKETS 8
+
+struct AlarmState {
+  bool loopRequest;                  // the classifier's decision
+  bool fastActive;
+  uint32_t fastUntilMs;
+  bool outputsOn;
+};
+
+// Latency histogram, bucket upper bounds in alarm_path.cpp (0.1 ms .. 10 ms, then over)
+struct AlarmLatency {
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint32_t deadlineMisses;
+  uint32_t buckets[ALARM_LATENCY_BUCKETS];
+};
+
+// Danger on the sample alone, with the same test the loop's classifier
+// starts with (riskDangerReading); never in silent mode
+bool alarmFastTrigger(const RuntimeConfig &config, const SensorSample &sample);
+
+void alarmStateInit(AlarmState &state);
+void alarmOnFastTrigger(AlarmState &state, uint32_t nowMs);
+void alarmOnLoopRequest(AlarmState &state, bool on);
+// Updates and returns state.outputsOn for `nowMs`
+bool alarmUpdateOutputs(AlarmState &state, DeviceMode mode, uint32_t nowMs);
+// Milliseconds until the fast hold runs out, or UINT32_MAX when it is not active
+uint32_t alarmHoldRemainingMs(const AlarmState &state, uint32_t nowMs);
+
+void alarmLatencyRecord(AlarmLatency &latency, uint32_t us);
+uint32_t alarmLatencyBucketLimitUs(int bucket);
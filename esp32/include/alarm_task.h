@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+#include "alarm_path.h"
+
+// High-priority task that owns the buzzer and servos (alarm_path.h). The
+// sensor task hands it danger detections directly, so the alarm does not
+// wait for the loop, the network, the LCD or logging. Latency from the
+// start of acquisition to the outputs being written is measured on every
+// fast-path activation and reported with the minute report.
+// The buzzer follows at once; the servos take the new angle at their next
+// 20 ms PWM frame.
+
+void startAlarmTask();
+// Sensor task, every sample. `acquiredUs` is esp_timer time at the start
+// of the acquisition that produced `sample`.
+void alarmCheckSample(const SensorSample &sample, uint32_t acquiredUs);
+// Loop classifier: its alarm decision, including mode and trends
+void requestAlarmOutputs(bool on);
+void printAlarmStats();
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+
+// Streaming anomaly detection, O(1) time and memory per sample and channel.
+// The fixed thresholds only fire once a reading reaches a hard limit; this
+// looks for change relative to the slope's own recent behaviour instead:
+//   - samples are averaged over ANOMALY_STEP_MS steps (the classifier runs
+//     at 20 Hz, but the analog channels only change at 10 Hz or less)
+//   - Welford mean/variance over the first ANOMALY_WARMUP_STEPS seeds the
+//     baseline, and keeps running as the long-run statistics
+//   - an EWMA mean and variance (time constant ANOMALY_BASELINE_STEPS) is
+//     the baseline each step is scored against, as z = (x - mean) / sigma
+//   - a one-sided CUSUM of z accumulates small, persistent rises that no
+//     single step would show; score = CUSUM / ANOMALY_CUSUM_H, >= 1 is an alarm
+// Only rises are scored: every channel (tilt, moisture, rain, vibration)
+// moves up as a slope gets closer to failing.
+
+enum AnomalyChannel : uint8_t {
+  ANOMALY_TILT = 0,      // degrees, larger axis
+  ANOMALY_MOISTURE,      // percent
+  ANOMALY_RAIN,          // percent
+  ANOMALY_VIBRATION,     // m/s^2 RMS
+  ANOMALY_CHANNEL_COUNT
+};
+
+#define ANOMALY_STEP_MS 1000
+#define ANOMALY_WARMUP_STEPS 120       // 2 min of Welford statistics before scoring
+#define ANOMALY_BASELINE_STEPS 1800    // EWMA time constant: 30 min
+#define ANOMALY_CUSUM_K 0.5f           // slack: drifts under half a sigma are ignored
+#define ANOMALY_CUSUM_H 10.0f          // alarm level
+#define ANOMALY_CUSUM_CAP 2.0f         // CUSUM held under CAP * H so an alarm clears soon after the cause
+
+struct ChannelStats {
+  uint32_t count;      // Welford, since init
+  float mean;
+  float m2;
+  float baseline;      // EWMA mean
+  float variance;      // EWMA variance around the baseline
+  float cusum;
+  float score;         // cusum / ANOMALY_CUSUM_H
+};
+
+struct AnomalyDetector {
+  ChannelStats channels[ANOMALY_CHANNEL_COUNT];
+  uint32_t stepStartMs;
+  uint16_t stepSamples;
+  float stepSums[ANOMALY_CHANNEL_COUNT];
+  uint8_t mask;        // bit per channel in alarm
+  uint32_t alarms;     // alarm onsets, all channels
+};
+
+void anomalyInit(AnomalyDetector &detector, uint32_t nowMs);
+// Feeds one classified sample; returns true when a step closed and the
+// scores were updated
+bool anomalyUpdate(AnomalyDetector &detector, const SensorSample &sample, uint32_t nowMs);
+float anomalyLongRunVariance(const ChannelStats &stats);
+// Copies the mask and scores into a classification
+void anomalyFillStatus(const AnomalyDetector &detector, RiskStatus &status);
+const char* anomalyChannelName(AnomalyChannel channel);
+// Anomalies alone never sound the alarm, but a creeping tilt, or soil and
+// rain rising together, raise a safe slope to warning
+RiskLevel anomalyRiskLevel(RiskLevel level, uint8_t mask);
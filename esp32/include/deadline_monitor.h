@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+
+// Soft deadline monitor for the loop stages and the tasks. Every watched
+// item has a time budget; each check feeds how long the item took (a stage
+// run) or how long it has been busy without finishing (a task cycle still
+// in progress). Misses are counted per item, and consecutive misses
+// escalate one step at a time: skip the next run, run less often, restart
+// the subsystem behind it, reboot. Each item only takes the steps it
+// allows; a hang that never returns is left to the hardware task watchdog
+// (health_monitor.h). A degraded item goes back to normal after
+// DEADLINE_RECOVER_CHECKS clean checks in a row.
+
+enum DeadlineAction : uint8_t {
+  DEADLINE_OK = 0,
+  DEADLINE_MISS,      // counted, nothing else to do
+  DEADLINE_SKIP,      // drop the item's next run
+  DEADLINE_DEGRADE,   // run it less often
+  DEADLINE_RESTART,   // restart the subsystem behind it
+  DEADLINE_REBOOT,
+  DEADLINE_RESTORE,   // recovered from a degrade: back to the normal rate
+  DEADLINE_ACTION_COUNT
+};
+
+#define DEADLINE_ALLOW(action) (1u << (action))
+#define DEADLINE_MAX_ITEMS 12
+// Consecutive misses at which each escalation is taken
+#define DEADLINE_SKIP_STREAK 2
+#define DEADLINE_DEGRADE_STREAK 4
+#define DEADLINE_RESTART_STREAK 8
+#define DEADLINE_REBOOT_STREAK 16
+#define DEADLINE_RECOVER_CHECKS 100
+
+struct DeadlineItem {
+  const char *name;
+  uint32_t budgetUs;
+  uint8_t allowed;            // DEADLINE_ALLOW() mask of escalations
+  bool degraded;
+  uint8_t worstAction;        // strongest escalation taken since boot
+  uint16_t streak;            // consecutive misses
+  uint16_t cleanChecks;       // consecutive checks within budget
+  uint32_t checks;
+  uint32_t misses;
+  uint32_t escalations;       // skip, degrade, restart and reboot actions taken
+  uint32_t worstUs;           // longest run or busy time seen
+};
+
+struct DeadlineMonitor {
+  DeadlineItem items[DEADLINE_MAX_ITEMS];
+  int count;
+  uint32_t misses;
+  int lastMiss;               // item that overran most recently, -1 for none
+  // Why the previous boot ended, and the item running when it did (-1 if
+  // unknown); filled in at boot by health_monitor
+  const char *resetReason;
+  int resetItem;
+};
+
+const char* deadlineActionName(DeadlineAction action);
+
+void deadlineInit(DeadlineMonitor &monitor);
+// Returns the item index, or -1 when the table is full
+int deadlineAdd(DeadlineMonitor &monitor, const char *name, uint32_t budgetUs, uint8_t allowed);
+// Feeds one observation and returns what the caller should do about it
+DeadlineAction deadlineCheck(DeadlineMonitor &monitor, int item, uint32_t elapsedUs);
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+#include "adaptive_rate.h"
+#include "runtime_config.h"
+#include "anomaly.h"
+
+// Deep-sleep duty cycling with ULP pre-screening (DEEP_SLEEP_ENABLED in
+// config.h, standalone nodes only). Policy and RTC state: sleep_state.h.
+
+bool deepSleepEnabled();
+// First thing in setup(): stops the ULP and, on a wake from deep sleep,
+// restores the risk status, the rate state and the anomaly statistics.
+// True on such a wake.
+bool resumeFromDeepSleep(AdaptiveRate &rate, AnomalyDetector &anomaly);
+// Access point used before sleeping, for a reconnect without a scan
+bool deepSleepWiFiHint(uint8_t &channel, uint8_t *bssid);
+void deepSleepUploadDone();
+// Goes to sleep, and does not return, when sleepAllowed() says so
+void deepSleepIfIdle(const RiskStatus &risk, const AdaptiveRate &rate, const AnomalyDetector &anomaly,
+                     const RiskThresholds &thresholds);
+void printDeepSleepStats();
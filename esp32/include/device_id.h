@@ -0,0 +1,8 @@
+#pragma once
+
+// Stable per-board identifier. Defaults to one derived from the factory
+// eFuse MAC; config.h may pin a readable name with DEVICE_ID.
+#define DEVICE_ID_MAX 32
+
+const char* getDeviceId();
+void setDeviceId(const char *id);
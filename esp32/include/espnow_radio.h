@@ -0,0 +1,20 @@
+#pragma once
+#include "mesh_radio.h"
+
+// ESP-NOW link. Frames arrive in the WiFi task; the receive callback only
+// copies them into a queue that poll() drains from the caller's task.
+
+#define ESPNOW_RX_QUEUE_LENGTH 16
+
+class EspNowRadio : public MeshRadio {
+public:
+  explicit EspNowRadio(uint8_t channel);
+  bool begin() override;
+  bool addPeer(const uint8_t *mac) override;
+  bool send(const uint8_t *mac, const uint8_t *data, size_t len) override;
+  int poll(MeshReceiveHandler handler, void *context) override;
+  uint32_t rxDropped() const;
+
+private:
+  uint8_t channel;
+};
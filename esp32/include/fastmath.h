@@ -0,0 +1,74 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// Single-precision approximations for the tilt and magnitude paths.
+// The ESP32 FPU only handles float; libm atan2/sqrt on doubles (and the
+// implicit promotions in `x * 180.0 / PI`) fall back to software emulation.
+//
+// Error bounds against double-precision libm:
+//   fastAtan2   |err| <= 2e-6 rad (~0.0001 deg), all quadrants
+//   fastInvSqrt relative err <= 5e-6 over 1e-30..1e30 (two Newton steps)
+//   fastSqrt    relative err <= 5e-6, returns 0 for x <= 0
+
+#define FM_PI 3.14159265f
+#define FM_HALF_PI 1.57079633f
+#define FM_RAD_TO_DEG 57.2957795f
+#define FM_DEG_TO_RAD 0.0174532925f
+
+static inline float radToDeg(float rad) {
+  return rad * FM_RAD_TO_DEG;
+}
+
+static inline float degToRad(float deg) {
+  return deg * FM_DEG_TO_RAD;
+}
+
+static inline float fastAbs(float x) {
+  return x < 0 ? -x : x;
+}
+
+static inline float fastMaxAbs(float a, float b) {
+  a = fastAbs(a);
+  b = fastAbs(b);
+  return a > b ? a : b;
+}
+
+// Minimax polynomial for atan(z) on [-1, 1]
+static inline float fastAtanUnit(float z) {
+  float z2 = z * z;
+  return z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f +
+         z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+static inline float fastAtan2(float y, float x) {
+  float ax = fastAbs(x);
+  float ay = fastAbs(y);
+  if (ax == 0 && ay == 0) return 0;
+
+  float angle;
+  if (ay <= ax) {
+    angle = fastAtanUnit(ay / ax);
+  } else {
+    angle = FM_HALF_PI - fastAtanUnit(ax / ay);
+  }
+  if (x < 0) angle = FM_PI - angle;
+  return y < 0 ? -angle : angle;
+}
+
+static inline float fastInvSqrt(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  bits = 0x5f375a86 - (bits >> 1);
+  float y;
+  memcpy(&y, &bits, sizeof(y));
+  float halfX = 0.5f * x;
+  y = y * (1.5f - halfX * y * y);
+  y = y * (1.5f - halfX * y * y);
+  return y;
+}
+
+static inline float fastSqrt(float x) {
+  if (x <= 0) return 0;
+  return x * fastInvSqrt(x);
+}
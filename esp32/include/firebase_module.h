@@ -1,6 +1,12 @@
 #pragma once
 #include <FirebaseESP32.h>
-#include <Adafruit_Sensor.h> // Include the header defining sensors_event_t
+#include "snapshot.h"
+#include "uplink.h"
+
+// Firebase RTDB uplink (UPLINK_FIREBASE)
 void setupFirebase();
-void sendDataToFirebase(sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp, float angleX, float angleY, float soilMoistureValue, float rainValue, String riskLevel, bool alertTrigger);
+// Bytes of the live document, or -1 when it was not written
+int sendDataToFirebase(const LatestSnapshot &snapshot);
+void sendMeshBatchToFirebase(const MeshUpload *uploads, int count);
+void sendDiagnosticsToFirebase(const HeapReport &report, const DeadlineMonitor &deadlines);
 extern FirebaseData firebaseData;
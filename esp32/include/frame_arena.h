@@ -0,0 +1,89 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump-pointer scratch memory for text that only lives for one loop or task
+// cycle (status lines, Telegram replies, JSON bodies). Allocation is a
+// pointer increment and everything is released at once by arenaReset() at
+// the end of the cycle, so transient buffers never touch the general heap.
+// An arena belongs to a single task; none of this is thread safe.
+
+#define ARENA_ALIGN 4
+#define ARENA_STRING_RESERVE 64   // first chunk of a string; it doubles from there
+#define ARENA_JSON_MAX_DEPTH 8
+
+struct FrameArena {
+  uint8_t *base;
+  size_t capacity;
+  size_t used;
+  size_t peak;          // high-water mark since arenaInit
+  uint32_t overflows;   // allocations refused because the arena was full
+};
+
+void arenaInit(FrameArena &arena, void *buffer, size_t capacity);
+// Returns NULL (and counts an overflow) when the arena is full
+void *arenaAlloc(FrameArena &arena, size_t size);
+// Grows the most recent allocation in place; false if it is not on top or
+// does not fit
+bool arenaExtend(FrameArena &arena, void *block, size_t oldSize, size_t newSize);
+// Marks let a loop hand back what one iteration used before the next one
+size_t arenaMark(const FrameArena &arena);
+void arenaRelease(FrameArena &arena, size_t mark);
+void arenaReset(FrameArena &arena);
+
+// Append-only string in an arena. When the arena runs out the text is cut
+// at what fits, stays NUL terminated, and truncated() reports it.
+class ArenaString {
+public:
+  explicit ArenaString(FrameArena &arena, size_t reserve = ARENA_STRING_RESERVE);
+
+  ArenaString &operator+=(const char *text);
+  ArenaString &operator+=(char c);
+  ArenaString &append(const char *text, size_t len);
+  ArenaString &appendf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+  const char *c_str() const { return buffer; }
+  size_t length() const { return len; }
+  bool truncated() const { return cut; }
+
+private:
+  bool grow(size_t needed);
+
+  FrameArena *arena;
+  char *buffer;
+  size_t len;
+  size_t capacity;
+  bool cut;
+};
+
+// Compact JSON writer on top of ArenaString. Keys and string values are
+// escaped; NaN and infinite numbers are written as 0 like the telemetry
+// formatter does.
+class ArenaJson {
+public:
+  explicit ArenaJson(FrameArena &arena, size_t reserve = ARENA_STRING_RESERVE);
+
+  ArenaJson &beginObject(const char *key = NULL);
+  ArenaJson &endObject();
+  ArenaJson &addString(const char *key, const char *value);
+  ArenaJson &addInt(const char *key, long value);
+  ArenaJson &addUInt(const char *key, unsigned long value);
+  ArenaJson &addFloat(const char *key, float value, int decimals = 2);
+  ArenaJson &addBool(const char *key, bool value);
+  // Inserts an already formatted JSON value as is
+  ArenaJson &addRaw(const char *key, const char *json);
+
+  const char *c_str() const { return text.c_str(); }
+  size_t length() const { return text.length(); }
+  // Also true while objects are still open
+  bool truncated() const { return text.truncated() || tooDeep || depth != 0; }
+
+private:
+  void writeKey(const char *key);
+  void writeEscaped(const char *value);
+
+  ArenaString text;
+  uint8_t depth;
+  uint8_t hasMembers;   // bit per open object: a comma goes before the next member
+  bool tooDeep;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+// Complementary filter that fuses gyro rate with accelerometer tilt.
+// Gyro integration runs every sample; the accelerometer correction (the only
+// step that needs trig) runs once every `accelDecimation` samples.
+struct TiltFusion {
+  float angleX;          // degrees, same sign convention as atan2(ax, |ayz|)
+  float angleY;          // degrees, same sign convention as atan2(ay, |axz|)
+  float dt;              // sample period in seconds
+  float accelGain;       // weight of the accelerometer angle per correction
+  int accelDecimation;
+  int sampleCount;
+  bool initialized;
+};
+
+void fusionInit(TiltFusion &fusion, float dt, float timeConstant, int accelDecimation);
+// Changes the sample period and keeps the current angles
+void fusionSetRate(TiltFusion &fusion, float dt, float timeConstant);
+void fusionReset(TiltFusion &fusion);
+void fusionUpdate(TiltFusion &fusion, float ax, float ay, float az, float gx, float gy);
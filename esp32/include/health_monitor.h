@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "deadline_monitor.h"
+#include "loop_scheduler.h"
+
+// Hang and overrun protection. The loop task and the long-lived tasks are
+// registered with the ESP32 task watchdog, which reboots the node when one
+// of them stops checking in for WATCHDOG_TIMEOUT_S (a hung HTTPS call, an
+// I2C lockup). What was running at that moment is kept in RTC memory and
+// reported after the reboot. On top of it, the soft deadline monitor
+// (deadline_monitor.h) times every loop stage run and every task cycle,
+// counts misses and escalates as far as each item allows. The counters go
+// out with the diagnostics document.
+
+#define WATCHDOG_TIMEOUT_S 30          // above the slowest legitimate blocking call (TLS handshake)
+#define WATCHDOG_IDLE_WAKE_MS 10000    // longest a watched task may block waiting for work
+#define HEALTH_TASK_CHECK_MS 1000      // task cycles are checked once a second
+
+enum HealthTask : uint8_t {
+  HEALTH_TASK_SENSORS,
+  HEALTH_TASK_ALARM,
+  HEALTH_TASK_RECORDER,
+  HEALTH_TASK_TELEGRAM,
+  HEALTH_TASK_COUNT
+};
+
+// Early in setup(): reads why the last boot ended and sets up the watchdog
+void setupHealthMonitor();
+// Soft budget for one run of a stage, the escalations it allows and what
+// DEADLINE_RESTART does for it (NULL for nothing)
+void healthWatchStage(LoopScheduler &scheduler, int stage, uint32_t budgetUs, uint8_t allowed,
+                      void (*restart)());
+// Last in setup(): puts the loop task under the watchdog and times the
+// stages of `scheduler` from then on
+void startHealthMonitor(LoopScheduler &scheduler);
+
+// From inside a task, once before its loop: the task is watched from then on
+void healthTaskStart(HealthTask task);
+// Around the work of one cycle; time spent blocked waiting for work is not
+// counted. Both feed the watchdog.
+void healthTaskBusy(HealthTask task);
+void healthTaskIdle(HealthTask task);
+
+const DeadlineMonitor& healthDeadlines();
+void printHealthStats();
@@ -0,0 +1,41 @@
+#pragma once
+#include "heap_stats.h"
+#include "frame_arena.h"
+
+// Heap instrumentation. Each task carries a subsystem tag (heapTagTask for
+// a task's whole life, HeapScope for a section of code). With
+// HEAP_TRACK_ALLOCATIONS (the heapdiag env in platformio.ini),
+// malloc/calloc/realloc/free are wrapped at link time, which reaches every
+// caller in the image: the firmware, the precompiled IDF, lwIP and mbedTLS
+// libraries and libstdc++'s operator new. Each allocation is counted against
+// the tag of the task making it. Only direct heap_caps_* calls bypass it.
+
+#define HEAP_MAX_TAGGED_TASKS 8
+
+void heapTagTask(HeapSubsystem subsystem);
+
+// Tags the calling task for the lifetime of the object and adds the net
+// free-heap change across it to the subsystem's scopeDelta. Other tasks
+// allocate meanwhile too, so read scopeDelta as a trend, not exact bytes.
+class HeapScope {
+public:
+  explicit HeapScope(HeapSubsystem subsystem);
+  ~HeapScope();
+
+private:
+  HeapSubsystem subsystem;
+  HeapSubsystem previous;
+  uint32_t freeAtStart;
+};
+
+// Scratch arenas for text that lives for one cycle. loopArena belongs to
+// loop() and is reset at the end of every iteration; telegramArena belongs
+// to the Telegram task and is reset after each of its cycles.
+#define LOOP_ARENA_BYTES 8192
+#define TELEGRAM_ARENA_BYTES 4096
+
+extern FrameArena loopArena;
+extern FrameArena telegramArena;
+
+void heapCollect(HeapReport &report);
+void printHeapReport(const HeapReport &report);
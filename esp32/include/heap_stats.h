@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+// Heap health report: whole-heap figures plus allocation counts attributed
+// to the subsystem that made them (see heap_monitor.h for how they are
+// collected). Pure data so it can be formatted and tested on the host.
+
+enum HeapSubsystem : uint8_t {
+  HEAP_SYSTEM,     // untagged tasks and framework code
+  HEAP_SENSORS,
+  HEAP_LOGIC,
+  HEAP_DISPLAY,
+  HEAP_FIREBASE,
+  HEAP_TELEGRAM,
+  HEAP_CONFIG,
+  HEAP_MESH,
+  HEAP_SUBSYSTEM_COUNT
+};
+
+struct HeapSubsystemStats {
+  uint32_t allocs;      // malloc/calloc/realloc/new calls made while tagged
+  uint32_t allocBytes;
+  uint32_t frees;
+  uint32_t freeBytes;
+  uint32_t scopes;      // HeapScope entries
+  int32_t scopeDelta;   // sum of free-heap change across scopes; negative = retained
+};
+
+// Per-task scratch arenas (frame_arena.h), reported alongside the heap
+enum HeapArena : uint8_t {
+  ARENA_LOOP,
+  ARENA_TELEGRAM,
+  HEAP_ARENA_COUNT
+};
+
+struct HeapArenaStats {
+  uint32_t capacity;
+  uint32_t peak;        // most bytes used in one cycle
+  uint32_t overflows;   // requests cut short because the arena was full
+};
+
+struct HeapReport {
+  uint32_t uptimeS;
+  uint32_t freeBytes;
+  uint32_t minFreeBytes;      // lowest free heap since boot
+  uint32_t largestFreeBlock;
+  bool allocTracking;         // per-subsystem alloc counts available
+  HeapSubsystemStats subsystems[HEAP_SUBSYSTEM_COUNT];
+  HeapArenaStats arenas[HEAP_ARENA_COUNT];
+};
+
+const char* heapSubsystemName(HeapSubsystem subsystem);
+const char* heapArenaName(HeapArena arena);
+// Share of free heap not usable for the largest allocation, 0..100
+uint8_t heapFragmentationPct(uint32_t freeBytes, uint32_t largestFreeBlock);
@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+
+// On-device history in a fixed memory budget. Samples are folded into
+// 1 s buckets, 1 s buckets into 1 min buckets and those into 1 h buckets,
+// each level a ring of min/max/mean per channel:
+//   seconds  HISTORY_SECONDS  (2 min)
+//   minutes  HISTORY_MINUTES  (2 h)
+//   hours    HISTORY_HOURS    (3 days)
+// 312 buckets of 52 bytes, about 16 KB. The trend estimators run on the
+// closed buckets:
+//   - creep: least-squares slope of the 1 min tilt means over the last
+//     HISTORY_RATE_WINDOW minutes, refitted once a minute, in deg/h
+//   - moisture rate: the same fit on soil moisture, in %/h
+//   - rain event: wetness-hours (rain fraction x hours) since rain began;
+//     the event ends after HISTORY_RAIN_DRY_MS without rain
+//   - rain 24 h: wetness-hours over the last 24 completed hours
+// Times are millis() and may wrap.
+
+enum HistoryChannel : uint8_t {
+  HISTORY_TILT = 0,      // degrees, larger axis
+  HISTORY_MOISTURE,      // percent
+  HISTORY_RAIN,          // percent
+  HISTORY_VIBRATION,     // m/s^2 RMS
+  HISTORY_CHANNEL_COUNT
+};
+
+enum HistoryLevel : uint8_t {
+  HISTORY_LEVEL_SECONDS = 0,
+  HISTORY_LEVEL_MINUTES,
+  HISTORY_LEVEL_HOURS,
+  HISTORY_LEVEL_COUNT
+};
+
+#define HISTORY_SECONDS 120
+#define HISTORY_MINUTES 120
+#define HISTORY_HOURS 72
+#define HISTORY_RATE_WINDOW 30           // minutes in the creep and moisture fits
+#define HISTORY_RATE_MIN_POINTS 10       // fewer and the rates are not reported
+#define HISTORY_RAIN_WET 5.0f            // percent; rain below this is dry
+#define HISTORY_RAIN_DRY_MS (6UL * 3600000UL)
+#define HISTORY_RAIN_EVENT_MAX_H 9999.0f // saturates instead of growing without bound
+
+struct HistoryAggregate {
+  float min;
+  float max;
+  float mean;
+};
+
+struct HistoryBucket {
+  uint32_t startMs;
+  HistoryAggregate channels[HISTORY_CHANNEL_COUNT];
+};
+
+// Bucket being filled
+struct HistoryPartial {
+  uint32_t startMs;
+  uint32_t samples;
+  float min[HISTORY_CHANNEL_COUNT];
+  float max[HISTORY_CHANNEL_COUNT];
+  float sum[HISTORY_CHANNEL_COUNT];
+};
+
+struct HistoryRing {
+  uint16_t offset;     // first bucket in SensorHistory::buckets
+  uint16_t capacity;
+  uint16_t head;       // next write
+  uint16_t count;
+  HistoryPartial partial;
+};
+
+// Least-squares line through the last points, x = 0 for the oldest and
+// y relative to it
+struct SlopeWindow {
+  uint16_t n;
+  float sumX, sumY, sumXY, sumXX;
+};
+
+struct SensorHistory {
+  HistoryBucket buckets[HISTORY_SECONDS + HISTORY_MINUTES + HISTORY_HOURS];
+  HistoryRing rings[HISTORY_LEVEL_COUNT];
+  SlopeWindow tiltFit;
+  SlopeWindow moistureFit;
+  bool raining;
+  uint32_t lastWetMs;
+  float rainEventHours;
+  float rain24hHours;
+};
+
+void historyInit(SensorHistory &history);
+void historyAdd(SensorHistory &history, const SensorSample &sample, uint32_t nowMs);
+uint16_t historyCount(const SensorHistory &history, HistoryLevel level);
+// Closed bucket `age` back (0 = newest); NULL past the end
+const HistoryBucket* historyAt(const SensorHistory &history, HistoryLevel level, uint16_t age);
+void historyFeatures(const SensorHistory &history, TrendFeatures &features);
+const char* historyChannelName(HistoryChannel channel);
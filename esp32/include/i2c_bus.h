@@ -0,0 +1,67 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared I2C bus: the MPU6050 and the LCD backpack. One task owns Wire and
+// runs queued transactions; sensor transactions always go before display
+// ones, and display writes are queued without the caller waiting. LCD rows
+// are queued in chunks of I2C_ASYNC_MAX_BYTES, so a sensor read waits for
+// at most one chunk already on the wire, never a whole display update. The
+// ESP-IDF driver under Wire is interrupt driven: while a transfer is in
+// flight the bus task is blocked and the CPU runs other tasks.
+// The bus runs at 400 kHz fast mode for the MPU6050. The PCF8574 backpack
+// is only rated for 100 kHz, so its transactions (and those of unknown
+// devices) drop the clock for their duration.
+// Code that still talks to Wire directly (driver setup, the bus scan)
+// holds an I2cBusLock meanwhile.
+
+#define I2C_BUS_CLOCK_HZ 400000
+#define I2C_SLOW_CLOCK_HZ 100000
+#define I2C_ASYNC_MAX_BYTES 12          // one queued write: two LCD characters
+#define I2C_MAX_READ_BYTES 32
+#define I2C_SENSOR_QUEUE_LENGTH 4
+#define I2C_DISPLAY_QUEUE_LENGTH 24     // two full LCD rows of 9 chunks each
+
+enum I2cDevice : uint8_t {
+  I2C_DEVICE_MPU6050,
+  I2C_DEVICE_LCD,
+  I2C_DEVICE_OTHER,
+  I2C_DEVICE_COUNT
+};
+
+// Called from the bus task when a transaction has finished
+typedef void (*I2cDone)(bool ok, void *arg);
+
+// Before anything else uses the bus
+void setupI2cBus();
+// Sensor priority: writes `tx` (at most I2C_ASYNC_MAX_BYTES, copied), then
+// reads `rxLen` bytes (at most I2C_MAX_READ_BYTES) into `rx` after a
+// repeated start. `rx` must stay valid until `done` runs. Returns false if
+// the queue is full.
+bool i2cTransferAsync(I2cDevice device, uint8_t address, const uint8_t *tx, size_t txLen,
+                      uint8_t *rx, size_t rxLen, I2cDone done, void *arg);
+// The same, waiting for the result; blocks the calling task, not the CPU
+bool i2cTransfer(I2cDevice device, uint8_t address, const uint8_t *tx, size_t txLen,
+                 uint8_t *rx, size_t rxLen);
+// Display priority: `data` is copied in I2C_ASYNC_MAX_BYTES chunks and
+// written in order. Waits up to `waitMs` for queue room; false if the
+// whole write could not be queued.
+bool i2cWriteQueued(I2cDevice device, uint8_t address, const uint8_t *data, size_t len, uint32_t waitMs);
+// Waits up to `waitMs` for the queued display writes to go out, before
+// code that talks to the same device under an I2cBusLock
+void i2cWaitQueued(uint32_t waitMs);
+// Re-initialises the bus after a glitch (waits for the transaction in flight)
+void i2cBusReset();
+
+// Exclusive use of Wire for code outside the bus task
+class I2cBusLock {
+public:
+  explicit I2cBusLock(I2cDevice device);
+  ~I2cBusLock();
+
+private:
+  I2cDevice device;
+  uint32_t startUs;
+};
+
+void printI2cBusStats();
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+// Text layout for the 16x2 character LCD. writeLCD() renders into a frame
+// and only sends the rows that differ from what is already on the display,
+// instead of clearing and reprinting on every call. A changed row is sent
+// as one PCF8574 byte stream (lcdEncodeRow) queued on the I2C bus, instead
+// of one bus transaction per expander write.
+
+#define LCD_COLS 16
+#define LCD_ROWS 2
+
+struct LcdFrame {
+  char rows[LCD_ROWS][LCD_COLS + 1];  // space padded, NUL terminated
+};
+
+// '\n' starts the next row; text past the last column or row is cut off
+void lcdRender(const char *text, LcdFrame &frame);
+// Bit i set when row i differs between the two frames
+uint8_t lcdChangedRows(const LcdFrame &shown, const LcdFrame &next);
+
+// PCF8574 backpack wiring: P0 RS, P1 RW, P2 E, P3 backlight, P4-P7 D4-D7.
+// Every HD44780 byte goes out as two nibbles, each latched by an enable
+// pulse (3 expander writes), so 6 bytes on the bus. Even at 400 kHz the
+// next byte's pulse comes more than the 37 us the controller needs later.
+#define LCD_EXPANDER_RS 0x01
+#define LCD_EXPANDER_EN 0x04
+#define LCD_EXPANDER_BACKLIGHT 0x08
+#define LCD_EXPANDER_BYTES_PER_CHAR 6
+#define LCD_ROW_STREAM_BYTES (LCD_EXPANDER_BYTES_PER_CHAR * (LCD_COLS + 1))
+
+// Expander bytes that move the cursor to the start of `row` and write the
+// LCD_COLS characters of `text`; returns the length (LCD_ROW_STREAM_BYTES)
+int lcdEncodeRow(uint8_t row, const char *text, bool backlight, uint8_t *out);
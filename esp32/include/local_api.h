@@ -0,0 +1,79 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "snapshot.h"
+#include "history.h"
+
+// Wire formats of the on-device HTTP/WebSocket server (local_server.h).
+//
+// Live stream: one WebSocket binary message per batch of samples, little
+// endian. Fixed point with the mesh frame's scales (mesh_frame.h), and the
+// sequence and time as deltas from the previous sample:
+//   LiveFrameHeader | LiveSampleRecord x count
+//
+// History: a JSON array of closed buckets, oldest first, written by
+// historyStreamFill() straight into the buffer the server sends from:
+//   [{"t":<startMs>,"tilt":[min,mean,max],"moisture":[...],"rain":[...],"vibration":[...]},...]
+
+#define LIVE_FRAME_MAGIC 0x56  // 'V'
+#define LIVE_FRAME_VERSION 1
+#define LIVE_FRAME_MAX_SAMPLES 25
+
+struct __attribute__((packed)) LiveFrameHeader {
+  uint8_t magic;
+  uint8_t version;
+  uint8_t count;
+  uint8_t reserved;
+  uint32_t sequence;        // of the sample before the first record
+  uint32_t timestampMs;     // of the sample before the first record
+};
+
+struct __attribute__((packed)) LiveSampleRecord {
+  uint16_t sequenceDelta;   // saturates; a gap means samples the stream dropped
+  uint16_t timeDeltaMs;     // saturates
+  int16_t accel[3];         // m/s^2 * 100
+  int16_t gyro[3];          // rad/s * 1000
+  int16_t temperature;      // C * 100
+  int16_t angleX, angleY;   // degrees * 100
+  int16_t vibrationRMS;     // m/s^2 * 1000
+  uint16_t rain;            // 0..10000, 0.01% steps
+  uint16_t soilMoisture;    // 0..10000, 0.01% steps
+};
+
+#define LIVE_FRAME_MAX_BYTES (sizeof(LiveFrameHeader) + LIVE_FRAME_MAX_SAMPLES * sizeof(LiveSampleRecord))
+
+struct LiveFrameWriter {
+  uint8_t *out;             // LIVE_FRAME_MAX_BYTES
+  uint8_t count;
+  bool hasPrevious;         // the deltas continue across frames
+  uint32_t sequence;
+  uint32_t timestampMs;
+};
+
+void liveFrameInit(LiveFrameWriter &writer, uint8_t *out);
+// False when the frame is full; finish it and add the sample to the next one
+bool liveFrameAdd(LiveFrameWriter &writer, const SensorSample &sample);
+// Returns the frame length (0 when empty) and starts the next frame
+size_t liveFrameFinish(LiveFrameWriter &writer);
+// Returns the samples decoded into `samples`, or -1 for a malformed frame
+int liveFrameDecode(const uint8_t *data, size_t len, SensorSample *samples, int maxSamples);
+
+// Copies the closed bucket `age` back (0 = newest) and the level's bucket
+// count in one consistent read; false past the end. The server's
+// implementation takes the lock the history writer holds.
+typedef bool (*HistoryBucketReader)(HistoryLevel level, uint16_t age, HistoryBucket &bucket, uint16_t &count);
+
+struct HistoryStream {
+  HistoryLevel level;
+  uint8_t phase;            // open bracket, buckets, close bracket, done
+  bool any;                 // a bucket has been written
+  uint32_t lastStartMs;     // newest bucket written; buckets closed meanwhile still follow
+  uint16_t lastAge;         // its age when it was read
+};
+
+void historyStreamInit(HistoryStream &stream, HistoryLevel level);
+// Fills `out` with whole buckets; returns the bytes written, 0 once the
+// array is complete
+size_t historyStreamFill(HistoryStream &stream, HistoryBucketReader reader, char *out, size_t size);
+// "seconds", "minutes" or "hours"; false for anything else
+bool historyLevelFromName(const char *name, HistoryLevel &level);
@@ -0,0 +1,27 @@
+#pragma once
+#include "snapshot.h"
+#include "local_api.h"
+
+// On-device HTTP/WebSocket server for technicians on the node's network
+// (LOCAL_SERVER_ENABLED in config.h; not on mesh leaves, which have no WiFi):
+//   GET /api/state                        latest sample and risk status, telemetry JSON
+//   GET /api/history?level=seconds|minutes|hours
+//                                         closed history buckets, chunked (local_api.h)
+//   WS  /ws/live                          every sample at the acquisition rate, in binary
+//                                         frames (local_api.h)
+// The server runs in the async TCP task. The sensor task only offers its
+// samples to a queue, without waiting; a stream task batches them into
+// frames, so a slow client loses samples instead of holding anything up.
+
+#define LOCAL_SERVER_PORT 80
+#define LIVE_QUEUE_LENGTH 50     // 0.5 s at 100 Hz
+#define LIVE_FLUSH_MS 100        // a partial frame is sent after this long
+
+bool localServerEnabled();
+// After WiFi is up; `reader` gives the server its view of the history
+void setupLocalServer(HistoryBucketReader reader);
+// Called by the sensor task; never blocks
+void liveStreamSample(const SensorSample &sample);
+// A technician is watching; deep sleep waits
+bool localClientsConnected();
+void printLocalServerStats();
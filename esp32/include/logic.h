@@ -1,7 +1,9 @@
 #include <Arduino.h>
 #pragma once
+#include "snapshot.h"
 
-String getSoilCondition(float soilMoistureValue);
-String getVibrationStatus(float vibrationRMS);
-void determineRiskLevel(float angleX, float angleY, float soilMoistureValue, float rainValue, 
-                       String &riskLevel, bool &alertTrigger);
\ No newline at end of file
+const char* getSoilCondition(float soilMoistureValue);
+const char* getVibrationStatus(float vibrationRMS);
+void determineRiskLevel(float angleX, float angleY, float soilMoistureValue, float rainValue,
+                       float vibrationRMS, const TrendFeatures &trend, RiskLevel &riskLevel, bool &alertTrigger);
+void displayRiskStatus(const LatestSnapshot &snapshot);
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+
+// Cooperative multi-rate scheduler for loop(). Every stage has its own
+// period and deadline; schedulerRunDue() runs the stages that are due,
+// earliest deadline first, and tells the caller how long it may sleep.
+// Deadlines stay on a fixed grid (next = previous + period), so a late run
+// does not push later runs back. A stage a whole period or more behind
+// drops the missed deadlines instead of running back to back to catch up.
+// Times are in microseconds from the supplied clock and may wrap.
+
+#define SCHED_MAX_STAGES 8
+
+typedef uint32_t (*SchedulerClock)();
+typedef void (*StageRun)();
+// Called around every stage run (deadline monitor); `runUs` is 0 before it
+typedef void (*StageHook)(int stage, uint32_t runUs);
+
+struct StageStats {
+  uint32_t runs;
+  uint32_t overruns;         // runs that took longer than the stage period
+  uint32_t skipped;          // deadlines dropped because the stage fell a period behind
+  uint32_t shed;             // runs dropped on request (schedulerSkipNext)
+  uint32_t maxLatenessUs;    // start time minus deadline (release jitter)
+  uint64_t totalLatenessUs;
+  uint32_t maxRunUs;
+  uint64_t totalRunUs;
+};
+
+struct SchedulerStage {
+  const char *name;
+  StageRun run;
+  uint32_t periodUs;
+  uint32_t nextDueUs;
+  uint8_t degradeShift;      // runs every periodUs << degradeShift
+  bool skipNext;
+  StageStats stats;
+};
+
+struct LoopScheduler {
+  SchedulerClock clock;
+  SchedulerStage stages[SCHED_MAX_STAGES];
+  int stageCount;
+  uint32_t windowStartUs;    // start of the current statistics window
+  uint64_t busyUs;           // time spent in stages during the window
+  int runningStage;          // -1 between stages
+  StageHook beforeStage;
+  StageHook afterStage;
+};
+
+void schedulerInit(LoopScheduler &scheduler, SchedulerClock clock);
+// First run is `offsetUs` from now; offsets keep stages with related
+// periods from all landing on the same iteration. Returns the stage index
+// or -1 when the table is full.
+int schedulerAddStage(LoopScheduler &scheduler, const char *name, StageRun run,
+                      uint32_t periodUs, uint32_t offsetUs);
+// Changes a stage's period from its next deadline on; a shorter period
+// also pulls that deadline in so a faster rate takes effect at once
+void schedulerSetPeriod(LoopScheduler &scheduler, int stage, uint32_t periodUs);
+// Slows a stage to 1/2^shift of its period (0 restores it); unlike
+// schedulerSetPeriod this survives later period changes
+void schedulerSetDegrade(LoopScheduler &scheduler, int stage, uint8_t shift);
+// Drops the stage's next run; its deadline moves on as if it had run
+void schedulerSkipNext(LoopScheduler &scheduler, int stage);
+void schedulerSetHooks(LoopScheduler &scheduler, StageHook before, StageHook after);
+// Runs every due stage and returns the time until the next deadline
+uint32_t schedulerRunDue(LoopScheduler &scheduler);
+
+// Share of the window not spent in stages, 0..100
+uint8_t schedulerIdlePct(const LoopScheduler &scheduler, uint32_t nowUs);
+// Clears the stage statistics and starts a new window
+void schedulerResetStats(LoopScheduler &scheduler, uint32_t nowUs);
@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "snapshot.h"
+
+// Compact over-the-air sample for the ESP-NOW mesh (31 bytes, little endian).
+// Fixed-point fields keep the frame far below the 250-byte ESP-NOW payload.
+
+#define MESH_FRAME_MAGIC 0x4C  // 'L'
+#define MESH_FRAME_VERSION 2  // 2: rate profile in the risk byte
+
+struct __attribute__((packed)) MeshSampleFrame {
+  uint8_t magic;
+  uint8_t version;
+  uint16_t sequence;       // per-leaf, wraps
+  uint32_t uptimeMs;       // leaf millis() at acquisition
+  int16_t accel[3];        // m/s^2 * 100
+  int16_t gyro[3];         // rad/s * 1000
+  int16_t temperature;     // C * 100
+  int16_t angleX, angleY;  // degrees * 100
+  int16_t vibrationRMS;    // m/s^2 * 1000
+  uint8_t rain;            // 0..200, 0.5% steps
+  uint8_t soilMoisture;    // 0..200, 0.5% steps
+  uint8_t risk;            // RiskLevel in bits 0-3, rate profile in bits 4-5, alert flag in bit 7
+};
+
+void encodeMeshFrame(const SensorSample &sample, const RiskStatus &risk, uint16_t sequence,
+                     MeshSampleFrame &frame);
+bool decodeMeshFrame(const uint8_t *data, size_t len, MeshSampleFrame &frame,
+                     SensorSample &sample, RiskStatus &risk);
@@ -0,0 +1,53 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "mesh_radio.h"
+#include "snapshot.h"
+
+// Gateway-side aggregation of leaf frames: per-node bookkeeping (loss,
+// duplicates, late frames, reboots), mapping of leaf clocks onto the gateway clock, and
+// batching so one upload carries many samples. Pure logic, no hardware.
+
+#define MESH_MAX_NODES 16
+#define MESH_BATCH_MAX 32
+#define MESH_BATCH_INTERVAL_MS 1000  // flush at least this often
+// A frame behind the last one on both sequence and uptime by no more than
+// this arrived late (radio retries, reordering); further back the leaf
+// rebooted. Leaves take longer than this to boot and send.
+#define MESH_REORDER_WINDOW_MS 2000
+
+struct MeshNodeState {
+  bool active;
+  uint8_t mac[MESH_MAC_LEN];
+  uint16_t lastSequence;
+  uint32_t lastUptimeMs;
+  int64_t clockOffsetMs;   // gateway time - leaf uptime, smallest seen
+  uint32_t lastSeenMs;     // gateway time of the latest frame
+  uint32_t received;
+  uint32_t lost;           // sequence gaps
+  uint32_t duplicates;
+  uint32_t late;           // older than the latest frame; dropped, already counted lost
+  uint32_t reboots;
+};
+
+struct MeshBatchEntry {
+  uint8_t node;            // index into MeshGateway::nodes
+  uint32_t gatewayTimeMs;  // acquisition time on the gateway clock
+  SensorSample sample;
+  RiskStatus risk;
+};
+
+struct MeshGateway {
+  MeshNodeState nodes[MESH_MAX_NODES];
+  MeshBatchEntry batch[MESH_BATCH_MAX];
+  int batchCount;
+  uint32_t batchStartMs;
+  uint32_t rejectedFrames;  // malformed or from a node beyond MESH_MAX_NODES
+  uint32_t overflowDrops;   // samples lost because the batch was full
+};
+
+void gatewayInit(MeshGateway &gateway);
+bool gatewayReceive(MeshGateway &gateway, const uint8_t *mac, const uint8_t *data, size_t len, uint32_t nowMs);
+bool gatewayBatchReady(const MeshGateway &gateway, uint32_t nowMs);
+int gatewayTakeBatch(MeshGateway &gateway, MeshBatchEntry *out, int maxEntries);
+int gatewayNodeCount(const MeshGateway &gateway);
@@ -0,0 +1,19 @@
+#pragma once
+#include "snapshot.h"
+
+// Role of this board in the ESP-NOW sensor mesh, set with MESH_ROLE in
+// config.h. A leaf only samples, classifies and radios its frames to the
+// gateway; the gateway is a normal online node that also relays the leaves.
+#define MESH_ROLE_STANDALONE 0
+#define MESH_ROLE_LEAF 1
+#define MESH_ROLE_GATEWAY 2
+
+#define MESH_DEFAULT_CHANNEL 1
+#define MESH_HISTORY_INTERVAL_MS 10000   // history rate per leaf, as for local data
+
+int getMeshRole();
+bool isMeshLeaf();
+void setupMesh();
+void meshLeafSend(const LatestSnapshot &snapshot);
+void meshGatewayPoll();
+void printMeshStats();
@@ -0,0 +1,24 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Link layer used by the mesh. EspNowRadio drives the real hardware;
+// SimulatedRadio (sim_radio.h) lets the gateway logic run on a PC.
+
+#define MESH_MAC_LEN 6
+#define MESH_MAX_PAYLOAD 250
+
+typedef void (*MeshReceiveHandler)(const uint8_t *mac, const uint8_t *data, size_t len, void *context);
+
+class MeshRadio {
+public:
+  virtual ~MeshRadio() {}
+  virtual bool begin() = 0;
+  virtual bool addPeer(const uint8_t *mac) = 0;
+  virtual bool send(const uint8_t *mac, const uint8_t *data, size_t len) = 0;
+  // Hands every frame received since the last call to `handler`, in order.
+  // Radios receive in their own context; delivery only happens here.
+  virtual int poll(MeshReceiveHandler handler, void *context) = 0;
+};
+
+static const uint8_t MESH_BROADCAST_MAC[MESH_MAC_LEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
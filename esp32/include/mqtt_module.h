@@ -0,0 +1,27 @@
+#pragma once
+#include "snapshot.h"
+#include "uplink.h"
+
+// MQTT uplink (UPLINK_MQTT) to the broker set in config.h, over TLS with
+// the broker's root pinned (MQTT_ROOT_CA, port 8883). The client id
+// is the device id and the session is persistent (clean session off), so
+// the broker keeps the config subscription and QoS 1 messages across
+// reconnects. Topics, under MQTT_TOPIC_PREFIX/<device-id>/:
+//   live         MeshSampleFrame (mesh_frame.h), binary, QoS 0, retained
+//   history      telemetry JSON every 10 s, QoS 1
+//   diagnostics  diagnostics JSON, QoS 0, retained
+//   online       "1" once connected, "0" as the last will, retained
+//   config       subscribed at QoS 1: remote_config.h document, retained;
+//                only with TLS (MQTT_TLS 0 leaves remote config off)
+// Mesh leaves publish under their own id with the same layout.
+
+#define MQTT_BUFFER_BYTES 4096          // largest message: diagnostics JSON
+#define MQTT_KEEPALIVE_S 30
+#define MQTT_TIMEOUT_MS 1000            // connect and QoS 1 acknowledgement
+#define MQTT_RECONNECT_MS 5000
+
+void setupMqtt();
+int sendDataToMqtt(const LatestSnapshot &snapshot);
+void sendMeshBatchToMqtt(const MeshUpload *uploads, int count);
+void sendDiagnosticsToMqtt(const HeapReport &report, const DeadlineMonitor &deadlines);
+void pollMqtt();
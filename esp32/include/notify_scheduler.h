@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+
+// Subscription scheduler for Telegram status pushes.
+// Each subscriber has its own interval and minimum risk level. A chat that
+// is due but rate limited stays pending; later windows are merged into that
+// one pending push (coalesced) instead of queueing stale copies, and the
+// message text is built from the latest snapshot when it is finally sent.
+
+#define NOTIFY_MAX_SUBSCRIBERS 8
+#define NOTIFY_CHAT_ID_MAX 24
+
+// Bot API limits: ~30 messages/s overall, ~1 message/s per private chat,
+// 20 messages/min per group (group chat ids are negative)
+#define NOTIFY_GLOBAL_RATE_PER_S 30.0f
+#define NOTIFY_GLOBAL_BURST 30.0f
+#define NOTIFY_CHAT_RATE_PER_S 1.0f
+#define NOTIFY_GROUP_RATE_PER_S (20.0f / 60.0f)
+#define NOTIFY_CHAT_BURST 1.0f
+#define NOTIFY_LATE_MS 1000 // a push this far behind its due time counts as delayed
+
+struct TokenBucket {
+  float tokens;
+  float capacity;
+  float refillPerMs;
+  uint32_t lastMs;
+};
+
+void bucketInit(TokenBucket &bucket, float ratePerSecond, float capacity, uint32_t nowMs);
+bool bucketCanTake(TokenBucket &bucket, uint32_t nowMs);
+bool bucketTake(TokenBucket &bucket, uint32_t nowMs);
+
+struct NotifySubscriber {
+  bool active;
+  char chatId[NOTIFY_CHAT_ID_MAX];
+  uint32_t intervalMs;
+  RiskLevel minLevel;       // pushes only while risk >= minLevel
+  RiskLevel lastSentLevel;
+  uint32_t lastSentMs;
+  bool pending;
+  uint32_t pendingSinceMs;  // when the push became due
+  uint32_t mergedWindows;   // windows folded into the pending push so far
+  TokenBucket bucket;
+};
+
+struct NotifyStats {
+  uint32_t sent;            // pushes handed to the sender
+  uint32_t coalesced;       // windows merged into an already pending push
+  uint32_t delayed;         // pushes sent NOTIFY_LATE_MS or more after due
+  uint32_t throttled;       // send attempts refused by a token bucket
+  uint32_t maxDelayMs;
+  uint32_t totalDelayMs;
+};
+
+struct NotificationScheduler {
+  NotifySubscriber subscribers[NOTIFY_MAX_SUBSCRIBERS];
+  TokenBucket globalBucket;
+  int nextSlot;             // round-robin start so no chat starves
+  NotifyStats stats;
+};
+
+void notifyInit(NotificationScheduler &scheduler, uint32_t nowMs);
+int notifySubscribe(NotificationScheduler &scheduler, const char *chatId, uint32_t intervalMs,
+                    RiskLevel minLevel, uint32_t nowMs);
+bool notifyUnsubscribe(NotificationScheduler &scheduler, const char *chatId);
+int notifySubscriberCount(const NotificationScheduler &scheduler);
+int notifyFind(const NotificationScheduler &scheduler, const char *chatId);
+
+// Returns the slot of a subscriber whose push can go out now, or -1.
+// Call notifyMarkSent() once the message for that slot has been queued.
+int notifyNextDue(NotificationScheduler &scheduler, RiskLevel level, uint32_t nowMs);
+void notifyMarkSent(NotificationScheduler &scheduler, int slot, RiskLevel level, uint32_t nowMs);
+
+// Takes the global token and, for subscribers, the per-chat token.
+// Every outgoing message (pushes and command replies) goes through this.
+bool notifyTryAcquire(NotificationScheduler &scheduler, const char *chatId, uint32_t nowMs);
@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor_pipeline.h"
+
+// On-disk/on-wire format of the raw sensor recorder (little endian):
+//   0xA5 0x5A | RawSensorFrame fields, packed (41 bytes) | CRC-16/CCITT
+// The sync word and CRC let a reader pick records out of a Serial capture
+// that also contains log text, and skip damaged ones.
+
+#define RAW_RECORD_SYNC0 0xA5
+#define RAW_RECORD_SYNC1 0x5A
+#define RAW_RECORD_PAYLOAD 41
+#define RAW_RECORD_SIZE (2 + RAW_RECORD_PAYLOAD + 2)
+
+uint16_t rawRecordCrc(const uint8_t *data, size_t len);
+void rawRecordEncode(const RawSensorFrame &frame, uint8_t *out);
+// Decodes one record starting at `data`; false on bad sync, length or CRC
+bool rawRecordDecode(const uint8_t *data, size_t len, RawSensorFrame &frame);
@@ -0,0 +1,20 @@
+#pragma once
+#include "sensor_pipeline.h"
+
+// Raw sensor recorder. Every frame the sensor task acquires can be kept in
+// the raw_record.h format, either streamed on Serial or written to flash, so
+// field events can be replayed on a PC (tools/replay). On flash the frames
+// are compressed in series_codec.h blocks (about half the size) and turned
+// back into raw records when dumped; up to one block (about 0.5 s at
+// 100 Hz) is lost on a reset. RECORDER_SINK in config.h selects the sink.
+#define RECORDER_OFF 0
+#define RECORDER_SERIAL 1
+#define RECORDER_FLASH 2
+
+#define RECORDER_QUEUE_LENGTH 64                // 640 ms at 100 Hz
+#define RECORDER_FLASH_FILE_BYTES (512 * 1024)  // two files; ~1 MB, about 50k frames
+
+void setupRecorder();
+// Called by the sensor task; never blocks, counts a drop when the queue is full
+void recordRawFrame(const RawSensorFrame &frame);
+void printRecorderStats();
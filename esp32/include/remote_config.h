@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+#include "runtime_config.h"
+
+// Firebase RTDB stream on /devices/<id>/config, or with the MQTT uplink the
+// retained message on its config topic (mqtt_module.h). The stream runs in
+// the Firebase library's own task, MQTT messages in the loop; accepted
+// updates are published through runtime_config so the classifier never
+// sees a half-applied set.
+//
+// Node layout (all fields optional):
+//   { "mode": "normal" | "silent" | "test",
+//     "thresholds": { "tiltDanger": 15, "moistureDanger": 70, ... } }
+
+void setupRemoteConfig();
+String getRemoteConfigPath();
+unsigned long getRemoteConfigRejected();
+// Applies a whole config document; an empty one restores the defaults
+void applyRemoteConfigJson(const char *json);
@@ -0,0 +1,18 @@
+#pragma once
+#include "runtime_config.h"
+#include "snapshot.h"
+
+// Pure landslide risk classification; determineRiskLevel() wraps it with the
+// actuators and LCD. Soil and rain are fractions (0..1), tilt in degrees.
+// A danger reading on any channel is danger, even while another channel
+// is only in its warning band.
+void classifyRisk(const RiskThresholds &t, float angleX, float angleY, float soilMoistureValue,
+                  float rainValue, float vibrationRMS, RiskLevel &riskLevel, bool &alertTrigger);
+// Any channel at or past its danger threshold: the alarm decision, shared
+// by the classifier and the fast path
+bool riskDangerReading(const RiskThresholds &t, float angleX, float angleY, float soilMoistureValue,
+                       float rainValue, float vibrationRMS);
+// Raises the level for sustained tilt growth (creep), which the angle
+// thresholds only notice once the slope has already moved a long way
+void applyTrendRisk(const RiskThresholds &t, const TrendFeatures &trend, RiskLevel &riskLevel,
+                    bool &alertTrigger);
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+// Thresholds and mode that can be changed at runtime (see remote_config).
+// Readers always get a complete, validated copy: updates are staged in a
+// second buffer, checked, then published in one step.
+
+enum DeviceMode : uint8_t {
+  MODE_NORMAL = 0,  // classifier drives buzzer and servos
+  MODE_SILENT,      // classifier runs, actuators stay idle
+  MODE_TEST         // actuators held in the alarm position for a site test
+};
+
+struct RiskThresholds {
+  float tiltSafeMax;       // degrees; safe only at or below this
+  float tiltWarningMin;    // degrees; warning above this
+  float tiltDanger;        // degrees; danger above this
+  float moistureWarning;   // percent
+  float moistureDanger;    // percent
+  float rainWarning;       // percent
+  float rainDanger;        // percent
+  float vibrationWarning;  // m/s^2 RMS
+  float vibrationDanger;   // m/s^2 RMS
+  float creepWarning;      // deg/h of tilt growth (history.h)
+  float creepDanger;       // deg/h
+};
+
+struct RuntimeConfig {
+  uint32_t version;        // increments on every accepted update
+  RiskThresholds thresholds;
+  DeviceMode mode;
+};
+
+void defaultRuntimeConfig(RuntimeConfig &config);
+bool validateRuntimeConfig(const RuntimeConfig &config);
+
+// Applies one named field to a staged copy; false for unknown keys/values
+bool applyConfigValue(RuntimeConfig &config, const char *key, float value);
+bool applyConfigMode(RuntimeConfig &config, const char *mode);
+const char* deviceModeName(DeviceMode mode);
+
+// Published copy used by the classifier
+RuntimeConfig getRuntimeConfig();
+bool publishRuntimeConfig(const RuntimeConfig &config);
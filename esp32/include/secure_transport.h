@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+// Shared TLS transport for the Firebase, Telegram and MQTT clients: pinned CA
+// roots instead of setInsecure(), TCP keep-alive so idle connections survive
+// between requests, and handshake accounting so connection reuse is visible.
+
+#define TRANSPORT_KEEPALIVE_IDLE_S 30
+#define TRANSPORT_KEEPALIVE_INTERVAL_S 10
+#define TRANSPORT_KEEPALIVE_COUNT 3
+
+enum TransportId {
+  TRANSPORT_FIREBASE = 0,
+  TRANSPORT_TELEGRAM,
+  TRANSPORT_MQTT,
+  TRANSPORT_COUNT
+};
+
+struct TransportStats {
+  uint32_t requests;
+  uint32_t reusedRequests;     // requests that found the connection already open
+  uint32_t handshakes;
+  uint32_t handshakeFailures;
+  uint32_t totalHandshakeMs;
+  uint32_t maxHandshakeMs;
+  uint32_t totalColdRequestMs; // requests that had to connect first
+  uint32_t totalWarmRequestMs;
+};
+
+// WiFiClientSecure that pins the root CA for its endpoint and times every
+// TLS handshake
+class SecureTransportClient : public WiFiClientSecure {
+public:
+  explicit SecureTransportClient(TransportId id);
+  void begin();
+
+  using WiFiClientSecure::connect;
+  int connect(const char *host, uint16_t port) override;
+
+private:
+  TransportId transportId;
+};
+
+const char* transportRootCA(TransportId id);
+void recordTransportHandshake(TransportId id, bool ok, uint32_t durationMs);
+void recordTransportRequest(TransportId id, bool reused, uint32_t durationMs);
+TransportStats getTransportStats(TransportId id);
+uint32_t estimateHandshakeMs(const TransportStats &stats);
+void printTransportStats();
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include "fusion.h"
+#include "snapshot.h"
+#include "adaptive_rate.h"
+
+// Hardware-free half of the sensor task: turns raw readings into a
+// SensorSample (vibration window, tilt fusion, ADC calibration). The sensor
+// task and the host replay tool run the exact same code. The sample rate
+// and vibration window follow the rate profile carried in each frame's
+// flags, so a replay switches rates exactly where the device did.
+
+#define SENSOR_SAMPLE_RATE_HZ 100  // full rate; see ratePolicy() for the others
+#define FUSION_TIME_CONSTANT 2.0f  // seconds; longer trusts the gyro more
+#define FUSION_ACCEL_DECIMATION 4  // accelerometer correction every 4th sample
+#define ANALOG_DECIMATION 10       // rain and soil ADC read every 10th sample (10 Hz)
+#define VIBRATION_SAMPLES 20       // ring size; the largest window of any rate profile
+
+// Soil moisture calibration values
+#define DRY_SOIL_VALUE 2650
+#define WET_SOIL_VALUE 0
+
+#define RAW_FLAG_MOTION 0x01  // accel/gyro/temperature came from the MPU6050
+#define RAW_FLAG_ANALOG 0x02  // rain/soil were read on this sample
+#define RAW_FLAG_RATE_SHIFT 2 // bits 2-3: RateProfile the frame was sampled at
+#define RAW_FLAG_RATE_MASK 0x0C
+
+struct RawSensorFrame {
+  uint32_t sequence;
+  uint32_t timestampMs;
+  float accel[3];     // m/s^2
+  float gyro[3];      // rad/s
+  float temperature;  // C
+  uint16_t rainRaw;   // ADC counts
+  uint16_t soilRaw;   // ADC counts
+  uint8_t flags;
+};
+
+struct SensorPipeline {
+  TiltFusion fusion;
+  float vibrationBuffer[VIBRATION_SAMPLES][3];
+  int vibrationIndex;
+  int vibrationWindow;   // samples in the RMS, <= VIBRATION_SAMPLES
+  uint8_t rateProfile;
+  float rain;          // last calibrated values, held between ADC reads
+  float soilMoisture;
+};
+
+void pipelineInit(SensorPipeline &pipeline);
+void pipelineProcess(SensorPipeline &pipeline, const RawSensorFrame &raw, SensorSample &sample);
+float rainFromRaw(uint16_t raw);
+float soilMoistureFromRaw(uint16_t raw);
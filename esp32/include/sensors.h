@@ -1,14 +1,20 @@
 #pragma once
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
+#include "snapshot.h"
+#include "adaptive_rate.h"
 
 void setupSensors();
 float getVibrationRMS();
 void setupMPU6050();
-void readMPU6050Data(sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp);
+// Re-initialises the I2C bus and the MPU6050 from the sensor task at its
+// next cycle (deadline monitor escalation)
+void requestSensorRestart();
+void startSensorTask();
+// Sampling rate for the following samples (ratePolicy().sampleRateHz)
+void setSensorRateProfile(RateProfile profile);
 float readRainSensor();
 float readSoilMoistureSensor();
 void scanI2CDevices();
-void readAllSensorsData(float &rainValue, float &soilMoistureValue, sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp);
-extern float vibrationRMS;
+void printSensorSample(const SensorSample &sample);
 extern bool mpuAvailable;
\ No newline at end of file
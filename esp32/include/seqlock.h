@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// Single-writer sequence lock. The writer never waits; readers retry while a
+// write is in progress. A reader must not outrank the writer on the writer's
+// core, otherwise it could spin on a write it has itself preempted.
+template <typename T>
+class Seqlock {
+public:
+  Seqlock() : sequence(0), value() {}
+
+  void write(const T &newValue) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    value = newValue;
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  T read() const {
+    T copy;
+    uint32_t before, after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      copy = value;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return copy;
+  }
+
+  // Number of completed writes
+  uint32_t version() const {
+    return sequence.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  std::atomic<uint32_t> sequence;
+  T value;
+};
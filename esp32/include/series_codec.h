@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor_pipeline.h"
+
+// Gorilla-style compression of raw sensor frames (RawSensorFrame) into
+// self-contained blocks, for the flash recorder. Per frame:
+//   timestamp      delta-of-delta: '0' when the spacing repeats, else a
+//                  prefix and 7, 9, 12 or 32 bits
+//   sequence       '0' when it is the previous + 1, else '1' + 32 bits
+//   7 floats       XOR with the previous value (accel, gyro, temperature):
+//                  '0' when equal, '10' + the meaningful bits when they fit
+//                  the previous window, else '11' + 5-bit leading zeros,
+//                  5-bit length - 1 and the bits
+//   rain, soil     '0' when unchanged, else '1' + 16 bits
+//   flags          '0' when unchanged, else '1' + 8 bits
+// Every block starts from scratch, so blocks decode on their own and a ring
+// of them can drop the oldest. Header (little endian):
+//   'G' 'S' | version | reserved | frame count u16 | payload bits u16 | CRC-16 of payload u16 | reserved u16
+
+#define SERIES_BLOCK_BYTES 1024
+#define SERIES_HEADER_BYTES 12
+#define SERIES_MAGIC0 'G'
+#define SERIES_MAGIC1 'S'
+#define SERIES_VERSION 1
+#define SERIES_FLOATS 7
+
+struct SeriesState {
+  RawSensorFrame previous;
+  int32_t previousDelta;
+  uint8_t leading[SERIES_FLOATS];
+  uint8_t trailing[SERIES_FLOATS];  // 0xFF until a window exists
+};
+
+struct SeriesEncoder {
+  uint8_t *block;
+  size_t capacity;      // whole block, header included
+  uint32_t bitPos;      // payload bits written
+  uint16_t count;
+  SeriesState state;
+};
+
+struct SeriesDecoder {
+  const uint8_t *payload;
+  uint32_t bitLength;
+  uint32_t bitPos;
+  uint16_t count;       // frames in the block
+  uint16_t decoded;
+  SeriesState state;
+};
+
+void seriesEncoderInit(SeriesEncoder &encoder, uint8_t *block, size_t capacity);
+// False, with the block unchanged, when the frame does not fit
+bool seriesAppend(SeriesEncoder &encoder, const RawSensorFrame &frame);
+// Writes the header; returns the bytes of the block in use
+size_t seriesFinish(SeriesEncoder &encoder);
+
+// False on a bad magic, version, length or CRC
+bool seriesDecoderInit(SeriesDecoder &decoder, const uint8_t *block, size_t len);
+// Next frame of the block; false once all are read or the payload is cut short
+bool seriesNext(SeriesDecoder &decoder, RawSensorFrame &frame);
@@ -0,0 +1,93 @@
+#pragma once
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "mesh_radio.h"
+
+// In-process radio for host-side runs of the mesh code. All radios attached
+// to one SimulatedAir hear each other; frames can be dropped with a fixed
+// probability from a deterministic generator so runs are reproducible.
+// Not used by the firmware build.
+
+class SimulatedRadio;
+
+class SimulatedAir {
+public:
+  explicit SimulatedAir(unsigned lossPercent = 0, uint32_t seed = 1)
+    : lossPercent(lossPercent), state(seed), delivered(0), dropped(0) {}
+
+  void attach(SimulatedRadio *radio) { radios.push_back(radio); }
+  void transmit(const SimulatedRadio *from, const uint8_t *to, const uint8_t *data, size_t len);
+
+  unsigned lossPercent;
+  uint32_t state;
+  uint32_t delivered;
+  uint32_t dropped;
+
+private:
+  bool lose() {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 16) % 100 < lossPercent;
+  }
+  std::vector<SimulatedRadio*> radios;
+};
+
+class SimulatedRadio : public MeshRadio {
+public:
+  SimulatedRadio(SimulatedAir &air, const uint8_t *mac) : air(air) {
+    memcpy(address, mac, MESH_MAC_LEN);
+    air.attach(this);
+  }
+
+  bool begin() override { return true; }
+  bool addPeer(const uint8_t *mac) override { (void)mac; return true; }
+
+  bool send(const uint8_t *mac, const uint8_t *data, size_t len) override {
+    if (len > MESH_MAX_PAYLOAD) return false;
+    air.transmit(this, mac, data, len);
+    return true;
+  }
+
+  int poll(MeshReceiveHandler handler, void *context) override {
+    int count = 0;
+    while (!inbox.empty()) {
+      Frame &frame = inbox.front();
+      handler(frame.from, frame.data.data(), frame.data.size(), context);
+      inbox.pop_front();
+      count++;
+    }
+    return count;
+  }
+
+  void deliver(const uint8_t *from, const uint8_t *data, size_t len) {
+    Frame frame;
+    memcpy(frame.from, from, MESH_MAC_LEN);
+    frame.data.assign(data, data + len);
+    inbox.push_back(frame);
+  }
+
+  uint8_t address[MESH_MAC_LEN];
+
+private:
+  struct Frame {
+    uint8_t from[MESH_MAC_LEN];
+    std::vector<uint8_t> data;
+  };
+  SimulatedAir &air;
+  std::deque<Frame> inbox;
+};
+
+inline void SimulatedAir::transmit(const SimulatedRadio *from, const uint8_t *to,
+                                   const uint8_t *data, size_t len) {
+  bool broadcast = memcmp(to, MESH_BROADCAST_MAC, MESH_MAC_LEN) == 0;
+  for (SimulatedRadio *radio : radios) {
+    if (radio == from) continue;
+    if (!broadcast && memcmp(to, radio->address, MESH_MAC_LEN) != 0) continue;
+    if (lose()) {
+      dropped++;
+      continue;
+    }
+    radio->deliver(from->address, data, len);
+    delivered++;
+  }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+#include "adaptive_rate.h"
+#include "runtime_config.h"
+#include "anomaly.h"
+
+// Deep-sleep duty cycling, hardware-free half. A standalone node that has
+// settled in the safe profile sleeps between reports while the ULP
+// coprocessor samples the rain and soil ADC channels. The ULP wakes the CPU
+// when a reading reaches the watch level (RATE_WATCH_FRACTION of its
+// warning threshold), the same level that would have kept the node awake;
+// a timer wakes it when a report is due. The state that has to outlive the
+// sleep (risk, rate profile and trends, anomaly baselines, stats) sits in
+// RTC memory.
+
+#define SLEEP_STATE_MAGIC 0x534C5032u   // "SLP2"; change when SleepState changes
+#define DEEP_SLEEP_REPORT_S 300         // timer wake for a routine report
+#define DEEP_SLEEP_ULP_PERIOD_MS 10000  // ULP samples rain and soil every 10 s
+#define DEEP_SLEEP_MIN_AWAKE_MS 5000    // shortest stay after a wake
+
+struct SleepStats {
+  uint32_t sleeps;
+  uint32_t ulpWakes;      // a reading reached its wake level
+  uint32_t timerWakes;    // report due
+  uint32_t sleptS;        // total time asleep
+};
+
+// Kept in RTC slow memory across deep sleep
+struct SleepState {
+  uint32_t magic;
+  SleepStats stats;
+  uint32_t savedAtMs;     // millis() when saved
+  int64_t savedAtUs;      // wall clock then; the RTC keeps it running while asleep
+  RiskStatus risk;        // last classification before sleeping
+  AdaptiveRate rate;
+  AnomalyDetector anomaly;
+  uint8_t wifiChannel;    // for a reconnect without a scan; 0 = unknown
+  uint8_t wifiBssid[6];
+  uint16_t crc;
+};
+
+// ADC counts the ULP compares against. Both sensors read lower when wetter,
+// so a wake level is crossed by going below it.
+struct UlpWakeLevels {
+  uint16_t rainBelow;
+  uint16_t soilBelow;
+};
+
+UlpWakeLevels ulpWakeLevels(const RiskThresholds &thresholds);
+// Only a calm, safe slope that has already reported since waking may sleep
+bool sleepAllowed(const RiskStatus &risk, uint32_t awakeMs, uint32_t uploadsSinceWake);
+void sleepStateSeal(SleepState &state);
+bool sleepStateValid(const SleepState &state);
+// Copies the saved rate and anomaly state onto this boot's millis()
+// timeline, counting the `elapsedMs` since it was saved (sleep plus boot) as
+// time that passed. The anomaly step in progress at sleep is dropped.
+void sleepStateRestore(const SleepState &state, uint32_t elapsedMs, uint32_t nowMs,
+                       AdaptiveRate &rate, AnomalyDetector &anomaly);
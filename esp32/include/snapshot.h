@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+// Latest-sample store shared by every consumer (classifier, Firebase,
+// Telegram, LCD, diagnostics). Only the sensor task touches the hardware and
+// publishes samples; only the classifier publishes the risk status.
+
+enum RiskLevel : uint8_t {
+  RISK_UNKNOWN = 0,
+  RISK_SAFE,
+  RISK_WARNING,
+  RISK_DANGER
+};
+
+struct SensorSample {
+  uint32_t sequence;     // increments once per acquired sample
+  uint32_t timestampMs;  // millis() at acquisition
+  float accelX, accelY, accelZ;  // m/s^2
+  float gyroX, gyroY, gyroZ;     // rad/s
+  float temperature;     // C
+  float angleX, angleY;  // fused tilt, degrees
+  float vibrationRMS;    // m/s^2
+  float rain;            // 0..1
+  float soilMoisture;    // 0..1
+};
+
+// Slow trends from the on-device history (history.h)
+struct TrendFeatures {
+  bool ratesValid;          // enough minutes for the two rates below
+  float tiltVelocity;       // deg/h, positive while the tilt grows
+  float moistureRate;       // percent/h
+  float rainEventHours;     // wetness-hours since the current rain began, 0 when dry
+  float rain24hHours;       // wetness-hours over the last 24 completed hours
+};
+
+struct RiskStatus {
+  uint32_t timestampMs;     // millis() at classification
+  uint32_t sampleSequence;  // SensorSample::sequence that was classified
+  RiskLevel level;
+  bool alertTrigger;
+  uint8_t rateProfile;      // RateProfile (adaptive_rate.h) chosen from this classification
+  uint8_t anomalyMask;      // bit per AnomalyChannel (anomaly.h) in alarm
+  float anomalyScore[4];    // per AnomalyChannel; >= 1 is an alarm
+  TrendFeatures trend;      // the trends this classification saw
+};
+
+struct LatestSnapshot {
+  SensorSample sample;
+  RiskStatus risk;
+};
+
+void publishSensorSample(const SensorSample &sample);
+void publishRiskStatus(const RiskStatus &status);
+SensorSample readLatestSample();
+RiskStatus readLatestRiskStatus();
+LatestSnapshot readLatestSnapshot();
+const char* riskLevelName(RiskLevel level);
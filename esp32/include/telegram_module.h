@@ -1,12 +1,22 @@
 #include <Arduino.h>
 #pragma once
+#include "frame_arena.h"
+
+#define TELEGRAM_CHAT_ID_MAX 24
+#define TELEGRAM_MESSAGE_MAX 768
 
 void setupTelegram();
+void startTelegramTask();
+// Starts one poll/send cycle of the Telegram task; kicks that arrive while
+// a cycle is running fold into a single follow-up cycle
+void kickTelegramTask();
+bool queueTelegramMessage(const char *chat_id, const char *text);
+unsigned long getTelegramDroppedMessages();
 void sendSubscriptionStatusIfNeeded();
-String getFormattedSensorData();
-void handleSubscriptionCommands(const String& chat_id, const String& text);
-void checkNewMessages(
-  String *riskLevelz, 
-  const bool alertTriggerz
-);
+// Message builders append to a string in the Telegram task's arena
+void appendSubscriptionStats(ArenaString &out);
+void appendThresholds(ArenaString &out);
+void appendSensorData(ArenaString &out);
+void handleSubscriptionCommands(const char *chat_id, const char *text);
+void checkNewMessages();
 void replyNewMessages(int numNewMessages);
\ No newline at end of file
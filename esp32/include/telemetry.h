@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "snapshot.h"
+#include "heap_stats.h"
+#include "deadline_monitor.h"
+
+// JSON document written to /devices/<id>/live and history, built with one
+// snprintf into a caller buffer instead of a tree of FirebaseJson objects.
+// `epoch` is omitted from the document ("ts") when it is 0.
+
+#define TELEMETRY_JSON_MAX 704  // worst case (full-scale readings, 31-char id) is 609
+
+// Returns the length written, or -1 if `size` is too small
+int formatTelemetryJson(char *out, size_t size, const LatestSnapshot &snapshot,
+                        const char *deviceId, uint32_t epoch);
+
+// /devices/<id>/diagnostics: heap health, per-subsystem allocation counts
+// and deadline misses per stage and task
+#define DIAGNOSTICS_JSON_MAX 3328  // worst case with every counter at its maximum is 3166
+
+int formatDiagnosticsJson(char *out, size_t size, const HeapReport &report,
+                          const DeadlineMonitor &deadlines, uint32_t epoch);
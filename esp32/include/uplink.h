@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "snapshot.h"
+#include "device_id.h"
+#include "heap_stats.h"
+#include "deadline_monitor.h"
+
+// Cloud uplink. UPLINK_TRANSPORT in config.h picks the backend at build
+// time: Firebase RTDB over HTTPS REST (firebase_module.h) or an MQTT broker
+// (mqtt_module.h). The loop, the mesh gateway and the reports only go
+// through the functions below.
+#define UPLINK_FIREBASE 0
+#define UPLINK_MQTT 1
+
+#define HISTORY_INTERVAL_MS 10000    // one history entry every 10 s
+#define MIN_VALID_EPOCH 1700000000   // anything earlier means NTP has not synced yet
+
+// Sample relayed by the mesh gateway on behalf of a leaf
+struct MeshUpload {
+  char deviceId[DEVICE_ID_MAX];
+  LatestSnapshot snapshot;  // sample.timestampMs on the gateway clock
+  bool history;             // also append to the leaf's history
+};
+
+struct UplinkTransport {
+  const char *name;
+  void (*setup)();
+  // Payload bytes of the live document or message, or -1 when it was not sent
+  int (*sendSample)(const LatestSnapshot &snapshot);
+  void (*sendMeshBatch)(const MeshUpload *uploads, int count);
+  void (*sendDiagnostics)(const HeapReport &report, const DeadlineMonitor &deadlines);
+  void (*poll)();           // keeps the connection serviced; NULL when not needed
+};
+
+struct UplinkStats {
+  uint32_t samples;
+  uint32_t failures;
+  uint32_t payloadBytes;
+  uint32_t totalSendMs;
+  uint32_t maxSendMs;
+};
+
+#define UPLINK_POLL_PERIOD_US 100000   // MQTT keep-alive, acks and config messages
+
+// Also runs the UPLINK_BENCH_MESSAGES benchmark when config.h asks for it
+void setupUplink();
+const char* uplinkName();
+// True when the sample was sent
+bool uplinkSendSample(const LatestSnapshot &snapshot);
+void uplinkSendMeshBatch(const MeshUpload *uploads, int count);
+void uplinkSendDiagnostics(const HeapReport &report, const DeadlineMonitor &deadlines);
+bool uplinkNeedsPoll();
+void uplinkPoll();
+// Sends `messages` live samples back to back and prints messages/s and
+// payload bytes/s (UPLINK_BENCH_MESSAGES in config.h)
+void runUplinkBenchmark(uint32_t messages);
+void printUplinkStats();
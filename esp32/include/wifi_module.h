@@ -1,2 +1,10 @@
 #pragma once
-void setupWiFi();
+#include <stddef.h>
+#include <stdint.h>
+// A known channel and BSSID (saved before deep sleep) skip the scan
+void setupWiFi(int32_t channel = 0, const uint8_t *bssid = NULL);
+// Modem sleep between transmissions; off keeps the radio listening for low latency
+void setWiFiPowerSave(bool enabled);
+// Drops the association and joins again in the background (deadline
+// monitor escalation for the network stages)
+void reconnectWiFi();
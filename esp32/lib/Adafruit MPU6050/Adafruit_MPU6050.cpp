@@ -163,6 +163,10 @@ void Adafruit_MPU6050::reset(void) {
   sig_path_reset.write(0x7);
 
   delay(100);
+
+  // power-on ranges: 2 G and 250 deg/s
+  accel_scale = 16384;
+  gyro_scale = 131;
 }
 
 /**************************************************************************/
@@ -220,6 +224,15 @@ void Adafruit_MPU6050::setAccelerometerRange(mpu6050_accel_range_t new_range) {
   Adafruit_BusIO_RegisterBits accel_range =
       Adafruit_BusIO_RegisterBits(&accel_config, 2, 3);
   accel_range.write(new_range);
+
+  if (new_range == MPU6050_RANGE_16_G)
+    accel_scale = 2048;
+  if (new_range == MPU6050_RANGE_8_G)
+    accel_scale = 4096;
+  if (new_range == MPU6050_RANGE_4_G)
+    accel_scale = 8192;
+  if (new_range == MPU6050_RANGE_2_G)
+    accel_scale = 16384;
 }
 /**************************************************************************/
 /*!
@@ -250,6 +263,15 @@ void Adafruit_MPU6050::setGyroRange(mpu6050_gyro_range_t new_range) {
       Adafruit_BusIO_RegisterBits(&gyro_config, 2, 3);
 
   gyro_range.write(new_range);
+
+  if (new_range == MPU6050_RANGE_250_DEG)
+    gyro_scale = 131;
+  if (new_range == MPU6050_RANGE_500_DEG)
+    gyro_scale = 65.5;
+  if (new_range == MPU6050_RANGE_1000_DEG)
+    gyro_scale = 32.8;
+  if (new_range == MPU6050_RANGE_2000_DEG)
+    gyro_scale = 16.4;
 }
 
 /**************************************************************************/
@@ -638,11 +660,21 @@ bool Adafruit_MPU6050::setTemperatureStandby(bool enable) {
 void Adafruit_MPU6050::_read(void) {
   // get raw readings
   Adafruit_BusIO_Register data_reg =
-      Adafruit_BusIO_Register(i2c_dev, MPU6050_ACCEL_OUT, 14);
+      Adafruit_BusIO_Register(i2c_dev, MPU6050_ACCEL_OUT, MPU6050_DATA_BYTES);
+
+  uint8_t buffer[MPU6050_DATA_BYTES];
+  data_reg.read(buffer, MPU6050_DATA_BYTES);
 
-  uint8_t buffer[14];
-  data_reg.read(buffer, 14);
+  _decode(buffer);
+}
 
+/*!
+ *     @brief  Converts the output registers to the measurement fields, scaled
+ *             for the ranges last set
+ *     @param  buffer
+ *             MPU6050_DATA_BYTES read from MPU6050_ACCEL_OUT
+ */
+void Adafruit_MPU6050::_decode(const uint8_t *buffer) {
   rawAccX = buffer[0] << 8 | buffer[1];
   rawAccY = buffer[2] << 8 | buffer[3];
   rawAccZ = buffer[4] << 8 | buffer[5];
@@ -655,35 +687,11 @@ void Adafruit_MPU6050::_read(void) {
 
   temperature = (rawTemp / 340.0) + 36.53;
 
-  mpu6050_accel_range_t accel_range = getAccelerometerRange();
-
-  float accel_scale = 1;
-  if (accel_range == MPU6050_RANGE_16_G)
-    accel_scale = 2048;
-  if (accel_range == MPU6050_RANGE_8_G)
-    accel_scale = 4096;
-  if (accel_range == MPU6050_RANGE_4_G)
-    accel_scale = 8192;
-  if (accel_range == MPU6050_RANGE_2_G)
-    accel_scale = 16384;
-
   // setup range dependant scaling
   accX = ((float)rawAccX) / accel_scale;
   accY = ((float)rawAccY) / accel_scale;
   accZ = ((float)rawAccZ) / accel_scale;
 
-  mpu6050_gyro_range_t gyro_range = getGyroRange();
-
-  float gyro_scale = 1;
-  if (gyro_range == MPU6050_RANGE_250_DEG)
-    gyro_scale = 131;
-  if (gyro_range == MPU6050_RANGE_500_DEG)
-    gyro_scale = 65.5;
-  if (gyro_range == MPU6050_RANGE_1000_DEG)
-    gyro_scale = 32.8;
-  if (gyro_range == MPU6050_RANGE_2000_DEG)
-    gyro_scale = 16.4;
-
   gyroX = ((float)rawGyroX) / gyro_scale;
   gyroY = ((float)rawGyroY) / gyro_scale;
   gyroZ = ((float)rawGyroZ) / gyro_scale;
@@ -716,6 +724,99 @@ bool Adafruit_MPU6050::getEvent(sensors_event_t *accel, sensors_event_t *gyro,
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Sets the transport used by `startRead`. The driver does not touch
+            the bus for asynchronous reads itself, so the application can
+            run them from whatever owns the bus.
+    @param  transfer
+            Starts a write-then-read transfer and returns at once; NULL
+            turns asynchronous reads off
+*/
+/**************************************************************************/
+void Adafruit_MPU6050::setAsyncTransfer(mpu6050_async_transfer_t transfer) {
+  async_transfer = transfer;
+}
+
+enum { ASYNC_IDLE, ASYNC_PENDING, ASYNC_DONE, ASYNC_FAILED };
+
+void Adafruit_MPU6050::_asyncComplete(bool ok, void *arg) {
+  Adafruit_MPU6050 *mpu = (Adafruit_MPU6050 *)arg;
+  mpu->async_state = ok ? ASYNC_DONE : ASYNC_FAILED;
+  if (mpu->async_done)
+    mpu->async_done(ok, mpu->async_arg);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts reading all measurements in one transfer and returns
+            without waiting for it. The CPU is free for other work until
+            `done` is called; `finishRead` then converts the reading.
+    @param  done
+            Called when the transfer has finished, possibly from another
+            task; may be NULL to poll `readPending` instead
+    @param  arg
+            Passed to `done`
+    @return False if no transport is set, a read is still in flight or the
+            transport could not start the transfer
+*/
+/**************************************************************************/
+bool Adafruit_MPU6050::startRead(mpu6050_read_done_t done, void *arg) {
+  if (!async_transfer || !i2c_dev || async_state == ASYNC_PENDING)
+    return false;
+  async_done = done;
+  async_arg = arg;
+  async_timestamp = millis();
+  // set before starting: the transfer may complete before it returns
+  async_state = ASYNC_PENDING;
+  uint8_t reg = MPU6050_ACCEL_OUT;
+  if (!async_transfer(i2c_dev->address(), &reg, 1, async_buffer,
+                      MPU6050_DATA_BYTES, _asyncComplete, this)) {
+    async_state = ASYNC_IDLE;
+    return false;
+  }
+  return true;
+}
+
+/*!
+    @brief  Whether the read started by `startRead` is still in flight
+    @return True until its transfer has finished
+*/
+bool Adafruit_MPU6050::readPending(void) {
+  return async_state == ASYNC_PENDING;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Completes the read started by `startRead`, like `getEvent`
+    @param  accel
+            Filled with acceleration event data
+    @param  gyro
+            Filled with gyroscope event data
+    @param  temp
+            Filled with temperature event data
+    @return True if a read finished successfully; the events are timestamped
+            when it was started. False if it failed, is still in flight or
+            none was started.
+*/
+/**************************************************************************/
+bool Adafruit_MPU6050::finishRead(sensors_event_t *accel, sensors_event_t *gyro,
+                                  sensors_event_t *temp) {
+  uint8_t state = async_state;
+  if (state == ASYNC_PENDING || state == ASYNC_IDLE)
+    return false;
+  async_state = ASYNC_IDLE;
+  if (state == ASYNC_FAILED)
+    return false;
+
+  _decode(async_buffer);
+  fillTempEvent(temp, async_timestamp);
+  fillAccelEvent(accel, async_timestamp);
+  fillGyroEvent(gyro, async_timestamp);
+
+  return true;
+}
+
 void Adafruit_MPU6050::fillTempEvent(sensors_event_t *temp,
                                      uint32_t timestamp) {
 
@@ -152,6 +152,29 @@ typedef enum {
   MPU6050_CYCLE_40_HZ,   ///< 40 Hz
 } mpu6050_cycle_rate_t;
 
+#define MPU6050_DATA_BYTES 14 ///< Accel, temperature and gyro output registers
+
+/**
+ * @brief Completion callback of an asynchronous read
+ *
+ * @param ok True if the transfer succeeded
+ * @param arg The pointer given to `startRead`
+ */
+typedef void (*mpu6050_read_done_t)(bool ok, void *arg);
+
+/**
+ * @brief Starts an I2C transfer on behalf of the driver and returns at once
+ *
+ * Writes `tx_len` bytes from `tx` to `i2c_addr`, then reads `rx_len` bytes
+ * into `rx` after a repeated start. `done(ok, arg)` is called once the
+ * transfer has finished, possibly from another task. Returns false if the
+ * transfer could not be started; `done` is not called then.
+ */
+typedef bool (*mpu6050_async_transfer_t)(uint8_t i2c_addr, const uint8_t *tx,
+                                         size_t tx_len, uint8_t *rx,
+                                         size_t rx_len,
+                                         mpu6050_read_done_t done, void *arg);
+
 class Adafruit_MPU6050;
 
 /** Adafruit Unified Sensor interface for temperature component of MPU6050 */
@@ -262,6 +285,13 @@ public:
   Adafruit_Sensor *getAccelerometerSensor(void);
   Adafruit_Sensor *getGyroSensor(void);
 
+  // Asynchronous reads through a transport provided by the application
+  void setAsyncTransfer(mpu6050_async_transfer_t transfer);
+  bool startRead(mpu6050_read_done_t done = NULL, void *arg = NULL);
+  bool readPending(void);
+  bool finishRead(sensors_event_t *accel, sensors_event_t *gyro,
+                  sensors_event_t *temp);
+
 private:
   void _getRawSensorData(void);
   void _scaleSensorData(void);
@@ -300,6 +330,19 @@ private:
 
   int16_t rawAccX, rawAccY, rawAccZ, rawTemp, rawGyroX, rawGyroY, rawGyroZ;
 
+  // Follow setAccelerometerRange/setGyroRange, so a read does not have to
+  // read the range registers back
+  float accel_scale = 16384, gyro_scale = 131;
+
+  mpu6050_async_transfer_t async_transfer = NULL;
+  mpu6050_read_done_t async_done = NULL;
+  void *async_arg = NULL;
+  volatile uint8_t async_state = 0;
+  uint32_t async_timestamp = 0;
+  uint8_t async_buffer[MPU6050_DATA_BYTES];
+
+  static void _asyncComplete(bool ok, void *arg);
+  void _decode(const uint8_t *buffer);
   void fillTempEvent(sensors_event_t *temp, uint32_t timestamp);
   void fillAccelEvent(sensors_event_t *accel, uint32_t timestamp);
   void fillGyroEvent(sensors_event_t *gyro, uint32_t timestamp);
@@ -2,15 +2,19 @@
 #include <LiquidCrystal_I2C.h>
 #include <ESP32Servo.h>
 #include <Arduino.h>
+#include "lcd_render.h"
+#include "heap_monitor.h"
+#include "i2c_bus.h"
 
 #define SERVO_PIN_1 26
 #define SERVO_PIN_2 27
 #define BUZZER_PIN 18
 #define LCD_ADDR 0x27
-#define LCD_COLS 16
-#define LCD_ROWS 2
+#define LCD_QUEUE_WAIT_MS 50   // two rows fit the queue; only back-to-back updates wait
 
 LiquidCrystal_I2C lcd(LCD_ADDR, LCD_COLS, LCD_ROWS);
+static LcdFrame lcdShown; // what the display currently holds
+static bool lcdBacklight = true;
 Servo servo1;
 Servo servo2;
 
@@ -20,28 +24,51 @@ void setupActuators() {
   setupServo();
 }
 
+// Init, clear and power down go through the library under the bus lock;
+// they are rare and need the controller's long command delays
 void setupLCD() {
+  i2cWaitQueued(LCD_QUEUE_WAIT_MS);
+  I2cBusLock lock(I2C_DEVICE_LCD);
   lcd.init();
   lcd.backlight();
   lcd.clear();
+  lcdBacklight = true;
+  lcdRender("", lcdShown);
 }
 
-void writeLCD(const String& message) {
-  lcd.clear();
-  Serial.println("LCD Message: " + message);
+void powerDownDisplay() {
+  i2cWaitQueued(LCD_QUEUE_WAIT_MS);
+  I2cBusLock lock(I2C_DEVICE_LCD);
+  lcd.noDisplay();
+  lcd.noBacklight();
+  lcdBacklight = false;
+}
+
+void writeLCD(const char *message) {
+  HeapScope heapScope(HEAP_DISPLAY);
+  LcdFrame next;
+  lcdRender(message, next);
+  uint8_t changed = lcdChangedRows(lcdShown, next);
+  if (!changed) return;
 
-  if (message.length() > LCD_COLS * LCD_ROWS + 1) {
+  Serial.print("LCD Message: ");
+  Serial.println(message);
+  if (strlen(message) > LCD_COLS * LCD_ROWS + 1) {
     Serial.println("Warning: Message too long for LCD");
   }
-
-  int line = 0;
-  for (int i = 0; i < message.length(); i++) {
-    if (message[i] == '\n' && line < LCD_ROWS - 1) {
-      line++;
-      lcd.setCursor(0, line);
-    } else {
-      lcd.print(message[i]);
-    }
+  // Rewrite only the rows that changed; padding overwrites the old text.
+  // Queued for the bus task, so this does not wait for the LCD.
+  uint8_t failed = 0;
+  for (int row = 0; row < LCD_ROWS; row++) {
+    if (!(changed & (1 << row))) continue;
+    uint8_t stream[LCD_ROW_STREAM_BYTES];
+    int len = lcdEncodeRow(row, next.rows[row], lcdBacklight, stream);
+    if (!i2cWriteQueued(I2C_DEVICE_LCD, LCD_ADDR, stream, len, LCD_QUEUE_WAIT_MS)) failed |= 1 << row;
+  }
+  lcdShown = next;
+  // A row only partly queued is rewritten by the next update
+  for (int row = 0; row < LCD_ROWS; row++) {
+    if (failed & (1 << row)) lcdShown.rows[row][0] = '\0';
   }
 }
 
@@ -0,0 +1,84 @@
+#include "adaptive_rate.h"
+#include "fastmath.h"
+
+// The RMS window spans 0.2 s at full rate and grows at the slower rates,
+// where the extra averaging costs no latency that matters
+static const RatePolicy policies[RATE_PROFILE_COUNT] = {
+  { 100, 20, 200, false },    // RATE_FULL
+  { 50, 16, 1000, false },    // RATE_WATCH
+  { 25, 12, 5000, true },     // RATE_SAFE
+};
+
+const RatePolicy& ratePolicy(RateProfile profile) {
+  return policies[profile < RATE_PROFILE_COUNT ? profile : RATE_FULL];
+}
+
+const char* rateProfileName(RateProfile profile) {
+  switch (profile) {
+    case RATE_FULL: return "full";
+    case RATE_WATCH: return "watch";
+    case RATE_SAFE: return "safe";
+    default: return "unknown";
+  }
+}
+
+void adaptiveRateInit(AdaptiveRate &rate, uint32_t nowMs) {
+  rate.profile = RATE_FULL;
+  rate.profileSinceMs = nowMs;
+  rate.holdUntilMs = nowMs + RATE_HOLD_MS;
+  rate.transitions = 0;
+  rate.hasBaseline = false;
+  rate.trendStartMs = nowMs;
+  rate.trendStartTilt = 0;
+  rate.trendStartMoisture = 0;
+  rate.tiltTrend = 0;
+  rate.moistureTrend = 0;
+}
+
+static void updateTrend(AdaptiveRate &rate, float tilt, float moisture, uint32_t nowMs) {
+  uint32_t elapsed = nowMs - rate.trendStartMs;
+  if (rate.hasBaseline && elapsed < RATE_TREND_WINDOW_MS) return;
+  if (rate.hasBaseline) {
+    float minutes = elapsed / 60000.0f;
+    rate.tiltTrend = (tilt - rate.trendStartTilt) / minutes;
+    rate.moistureTrend = (moisture - rate.trendStartMoisture) / minutes;
+  }
+  rate.hasBaseline = true;
+  rate.trendStartMs = nowMs;
+  rate.trendStartTilt = tilt;
+  rate.trendStartMoisture = moisture;
+}
+
+static RateProfile targetProfile(const AdaptiveRate &rate, const RiskThresholds &t, RiskLevel level,
+                                 const SensorSample &sample) {
+  if (level != RISK_SAFE) return RATE_FULL;
+  float tilt = fastMaxAbs(sample.angleX, sample.angleY);
+  bool near = tilt >= t.tiltWarningMin * RATE_WATCH_FRACTION ||
+              sample.soilMoisture * 100 >= t.moistureWarning * RATE_WATCH_FRACTION ||
+              sample.rain * 100 >= t.rainWarning * RATE_WATCH_FRACTION ||
+              sample.vibrationRMS >= t.vibrationWarning * RATE_WATCH_FRACTION;
+  bool rising = rate.tiltTrend >= RATE_TILT_TREND_DEG_PER_MIN ||
+                rate.moistureTrend >= RATE_MOISTURE_TREND_PCT_PER_MIN;
+  return near || rising ? RATE_WATCH : RATE_SAFE;
+}
+
+bool adaptiveRateUpdate(AdaptiveRate &rate, const RiskThresholds &thresholds, RiskLevel level,
+                        const SensorSample &sample, uint32_t nowMs) {
+  updateTrend(rate, fastMaxAbs(sample.angleX, sample.angleY), sample.soilMoisture * 100, nowMs);
+  RateProfile target = targetProfile(rate, thresholds, level, sample);
+
+  // Lower values are more urgent
+  if (target <= rate.profile) {
+    rate.holdUntilMs = nowMs + RATE_HOLD_MS;
+    if (target == rate.profile) return false;
+  } else if ((int32_t)(nowMs - rate.holdUntilMs) < 0) {
+    return false;
+  } else {
+    target = (RateProfile)(rate.profile + 1);
+    rate.holdUntilMs = nowMs + RATE_HOLD_MS;
+  }
+  rate.profile = target;
+  rate.profileSinceMs = nowMs;
+  rate.transitions++;
+  return true;
+}
@@ -0,0 +1,55 @@
+#include "alarm_path.h"
+#include "risk.h"
+
+static const uint32_t bucketLimitsUs[ALARM_LATENCY_BUCKETS] = {
+  100, 250, 500, 1000, 2000, 5000, ALARM_DEADLINE_US, UINT32_MAX
+};
+
+bool alarmFastTrigger(const RuntimeConfig &config, const SensorSample &sample) {
+  if (config.mode == MODE_SILENT) return false;
+  return riskDangerReading(config.thresholds, sample.angleX, sample.angleY, sample.soilMoisture,
+                           sample.rain, sample.vibrationRMS);
+}
+
+void alarmStateInit(AlarmState &state) {
+  state.loopRequest = false;
+  state.fastActive = false;
+  state.fastUntilMs = 0;
+  state.outputsOn = false;
+}
+
+void alarmOnFastTrigger(AlarmState &state, uint32_t nowMs) {
+  state.fastActive = true;
+  state.fastUntilMs = nowMs + ALARM_FAST_HOLD_MS;
+}
+
+void alarmOnLoopRequest(AlarmState &state, bool on) {
+  state.loopRequest = on;
+}
+
+bool alarmUpdateOutputs(AlarmState &state, DeviceMode mode, uint32_t nowMs) {
+  if (state.fastActive && (int32_t)(nowMs - state.fastUntilMs) >= 0) state.fastActive = false;
+  state.outputsOn = mode != MODE_SILENT && (state.loopRequest || state.fastActive);
+  return state.outputsOn;
+}
+
+uint32_t alarmHoldRemainingMs(const AlarmState &state, uint32_t nowMs) {
+  if (!state.fastActive) return UINT32_MAX;
+  int32_t left = (int32_t)(state.fastUntilMs - nowMs);
+  return left > 0 ? (uint32_t)left : 0;
+}
+
+void alarmLatencyRecord(AlarmLatency &latency, uint32_t us) {
+  latency.count++;
+  latency.totalUs += us;
+  if (us > latency.maxUs) latency.maxUs = us;
+  if (us > ALARM_DEADLINE_US) latency.deadlineMisses++;
+  int bucket = 0;
+  while (bucket < ALARM_LATENCY_BUCKETS - 1 && us > bucketLimitsUs[bucket]) bucket++;
+  latency.buckets[bucket]++;
+}
+
+uint32_t alarmLatencyBucketLimitUs(int bucket) {
+  if (bucket < 0 || bucket >= ALARM_LATENCY_BUCKETS) return UINT32_MAX;
+  return bucketLimitsUs[bucket];
+}
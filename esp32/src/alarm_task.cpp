@@ -0,0 +1,103 @@
+#include "alarm_task.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "actuators.h"
+#include "heap_monitor.h"
+#include "health_monitor.h"
+
+// Above the sensor task (3) on its core, so a detection preempts
+// everything else there
+#define ALARM_TASK_STACK 2048
+#define ALARM_TASK_PRIORITY 5
+#define ALARM_TASK_CORE 1
+
+#define ALARM_EVENT_FAST 0x01
+#define ALARM_EVENT_LOOP 0x02
+
+static TaskHandle_t alarmTaskHandle = NULL;
+static volatile uint32_t fastAcquiredUs = 0;   // written by the sensor task before notifying
+static volatile bool loopRequest = false;
+static bool lastLoopRequest = false;           // loop task only
+static AlarmLatency endToEnd;                  // acquisition start to outputs written
+static AlarmLatency wakeToOutputs;             // detection to outputs written
+static volatile uint32_t fastDetectedUs = 0;
+static volatile uint32_t fastTriggers = 0;
+
+static void driveOutputs(bool on) {
+  activateBuzzer(on);
+  writeServo1(on ? 0 : 90);
+  writeServo2(on ? 0 : 90);
+}
+
+static void alarmTask(void *param) {
+  AlarmState state;
+  alarmStateInit(state);
+  heapTagTask(HEAP_LOGIC);
+  healthTaskStart(HEALTH_TASK_ALARM);
+  for (;;) {
+    uint32_t hold = alarmHoldRemainingMs(state, millis());
+    // Wakes at least every WATCHDOG_IDLE_WAKE_MS to check in with the watchdog
+    if (hold > WATCHDOG_IDLE_WAKE_MS) hold = WATCHDOG_IDLE_WAKE_MS;
+    uint32_t events = 0;
+    healthTaskIdle(HEALTH_TASK_ALARM);
+    xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(hold) + 1);
+    healthTaskBusy(HEALTH_TASK_ALARM);
+    uint32_t now = millis();
+    if (events & ALARM_EVENT_FAST) alarmOnFastTrigger(state, now);
+    if (events & ALARM_EVENT_LOOP) alarmOnLoopRequest(state, loopRequest);
+
+    bool wasOn = state.outputsOn;
+    bool on = alarmUpdateOutputs(state, getRuntimeConfig().mode, now);
+    if (on == wasOn) continue;
+    driveOutputs(on);
+    if (on && (events & ALARM_EVENT_FAST)) {
+      uint32_t doneUs = (uint32_t)esp_timer_get_time();
+      alarmLatencyRecord(endToEnd, doneUs - fastAcquiredUs);
+      alarmLatencyRecord(wakeToOutputs, doneUs - fastDetectedUs);
+    }
+  }
+}
+
+void startAlarmTask() {
+  if (alarmTaskHandle != NULL) return;
+  xTaskCreatePinnedToCore(alarmTask, "alarm", ALARM_TASK_STACK, NULL,
+                          ALARM_TASK_PRIORITY, &alarmTaskHandle, ALARM_TASK_CORE);
+}
+
+void alarmCheckSample(const SensorSample &sample, uint32_t acquiredUs) {
+  if (alarmTaskHandle == NULL || !alarmFastTrigger(getRuntimeConfig(), sample)) return;
+  fastAcquiredUs = acquiredUs;
+  fastDetectedUs = (uint32_t)esp_timer_get_time();
+  fastTriggers++;
+  xTaskNotify(alarmTaskHandle, ALARM_EVENT_FAST, eSetBits);
+}
+
+void requestAlarmOutputs(bool on) {
+  if (alarmTaskHandle == NULL) {
+    // Before the task runs (boot), drive the outputs directly
+    driveOutputs(on);
+    return;
+  }
+  if (on == lastLoopRequest) return;
+  lastLoopRequest = on;
+  loopRequest = on;
+  xTaskNotify(alarmTaskHandle, ALARM_EVENT_LOOP, eSetBits);
+}
+
+static void printLatency(const char *name, const AlarmLatency &l) {
+  uint32_t count = l.count ? l.count : 1;
+  Serial.printf("  %-14s %u, avg %u max %u us, %u over %u us; <=", name, l.count,
+                (uint32_t)(l.totalUs / count), l.maxUs, l.deadlineMisses, ALARM_DEADLINE_US);
+  for (int i = 0; i < ALARM_LATENCY_BUCKETS - 1; i++) {
+    Serial.printf(" %uus:%u", alarmLatencyBucketLimitUs(i), l.buckets[i]);
+  }
+  Serial.printf(" more:%u\n", l.buckets[ALARM_LATENCY_BUCKETS - 1]);
+}
+
+void printAlarmStats() {
+  Serial.printf("Alarm fast path: %u danger samples\n", fastTriggers);
+  printLatency("end to end", endToEnd);
+  printLatency("detect to out", wakeToOutputs);
+}
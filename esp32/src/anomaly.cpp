@@ -0,0 +1,102 @@
+#include "anomaly.h"
+#include <string.h>
+#include "fastmath.h"
+
+static_assert(sizeof(RiskStatus::anomalyScore) / sizeof(float) == ANOMALY_CHANNEL_COUNT,
+              "RiskStatus carries one score per channel");
+
+// Noise floor per channel after step averaging; keeps a perfectly steady
+// reading from turning the smallest change into a huge z. Soil and rain are
+// whole percents, so one step of the ADC map alone never accumulates.
+static const float sigmaFloor[ANOMALY_CHANNEL_COUNT] = {
+  0.1f,    // tilt, degrees
+  2.0f,    // moisture, percent
+  2.0f,    // rain, percent
+  0.02f,   // vibration, m/s^2
+};
+
+static const float baselineAlpha = 1.0f / ANOMALY_BASELINE_STEPS;
+
+void anomalyInit(AnomalyDetector &detector, uint32_t nowMs) {
+  memset(&detector, 0, sizeof(detector));
+  detector.stepStartMs = nowMs;
+}
+
+static void welfordAdd(ChannelStats &c, float x) {
+  c.count++;
+  float delta = x - c.mean;
+  c.mean += delta / c.count;
+  c.m2 += delta * (x - c.mean);
+}
+
+float anomalyLongRunVariance(const ChannelStats &stats) {
+  return stats.count > 1 ? stats.m2 / (stats.count - 1) : 0;
+}
+
+static void stepChannel(ChannelStats &c, float x, float floor) {
+  welfordAdd(c, x);
+  if (c.count < ANOMALY_WARMUP_STEPS) return;
+  if (c.count == ANOMALY_WARMUP_STEPS) {
+    c.baseline = c.mean;
+    c.variance = anomalyLongRunVariance(c);
+    return;
+  }
+
+  float variance = c.variance > floor * floor ? c.variance : floor * floor;
+  float z = (x - c.baseline) * fastInvSqrt(variance);
+  float cusum = c.cusum + z - ANOMALY_CUSUM_K;
+  if (cusum < 0) cusum = 0;
+  if (cusum > ANOMALY_CUSUM_CAP * ANOMALY_CUSUM_H) cusum = ANOMALY_CUSUM_CAP * ANOMALY_CUSUM_H;
+  c.cusum = cusum;
+  c.score = cusum / ANOMALY_CUSUM_H;
+
+  // Scored before the baseline moves, so a step is measured against the past
+  float diff = x - c.baseline;
+  c.baseline += baselineAlpha * diff;
+  c.variance = (1 - baselineAlpha) * (c.variance + baselineAlpha * diff * diff);
+}
+
+bool anomalyUpdate(AnomalyDetector &detector, const SensorSample &sample, uint32_t nowMs) {
+  detector.stepSums[ANOMALY_TILT] += fastMaxAbs(sample.angleX, sample.angleY);
+  detector.stepSums[ANOMALY_MOISTURE] += sample.soilMoisture * 100;
+  detector.stepSums[ANOMALY_RAIN] += sample.rain * 100;
+  detector.stepSums[ANOMALY_VIBRATION] += sample.vibrationRMS;
+  detector.stepSamples++;
+  if (nowMs - detector.stepStartMs < ANOMALY_STEP_MS) return false;
+
+  uint8_t mask = 0;
+  for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) {
+    float x = detector.stepSums[i] / detector.stepSamples;
+    // NaN from a failed reading would poison every later step
+    if (x == x) stepChannel(detector.channels[i], x, sigmaFloor[i]);
+    if (detector.channels[i].score >= 1.0f) mask |= 1 << i;
+    detector.stepSums[i] = 0;
+  }
+  detector.alarms += __builtin_popcount(mask & ~detector.mask);
+  detector.mask = mask;
+  detector.stepSamples = 0;
+  detector.stepStartMs = nowMs;
+  return true;
+}
+
+void anomalyFillStatus(const AnomalyDetector &detector, RiskStatus &status) {
+  status.anomalyMask = detector.mask;
+  for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) status.anomalyScore[i] = detector.channels[i].score;
+}
+
+const char* anomalyChannelName(AnomalyChannel channel) {
+  switch (channel) {
+    case ANOMALY_TILT: return "tilt";
+    case ANOMALY_MOISTURE: return "moisture";
+    case ANOMALY_RAIN: return "rain";
+    case ANOMALY_VIBRATION: return "vibration";
+    default: return "unknown";
+  }
+}
+
+RiskLevel anomalyRiskLevel(RiskLevel level, uint8_t mask) {
+  if (level != RISK_SAFE) return level;
+  const uint8_t wetting = (1 << ANOMALY_MOISTURE) | (1 << ANOMALY_RAIN);
+  if ((mask & (1 << ANOMALY_TILT)) || (mask & wetting) == wetting) return RISK_WARNING;
+  return level;
+}
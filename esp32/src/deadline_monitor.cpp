@@ -0,0 +1,74 @@
+#include "deadline_monitor.h"
+#include <string.h>
+
+const char* deadlineActionName(DeadlineAction action) {
+  switch (action) {
+    case DEADLINE_OK: return "ok";
+    case DEADLINE_MISS: return "miss";
+    case DEADLINE_SKIP: return "skip";
+    case DEADLINE_DEGRADE: return "degrade";
+    case DEADLINE_RESTART: return "restart";
+    case DEADLINE_REBOOT: return "reboot";
+    case DEADLINE_RESTORE: return "restore";
+    default: return "unknown";
+  }
+}
+
+void deadlineInit(DeadlineMonitor &monitor) {
+  memset(&monitor, 0, sizeof(monitor));
+  monitor.lastMiss = -1;
+  monitor.resetReason = "unknown";
+  monitor.resetItem = -1;
+}
+
+int deadlineAdd(DeadlineMonitor &monitor, const char *name, uint32_t budgetUs, uint8_t allowed) {
+  if (monitor.count >= DEADLINE_MAX_ITEMS || budgetUs == 0) return -1;
+  DeadlineItem &item = monitor.items[monitor.count];
+  memset(&item, 0, sizeof(item));
+  item.name = name;
+  item.budgetUs = budgetUs;
+  item.allowed = allowed;
+  return monitor.count++;
+}
+
+// The escalation a streak has just reached, if any
+static DeadlineAction escalationAt(uint16_t streak) {
+  if (streak >= DEADLINE_REBOOT_STREAK) return DEADLINE_REBOOT;
+  switch (streak) {
+    case DEADLINE_SKIP_STREAK: return DEADLINE_SKIP;
+    case DEADLINE_DEGRADE_STREAK: return DEADLINE_DEGRADE;
+    case DEADLINE_RESTART_STREAK: return DEADLINE_RESTART;
+    default: return DEADLINE_MISS;
+  }
+}
+
+DeadlineAction deadlineCheck(DeadlineMonitor &monitor, int index, uint32_t elapsedUs) {
+  if (index < 0 || index >= monitor.count) return DEADLINE_OK;
+  DeadlineItem &item = monitor.items[index];
+  item.checks++;
+  if (elapsedUs > item.worstUs) item.worstUs = elapsedUs;
+
+  if (elapsedUs <= item.budgetUs) {
+    item.streak = 0;
+    if (item.cleanChecks < UINT16_MAX) item.cleanChecks++;
+    if (item.degraded && item.cleanChecks >= DEADLINE_RECOVER_CHECKS) {
+      item.degraded = false;
+      return DEADLINE_RESTORE;
+    }
+    return DEADLINE_OK;
+  }
+
+  item.misses++;
+  monitor.misses++;
+  monitor.lastMiss = index;
+  item.cleanChecks = 0;
+  if (item.streak < UINT16_MAX) item.streak++;
+
+  DeadlineAction action = escalationAt(item.streak);
+  if (action == DEADLINE_DEGRADE && item.degraded) action = DEADLINE_MISS;
+  if (action == DEADLINE_MISS || !(item.allowed & DEADLINE_ALLOW(action))) return DEADLINE_MISS;
+  if (action == DEADLINE_DEGRADE) item.degraded = true;
+  item.escalations++;
+  if (action > item.worstAction) item.worstAction = action;
+  return action;
+}
@@ -0,0 +1,191 @@
+#include "deep_sleep.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <driver/adc.h>
+#include <esp32/ulp.h>
+#include <soc/rtc_cntl_reg.h>
+#include <sys/time.h>
+#include <string.h>
+#include "sleep_state.h"
+#include "mesh_module.h"
+#include "actuators.h"
+#include "config.h"
+
+#ifndef DEEP_SLEEP_ENABLED
+#define DEEP_SLEEP_ENABLED 0
+#endif
+
+// RTC slow memory words shared with the ULP, ahead of its program. All of
+// it has to fit in the ULP reserve (CONFIG_ULP_COPROC_RESERVE_MEM, 512 bytes).
+enum {
+  ULP_VAR_RAIN_RAW,     // last averaged readings
+  ULP_VAR_SOIL_RAW,
+  ULP_VAR_RAIN_WAKE,    // wake levels from ulpWakeLevels()
+  ULP_VAR_SOIL_WAKE,
+  ULP_VAR_RUNS,         // ULP runs since the CPU went to sleep
+  ULP_VAR_COUNT
+};
+#define ULP_PROGRAM_OFFSET ULP_VAR_COUNT
+#define ULP_RAIN_CHANNEL ADC1_CHANNEL_7  // RAIN_SENSOR, GPIO35
+#define ULP_SOIL_CHANNEL ADC1_CHANNEL_5  // SOIL_MOISTURE, GPIO33
+#define ULP_LABEL_WAKE 1
+
+// Averages four conversions into R1, stores them and branches to the wake
+// when the average is below the wake level (the subtraction overflows)
+#define ULP_SAMPLE_AND_CHECK(channel, rawVar, wakeVar) \
+  I_ADC(R1, 0, channel), \
+  I_ADC(R0, 0, channel), \
+  I_ADDR(R1, R1, R0), \
+  I_ADC(R0, 0, channel), \
+  I_ADDR(R1, R1, R0), \
+  I_ADC(R0, 0, channel), \
+  I_ADDR(R1, R1, R0), \
+  I_RSHI(R1, R1, 2), \
+  I_ST(R1, R3, rawVar), \
+  I_LD(R2, R3, wakeVar), \
+  I_SUBR(R0, R1, R2), \
+  M_BXF(ULP_LABEL_WAKE)
+
+static const ulp_insn_t ulpProgram[] = {
+  I_MOVI(R3, 0),
+  I_LD(R0, R3, ULP_VAR_RUNS),
+  I_ADDI(R0, R0, 1),
+  I_ST(R0, R3, ULP_VAR_RUNS),
+  ULP_SAMPLE_AND_CHECK(ULP_RAIN_CHANNEL, ULP_VAR_RAIN_RAW, ULP_VAR_RAIN_WAKE),
+  ULP_SAMPLE_AND_CHECK(ULP_SOIL_CHANNEL, ULP_VAR_SOIL_RAW, ULP_VAR_SOIL_WAKE),
+  I_HALT(),
+  M_LABEL(ULP_LABEL_WAKE),
+  I_WAKE(),
+  I_HALT(),
+};
+
+static RTC_DATA_ATTR SleepState sleepState;
+static bool resumed = false;
+static uint32_t uploadsSinceWake = 0;
+
+static uint16_t ulpVar(int index) {
+  // The ULP writes the low half word; the high half holds its PC
+  return RTC_SLOW_MEM[index] & 0xFFFF;
+}
+
+static int64_t wallClockUs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static bool startUlp(const UlpWakeLevels &levels) {
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  // Same range analogRead() uses, so the counts compare like for like
+  adc1_config_channel_atten(ULP_RAIN_CHANNEL, ADC_ATTEN_DB_11);
+  adc1_config_channel_atten(ULP_SOIL_CHANNEL, ADC_ATTEN_DB_11);
+  adc1_ulp_enable();
+
+  RTC_SLOW_MEM[ULP_VAR_RAIN_RAW] = 0;
+  RTC_SLOW_MEM[ULP_VAR_SOIL_RAW] = 0;
+  RTC_SLOW_MEM[ULP_VAR_RAIN_WAKE] = levels.rainBelow;
+  RTC_SLOW_MEM[ULP_VAR_SOIL_WAKE] = levels.soilBelow;
+  RTC_SLOW_MEM[ULP_VAR_RUNS] = 0;
+  size_t size = sizeof(ulpProgram) / sizeof(ulp_insn_t);
+  if (ulp_process_macros_and_load(ULP_PROGRAM_OFFSET, ulpProgram, &size) != ESP_OK) return false;
+  ulp_set_wakeup_period(0, DEEP_SLEEP_ULP_PERIOD_MS * 1000UL);
+  return ulp_run(ULP_PROGRAM_OFFSET) == ESP_OK;
+}
+
+static void stopUlp() {
+  // The ULP timer survives the wake; stop it before the CPU uses ADC1 again
+  CLEAR_PERI_REG_MASK(RTC_CNTL_STATE0_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+}
+
+bool deepSleepEnabled() {
+  return DEEP_SLEEP_ENABLED && getMeshRole() == MESH_ROLE_STANDALONE;
+}
+
+bool resumeFromDeepSleep(AdaptiveRate &rate, AnomalyDetector &anomaly) {
+  stopUlp();
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  if (!deepSleepEnabled() || !sleepStateValid(sleepState)) return false;
+  if (cause != ESP_SLEEP_WAKEUP_ULP && cause != ESP_SLEEP_WAKEUP_TIMER) return false;
+
+  uint32_t nowMs = millis();
+  uint32_t elapsedMs = (uint32_t)((wallClockUs() - sleepState.savedAtUs) / 1000);
+  SleepStats &stats = sleepState.stats;
+  if (cause == ESP_SLEEP_WAKEUP_ULP) stats.ulpWakes++;
+  else stats.timerWakes++;
+  stats.sleptS += (elapsedMs > nowMs ? elapsedMs - nowMs : 0) / 1000;
+
+  sleepStateRestore(sleepState, elapsedMs, nowMs, rate, anomaly);
+  // Consumers see the level from before the sleep until the first classification
+  RiskStatus risk = sleepState.risk;
+  risk.timestampMs = nowMs;
+  risk.sampleSequence = 0;
+  publishRiskStatus(risk);
+  sleepStateSeal(sleepState);
+  resumed = true;
+
+  Serial.printf("Woke from deep sleep #%lu (%s) after %lu s; last ULP run: rain %u, soil %u counts (%u runs)\n",
+                (unsigned long)stats.sleeps, cause == ESP_SLEEP_WAKEUP_ULP ? "threshold" : "report due",
+                (unsigned long)(elapsedMs / 1000), ulpVar(ULP_VAR_RAIN_RAW), ulpVar(ULP_VAR_SOIL_RAW),
+                ulpVar(ULP_VAR_RUNS));
+  return true;
+}
+
+bool deepSleepWiFiHint(uint8_t &channel, uint8_t *bssid) {
+  if (!resumed || sleepState.wifiChannel == 0) return false;
+  channel = sleepState.wifiChannel;
+  memcpy(bssid, sleepState.wifiBssid, sizeof(sleepState.wifiBssid));
+  return true;
+}
+
+void deepSleepUploadDone() {
+  uploadsSinceWake++;
+}
+
+void deepSleepIfIdle(const RiskStatus &risk, const AdaptiveRate &rate, const AnomalyDetector &anomaly,
+                     const RiskThresholds &thresholds) {
+  if (!deepSleepEnabled() || !sleepAllowed(risk, millis(), uploadsSinceWake)) return;
+
+  SleepStats stats;
+  if (sleepStateValid(sleepState)) stats = sleepState.stats;
+  else memset(&stats, 0, sizeof(stats));
+  stats.sleeps++;
+  // Cleared first so the padding the CRC covers is deterministic
+  memset(&sleepState, 0, sizeof(sleepState));
+  sleepState.stats = stats;
+  sleepState.savedAtMs = millis();
+  sleepState.savedAtUs = wallClockUs();
+  sleepState.risk = risk;
+  sleepState.rate = rate;
+  sleepState.anomaly = anomaly;
+  if (WiFi.status() == WL_CONNECTED) {
+    sleepState.wifiChannel = WiFi.channel();
+    memcpy(sleepState.wifiBssid, WiFi.BSSID(), sizeof(sleepState.wifiBssid));
+  }
+  sleepStateSeal(sleepState);
+
+  UlpWakeLevels levels = ulpWakeLevels(thresholds);
+  if (!startUlp(levels)) {
+    Serial.println("ULP program failed to start; staying awake");
+    return;
+  }
+  Serial.printf("Deep sleep #%lu: ULP wakes below rain %u / soil %u counts, report in %d s\n",
+                (unsigned long)stats.sleeps, levels.rainBelow, levels.soilBelow, DEEP_SLEEP_REPORT_S);
+  Serial.flush();
+  powerDownDisplay();
+  esp_sleep_enable_ulp_wakeup();
+  esp_sleep_enable_timer_wakeup((uint64_t)DEEP_SLEEP_REPORT_S * 1000000ULL);
+  esp_deep_sleep_start();
+}
+
+void printDeepSleepStats() {
+  if (!deepSleepEnabled()) return;
+  const SleepStats &s = sleepState.stats;
+  if (!sleepStateValid(sleepState)) {
+    Serial.println("Deep sleep: not slept yet");
+    return;
+  }
+  Serial.printf("Deep sleep: %lu sleeps, %lu threshold wakes, %lu report wakes, %lu s asleep, %lu uploads this wake\n",
+                (unsigned long)s.sleeps, (unsigned long)s.ulpWakes, (unsigned long)s.timerWakes,
+                (unsigned long)s.sleptS, (unsigned long)uploadsSinceWake);
+}
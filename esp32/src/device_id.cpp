@@ -0,0 +1,25 @@
+#include "device_id.h"
+#include <Arduino.h>
+
+static char deviceId[DEVICE_ID_MAX] = "";
+
+const char* getDeviceId() {
+  if (deviceId[0] == '\0') {
+    uint64_t mac = ESP.getEfuseMac();
+    // The eFuse MAC is stored little-endian; print it in the usual byte order
+    snprintf(deviceId, sizeof(deviceId), "esp32-%02x%02x%02x%02x%02x%02x",
+             (uint8_t)(mac), (uint8_t)(mac >> 8), (uint8_t)(mac >> 16),
+             (uint8_t)(mac >> 24), (uint8_t)(mac >> 32), (uint8_t)(mac >> 40));
+  }
+  return deviceId;
+}
+
+// RTDB keys may not contain . $ # [ ] or /
+void setDeviceId(const char *id) {
+  size_t n = 0;
+  for (; id[n] != '\0' && n < sizeof(deviceId) - 1; n++) {
+    char c = id[n];
+    deviceId[n] = strchr(".$#[]/", c) ? '_' : c;
+  }
+  deviceId[n] = '\0';
+}
@@ -0,0 +1,77 @@
+#include "espnow_radio.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+struct EspNowRxFrame {
+  uint8_t mac[MESH_MAC_LEN];
+  uint8_t len;
+  uint8_t data[MESH_MAX_PAYLOAD];
+};
+
+static QueueHandle_t rxQueue = NULL;
+static volatile uint32_t rxDroppedFrames = 0;
+
+static void onEspNowReceive(const uint8_t *mac, const uint8_t *data, int len) {
+  if (rxQueue == NULL || len <= 0 || len > MESH_MAX_PAYLOAD) return;
+  EspNowRxFrame frame;
+  memcpy(frame.mac, mac, MESH_MAC_LEN);
+  frame.len = len;
+  memcpy(frame.data, data, len);
+  // Never block the WiFi task; a full queue means the consumer is behind
+  if (xQueueSend(rxQueue, &frame, 0) != pdTRUE) rxDroppedFrames++;
+}
+
+EspNowRadio::EspNowRadio(uint8_t channel) : channel(channel) {}
+
+bool EspNowRadio::begin() {
+  if (rxQueue == NULL) {
+    rxQueue = xQueueCreate(ESPNOW_RX_QUEUE_LENGTH, sizeof(EspNowRxFrame));
+    if (rxQueue == NULL) return false;
+  }
+  // A gateway keeps the channel of its access point; a leaf has no AP and
+  // is pinned to the mesh channel, which must match the gateway's AP
+  if (WiFi.status() != WL_CONNECTED) {
+    WiFi.mode(WIFI_STA);
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+  }
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("ESP-NOW init failed");
+    return false;
+  }
+  esp_now_register_recv_cb(onEspNowReceive);
+  return true;
+}
+
+bool EspNowRadio::addPeer(const uint8_t *mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+  esp_now_peer_info_t peer = {};
+  memcpy(peer.peer_addr, mac, MESH_MAC_LEN);
+  peer.channel = 0;  // current channel
+  peer.ifidx = WIFI_IF_STA;
+  peer.encrypt = false;
+  return esp_now_add_peer(&peer) == ESP_OK;
+}
+
+bool EspNowRadio::send(const uint8_t *mac, const uint8_t *data, size_t len) {
+  if (len > MESH_MAX_PAYLOAD) return false;
+  return esp_now_send(mac, data, len) == ESP_OK;
+}
+
+int EspNowRadio::poll(MeshReceiveHandler handler, void *context) {
+  if (rxQueue == NULL) return 0;
+  EspNowRxFrame frame;
+  int count = 0;
+  while (xQueueReceive(rxQueue, &frame, 0) == pdTRUE) {
+    handler(frame.mac, frame.data, frame.len, context);
+    count++;
+  }
+  return count;
+}
+
+uint32_t EspNowRadio::rxDropped() const {
+  return rxDroppedFrames;
+}
@@ -2,49 +2,158 @@
 #include <FirebaseESP32.h>
 #include <Arduino.h>
 #include "sensors.h"
+#include "secure_transport.h"
+#include "device_id.h"
+#include "telemetry.h"
+#include "heap_monitor.h"
+#include <time.h>
 #include "config.h"
 
 FirebaseData firebaseData;
 FirebaseConfig config;
 FirebaseAuth auth;
 
+static String livePath;
+static String historyRoot;
+static String diagnosticsPath;
+static unsigned long lastHistoryUpload = 0;
+static bool historyStarted = false;
+
 void setupFirebase() {
+#ifdef DEVICE_ID
+  setDeviceId(DEVICE_ID);
+#endif
+  livePath = String("/devices/") + getDeviceId() + "/live";
+  historyRoot = String("/devices/") + getDeviceId() + "/history/";
+  diagnosticsPath = String("/devices/") + getDeviceId() + "/diagnostics";
+  Serial.println("Device id: " + String(getDeviceId()));
+
   config.host = FIREBASE_HOST;
   config.signer.tokens.legacy_token = FIREBASE_AUTH;
+  config.cert.data = transportRootCA(TRANSPORT_FIREBASE);
   Firebase.begin(&config, &auth);
   Firebase.reconnectWiFi(true);
+  // Keep the RTDB connection open between uploads so only the first one pays
+  // for the TLS handshake
+  firebaseData.keepAlive(TRANSPORT_KEEPALIVE_IDLE_S, TRANSPORT_KEEPALIVE_INTERVAL_S, TRANSPORT_KEEPALIVE_COUNT);
+}
+
+// Same layout for local and mesh samples so the dashboard and backend read
+// every device alike
+static int buildSampleJson(FirebaseJson &jsonData, const LatestSnapshot &snapshot,
+                           const char *deviceId, time_t ts) {
+  char buffer[TELEMETRY_JSON_MAX];
+  uint32_t epoch = ts >= MIN_VALID_EPOCH ? (uint32_t)ts : 0;
+  int len = formatTelemetryJson(buffer, sizeof(buffer), snapshot, deviceId, epoch);
+  if (len < 0) return -1;
+  jsonData.setJsonData(buffer);
+  return len;
+}
+
+static void historyBucket(time_t ts, char *bucket, size_t size) {
+  struct tm utc;
+  gmtime_r(&ts, &utc);
+  strftime(bucket, size, "%Y%m%d%H", &utc);
+}
+
+int sendDataToFirebase(const LatestSnapshot &snapshot) {
+  if (!Firebase.ready()) return -1;
+  HeapScope heapScope(HEAP_FIREBASE);
+  FirebaseJson jsonData;
+  time_t now = time(nullptr);
+  int len = buildSampleJson(jsonData, snapshot, getDeviceId(), now);
+
+  bool reused = firebaseData.httpConnected();
+  unsigned long start = millis();
+  bool sent = Firebase.setJSON(firebaseData, livePath, jsonData);
+  recordTransportRequest(TRANSPORT_FIREBASE, reused, millis() - start);
+
+  // History is sharded into hourly buckets so no single node grows without
+  // bound and each device only ever appends under its own key. The first
+  // upload after boot always goes in: a node waking from deep sleep sends
+  // only a few before it sleeps again.
+  if (now >= MIN_VALID_EPOCH && (!historyStarted || millis() - lastHistoryUpload >= HISTORY_INTERVAL_MS)) {
+    char bucket[16];
+    historyBucket(now, bucket, sizeof(bucket));
+    Firebase.pushJSON(firebaseData, historyRoot + bucket, jsonData);
+    lastHistoryUpload = millis();
+    historyStarted = true;
+  }
+  return sent ? len : -1;
+}
+
+void sendMeshBatchToFirebase(const MeshUpload *uploads, int count) {
+  if (!Firebase.ready()) return;
+  HeapScope heapScope(HEAP_FIREBASE);
+  time_t now = time(nullptr);
+  uint32_t nowMs = millis();
+
+  // One write per device per batch: the newest sample becomes `live`, and
+  // the samples picked for history go in a single PATCH of their bucket.
+  // The documents are built as text in the loop arena and parsed once.
+  for (int i = 0; i < count; i++) {
+    const char *id = uploads[i].deviceId;
+    bool seen = false;
+    for (int j = 0; j < i && !seen; j++) seen = strcmp(uploads[j].deviceId, id) == 0;
+    if (seen) continue;
+
+    size_t mark = arenaMark(loopArena);
+    char *entry = (char *)arenaAlloc(loopArena, TELEMETRY_JSON_MAX);
+    if (entry == NULL) continue;
+    // Allocated last so it grows in place as entries are added
+    ArenaJson history(loopArena, TELEMETRY_JSON_MAX);
+    history.beginObject();
+    int latest = i;
+    int historyCount = 0;
+    char bucket[16] = "";
+    for (int j = i; j < count; j++) {
+      if (strcmp(uploads[j].deviceId, id) != 0) continue;
+      latest = j;
+      if (!uploads[j].history) continue;
+      const SensorSample &sample = uploads[j].snapshot.sample;
+      time_t ts = now - (time_t)((nowMs - sample.timestampMs) / 1000);
+      if (ts < MIN_VALID_EPOCH) continue;
+      if (formatTelemetryJson(entry, TELEMETRY_JSON_MAX, uploads[j].snapshot, id, (uint32_t)ts) < 0) continue;
+      // Entries of one batch share the bucket of the first one
+      if (historyCount == 0) historyBucket(ts, bucket, sizeof(bucket));
+      char key[24];
+      snprintf(key, sizeof(key), "%lu_%lu", (unsigned long)ts, (unsigned long)sample.sequence);
+      history.addRaw(key, entry);
+      historyCount++;
+    }
+    history.endObject();
+
+    const LatestSnapshot &snapshot = uploads[latest].snapshot;
+    FirebaseJson live;
+    buildSampleJson(live, snapshot, id, now - (time_t)((nowMs - snapshot.sample.timestampMs) / 1000));
+    ArenaString path(loopArena);
+    path.appendf("/devices/%s/live", id);
+    bool reused = firebaseData.httpConnected();
+    unsigned long start = millis();
+    Firebase.setJSON(firebaseData, path.c_str(), live);
+    recordTransportRequest(TRANSPORT_FIREBASE, reused, millis() - start);
+    if (historyCount > 0 && !history.truncated()) {
+      FirebaseJson historyJson;
+      historyJson.setJsonData(history.c_str());
+      ArenaString historyPath(loopArena);
+      historyPath.appendf("/devices/%s/history/%s", id, bucket);
+      Firebase.updateNode(firebaseData, historyPath.c_str(), historyJson);
+    } else if (historyCount > 0) {
+      Serial.printf("Mesh history for %s dropped: loop arena full\n", id);
+    }
+    arenaRelease(loopArena, mark);
+  }
 }
 
-void sendDataToFirebase(
-  sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp, float angleX, float angleY, float soilMoistureValue, float rainValue, String riskLevel, bool alertTrigger) {
+void sendDiagnosticsToFirebase(const HeapReport &report, const DeadlineMonitor &deadlines) {
   if (!Firebase.ready()) return;
-  String path = "/";
+  HeapScope heapScope(HEAP_FIREBASE);
+  char *buffer = (char *)arenaAlloc(loopArena, DIAGNOSTICS_JSON_MAX);  // too big for the loop stack
+  if (buffer == NULL) return;
+  time_t now = time(nullptr);
+  uint32_t epoch = now >= MIN_VALID_EPOCH ? (uint32_t)now : 0;
+  if (formatDiagnosticsJson(buffer, DIAGNOSTICS_JSON_MAX, report, deadlines, epoch) < 0) return;
   FirebaseJson jsonData;
-  FirebaseJson sensorsJson;
-  FirebaseJson accelJson;
-  FirebaseJson gyroJson;
-  FirebaseJson tiltJson;
-  FirebaseJson statusJson;
-  accelJson.set("x", round(a.acceleration.x * 100) / 100.0);
-  accelJson.set("y", round(a.acceleration.y * 100) / 100.0);
-  accelJson.set("z", round(a.acceleration.z * 100) / 100.0);
-  sensorsJson.set("accelerometer", accelJson);
-  gyroJson.set("x", round(g.gyro.x * 100) / 100.0);
-  gyroJson.set("y", round(g.gyro.y * 100) / 100.0);
-  gyroJson.set("z", round(g.gyro.z * 100) / 100.0);
-  sensorsJson.set("gyro", gyroJson);
-  sensorsJson.set("vibrationRMS", round(vibrationRMS * 100) / 100.0);
-  sensorsJson.set("soilMoisture", soilMoistureValue);
-  sensorsJson.set("rainfall", rainValue);
-  sensorsJson.set("temperature", round(temp.temperature * 100) / 100.0);
-  tiltJson.set("angleX", round(angleX * 10) / 10.0);
-  tiltJson.set("angleY", round(angleY * 10) / 10.0);
-  tiltJson.set("maxTilt", round(max(abs(angleX), abs(angleY)) * 10) / 10.0);
-  sensorsJson.set("tilt", tiltJson);
-  jsonData.set("sensors", sensorsJson);
-  statusJson.set("landslideRisk", riskLevel);
-  statusJson.set("alertTriggered", alertTrigger);
-  // Optionally add more status fields
-  jsonData.set("status", statusJson);
-  Firebase.setJSON(firebaseData, path, jsonData);
+  jsonData.setJsonData(buffer);
+  Firebase.setJSON(firebaseData, diagnosticsPath, jsonData);
 }
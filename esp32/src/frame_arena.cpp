@@ -0,0 +1,242 @@
+#include "frame_arena.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static char emptyText[1] = "";
+
+static size_t alignUp(size_t offset) {
+  return (offset + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static void *tryAlloc(FrameArena &arena, size_t size) {
+  size_t offset = alignUp(arena.used);
+  if (offset > arena.capacity || size > arena.capacity - offset) return NULL;
+  arena.used = offset + size;
+  if (arena.used > arena.peak) arena.peak = arena.used;
+  return arena.base + offset;
+}
+
+void arenaInit(FrameArena &arena, void *buffer, size_t capacity) {
+  arena.base = (uint8_t *)buffer;
+  arena.capacity = capacity;
+  arena.used = 0;
+  arena.peak = 0;
+  arena.overflows = 0;
+}
+
+void *arenaAlloc(FrameArena &arena, size_t size) {
+  void *block = tryAlloc(arena, size);
+  if (!block) arena.overflows++;
+  return block;
+}
+
+bool arenaExtend(FrameArena &arena, void *block, size_t oldSize, size_t newSize) {
+  uint8_t *start = (uint8_t *)block;
+  if (start == NULL || start + oldSize != arena.base + arena.used) return false;
+  size_t offset = start - arena.base;
+  if (newSize > arena.capacity - offset) return false;
+  arena.used = offset + newSize;
+  if (arena.used > arena.peak) arena.peak = arena.used;
+  return true;
+}
+
+size_t arenaMark(const FrameArena &arena) {
+  return arena.used;
+}
+
+void arenaRelease(FrameArena &arena, size_t mark) {
+  if (mark < arena.used) arena.used = mark;
+}
+
+void arenaReset(FrameArena &arena) {
+  arena.used = 0;
+}
+
+ArenaString::ArenaString(FrameArena &arena, size_t reserve)
+    : arena(&arena), buffer(emptyText), len(0), capacity(0), cut(false) {
+  char *block = reserve ? (char *)tryAlloc(arena, reserve) : NULL;
+  if (block) {
+    buffer = block;
+    buffer[0] = '\0';
+    capacity = reserve;
+  }
+}
+
+// Makes room for `needed` bytes including the terminator. Grows in place
+// while this string is the newest allocation, otherwise moves it; the old
+// copy is reclaimed with the rest of the arena.
+bool ArenaString::grow(size_t needed) {
+  if (needed <= capacity) return true;
+  size_t size = capacity ? capacity * 2 : ARENA_STRING_RESERVE;
+  while (size < needed) size *= 2;
+
+  if (capacity) {
+    if (arenaExtend(*arena, buffer, capacity, size)) {
+      capacity = size;
+      return true;
+    }
+    if (arenaExtend(*arena, buffer, capacity, needed)) {
+      capacity = needed;
+      return true;
+    }
+  }
+  char *moved = (char *)tryAlloc(*arena, size);
+  if (!moved) moved = (char *)tryAlloc(*arena, size = needed);
+  if (!moved) {
+    // Keep whatever is left on top of the arena for a partial append
+    if (capacity) {
+      size_t rest = arena->capacity - (size_t)((uint8_t *)buffer - arena->base);
+      if (rest > capacity && arenaExtend(*arena, buffer, capacity, rest)) capacity = rest;
+    }
+    if (!cut) arena->overflows++;
+    cut = true;
+    return false;
+  }
+  memcpy(moved, buffer, len + 1);
+  buffer = moved;
+  capacity = size;
+  return true;
+}
+
+ArenaString &ArenaString::append(const char *text, size_t count) {
+  if (!grow(len + count + 1)) {
+    size_t room = capacity ? capacity - 1 - len : 0;
+    if (count > room) count = room;
+  }
+  if (count == 0) return *this;
+  memcpy(buffer + len, text, count);
+  len += count;
+  buffer[len] = '\0';
+  return *this;
+}
+
+ArenaString &ArenaString::operator+=(const char *text) {
+  return append(text, strlen(text));
+}
+
+ArenaString &ArenaString::operator+=(char c) {
+  return append(&c, 1);
+}
+
+ArenaString &ArenaString::appendf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  size_t room = capacity ? capacity - len : 0;
+  int n = vsnprintf(room ? buffer + len : NULL, room, format, args);
+  va_end(args);
+  if (n < 0) {
+    va_end(retry);
+    return *this;
+  }
+  if ((size_t)n >= room) {
+    if (grow(len + n + 1)) {
+      vsnprintf(buffer + len, n + 1, format, retry);
+    } else {
+      // vsnprintf already wrote what fits when the buffer did not move
+      room = capacity ? capacity - len : 0;
+      if (room) vsnprintf(buffer + len, room, format, retry);
+      n = room ? room - 1 : 0;
+    }
+  }
+  va_end(retry);
+  len += n;
+  return *this;
+}
+
+ArenaJson::ArenaJson(FrameArena &arena, size_t reserve)
+    : text(arena, reserve), depth(0), hasMembers(0), tooDeep(false) {}
+
+void ArenaJson::writeEscaped(const char *value) {
+  text += '"';
+  const char *run = value;
+  for (const char *p = value; *p; p++) {
+    unsigned char c = (unsigned char)*p;
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    text.append(run, p - run);
+    run = p + 1;
+    switch (c) {
+      case '"': text += "\\\""; break;
+      case '\\': text += "\\\\"; break;
+      case '\n': text += "\\n"; break;
+      case '\r': text += "\\r"; break;
+      case '\t': text += "\\t"; break;
+      default: text.appendf("\\u%04x", c); break;
+    }
+  }
+  text += run;
+  text += '"';
+}
+
+void ArenaJson::writeKey(const char *key) {
+  if (depth > 0) {
+    uint8_t bit = 1 << (depth - 1);
+    if (hasMembers & bit) text += ',';
+    hasMembers |= bit;
+  }
+  if (key) {
+    writeEscaped(key);
+    text += ':';
+  }
+}
+
+ArenaJson &ArenaJson::beginObject(const char *key) {
+  if (depth >= ARENA_JSON_MAX_DEPTH) {
+    tooDeep = true;
+    return *this;
+  }
+  writeKey(key);
+  text += '{';
+  depth++;
+  hasMembers &= ~(1 << (depth - 1));
+  return *this;
+}
+
+ArenaJson &ArenaJson::endObject() {
+  if (depth == 0) {
+    tooDeep = true;
+    return *this;
+  }
+  text += '}';
+  depth--;
+  return *this;
+}
+
+ArenaJson &ArenaJson::addString(const char *key, const char *value) {
+  writeKey(key);
+  writeEscaped(value ? value : "");
+  return *this;
+}
+
+ArenaJson &ArenaJson::addInt(const char *key, long value) {
+  writeKey(key);
+  text.appendf("%ld", value);
+  return *this;
+}
+
+ArenaJson &ArenaJson::addUInt(const char *key, unsigned long value) {
+  writeKey(key);
+  text.appendf("%lu", value);
+  return *this;
+}
+
+ArenaJson &ArenaJson::addFloat(const char *key, float value, int decimals) {
+  writeKey(key);
+  text.appendf("%.*f", decimals, isfinite(value) ? value : 0.0f);
+  return *this;
+}
+
+ArenaJson &ArenaJson::addBool(const char *key, bool value) {
+  writeKey(key);
+  text += value ? "true" : "false";
+  return *this;
+}
+
+ArenaJson &ArenaJson::addRaw(const char *key, const char *json) {
+  writeKey(key);
+  text += json;
+  return *this;
+}
@@ -0,0 +1,50 @@
+#include "fusion.h"
+#include "fastmath.h"
+
+static void accelTilt(float ax, float ay, float az, float &angleX, float &angleY) {
+  angleX = radToDeg(fastAtan2(ax, fastSqrt(ay * ay + az * az)));
+  angleY = radToDeg(fastAtan2(ay, fastSqrt(ax * ax + az * az)));
+}
+
+void fusionInit(TiltFusion &fusion, float dt, float timeConstant, int accelDecimation) {
+  if (accelDecimation < 1) accelDecimation = 1;
+  fusion.accelDecimation = accelDecimation;
+  fusionSetRate(fusion, dt, timeConstant);
+  fusionReset(fusion);
+}
+
+void fusionSetRate(TiltFusion &fusion, float dt, float timeConstant) {
+  fusion.dt = dt;
+  // The correction is applied every `accelDecimation` samples, so its gain is
+  // computed for that longer step to keep the same crossover frequency.
+  float correctionDt = dt * fusion.accelDecimation;
+  fusion.accelGain = correctionDt / (timeConstant + correctionDt);
+}
+
+void fusionReset(TiltFusion &fusion) {
+  fusion.angleX = 0;
+  fusion.angleY = 0;
+  fusion.sampleCount = 0;
+  fusion.initialized = false;
+}
+
+void fusionUpdate(TiltFusion &fusion, float ax, float ay, float az, float gx, float gy) {
+  if (!fusion.initialized) {
+    // Seed from the accelerometer so the filter does not ramp up from zero
+    accelTilt(ax, ay, az, fusion.angleX, fusion.angleY);
+    fusion.initialized = true;
+    return;
+  }
+
+  // angleX is rotation about the sensor Y axis, angleY about the X axis
+  fusion.angleX -= gy * FM_RAD_TO_DEG * fusion.dt;
+  fusion.angleY += gx * FM_RAD_TO_DEG * fusion.dt;
+
+  if (++fusion.sampleCount < fusion.accelDecimation) return;
+  fusion.sampleCount = 0;
+
+  float accelX, accelY;
+  accelTilt(ax, ay, az, accelX, accelY);
+  fusion.angleX += fusion.accelGain * (accelX - fusion.angleX);
+  fusion.angleY += fusion.accelGain * (accelY - fusion.angleY);
+}
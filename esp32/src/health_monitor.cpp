@@ -0,0 +1,219 @@
+#include "health_monitor.h"
+#include <Arduino.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <esp_attr.h>
+#include "sensors.h"
+
+#define HEALTH_TRACE_MAGIC 0x48544831u  // "HTH1"
+
+// Survives the watchdog and software resets (not power loss): which items
+// were in progress, and since when, so the next boot can name the one that
+// hung. Each slot is written by the one task that owns the item.
+struct HealthTrace {
+  uint32_t magic;
+  uint32_t busySinceMs[DEADLINE_MAX_ITEMS];   // 0 while idle
+  int32_t rebootItem;                         // soft deadline reboot, -1 for none
+};
+
+static RTC_NOINIT_ATTR HealthTrace trace;
+
+struct TaskPolicy {
+  const char *name;
+  uint32_t budgetUs;   // one cycle of work
+  uint8_t allowed;
+  void (*restart)();
+};
+
+// Registered first, so task items keep the same index on every boot
+static const TaskPolicy taskPolicies[HEALTH_TASK_COUNT] = {
+  { "sensors", 20000, DEADLINE_ALLOW(DEADLINE_RESTART) | DEADLINE_ALLOW(DEADLINE_REBOOT), requestSensorRestart },
+  { "alarm", 20000, DEADLINE_ALLOW(DEADLINE_REBOOT), NULL },
+  { "recorder", 2000000, 0, NULL },       // a flash flush can take a while
+  { "telegram", 15000000, 0, NULL },      // HTTPS round trips to Telegram
+};
+
+static DeadlineMonitor deadlines;       // loop task only
+static LoopScheduler *watchedScheduler = NULL;
+static int stageItems[SCHED_MAX_STAGES];
+static void (*stageRestarts[SCHED_MAX_STAGES])();
+static volatile uint32_t taskCycleMaxUs[HEALTH_TASK_COUNT];   // longest finished cycle since the last check
+static uint32_t taskCycleStartUs[HEALTH_TASK_COUNT];          // owned by each task
+static uint32_t lastTaskCheckMs = 0;
+static uint32_t restarts = 0;
+
+static const char* resetReasonName(esp_reset_reason_t reason) {
+  switch (reason) {
+    case ESP_RST_POWERON: return "power_on";
+    case ESP_RST_EXT: return "external";
+    case ESP_RST_SW: return "software";
+    case ESP_RST_PANIC: return "panic";
+    case ESP_RST_INT_WDT: return "int_wdt";
+    case ESP_RST_TASK_WDT: return "task_wdt";
+    case ESP_RST_WDT: return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deep_sleep";
+    case ESP_RST_BROWNOUT: return "brownout";
+    default: return "unknown";
+  }
+}
+
+// The item in progress the longest when the last boot ended
+static int hungItem() {
+  int item = -1;
+  uint32_t oldest = 0;
+  for (int i = 0; i < DEADLINE_MAX_ITEMS; i++) {
+    uint32_t since = trace.busySinceMs[i];
+    if (since == 0) continue;
+    if (item < 0 || (int32_t)(since - oldest) < 0) {
+      item = i;
+      oldest = since;
+    }
+  }
+  return item;
+}
+
+void setupHealthMonitor() {
+  deadlineInit(deadlines);
+  for (int i = 0; i < SCHED_MAX_STAGES; i++) stageItems[i] = -1;
+  for (int i = 0; i < HEALTH_TASK_COUNT; i++) {
+    const TaskPolicy &p = taskPolicies[i];
+    deadlineAdd(deadlines, p.name, p.budgetUs, p.allowed);
+  }
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  deadlines.resetReason = resetReasonName(reason);
+  if (trace.magic == HEALTH_TRACE_MAGIC) {
+    if (reason == ESP_RST_SW && trace.rebootItem >= 0) {
+      deadlines.resetReason = "deadline";
+      deadlines.resetItem = trace.rebootItem;
+    } else if (reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_PANIC) {
+      deadlines.resetItem = hungItem();
+    }
+  }
+  memset(&trace, 0, sizeof(trace));
+  trace.magic = HEALTH_TRACE_MAGIC;
+  trace.rebootItem = -1;
+  Serial.printf("Last reset: %s\n", deadlines.resetReason);
+
+  // Reconfigures the watchdog the core already runs for the idle tasks
+  esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+}
+
+static void rebootFor(int item) {
+  Serial.printf("Deadline: %s keeps overrunning, rebooting\n", deadlines.items[item].name);
+  trace.rebootItem = item;
+  Serial.flush();
+  esp_restart();
+}
+
+static void escalate(int item, DeadlineAction action, int stage, void (*restart)()) {
+  if (action == DEADLINE_OK || action == DEADLINE_MISS) return;
+  if (action != DEADLINE_RESTORE) {
+    Serial.printf("Deadline: %s over %lu us %u times running, %s\n", deadlines.items[item].name,
+                  (unsigned long)deadlines.items[item].budgetUs, deadlines.items[item].streak,
+                  deadlineActionName(action));
+  }
+  switch (action) {
+    case DEADLINE_SKIP:
+      if (stage >= 0) schedulerSkipNext(*watchedScheduler, stage);
+      break;
+    case DEADLINE_DEGRADE:
+      if (stage >= 0) schedulerSetDegrade(*watchedScheduler, stage, 1);
+      break;
+    case DEADLINE_RESTORE:
+      if (stage >= 0) schedulerSetDegrade(*watchedScheduler, stage, 0);
+      break;
+    case DEADLINE_RESTART:
+      if (restart) {
+        restarts++;
+        restart();
+      }
+      break;
+    case DEADLINE_REBOOT:
+      rebootFor(item);
+      break;
+    default:
+      break;
+  }
+}
+
+static void checkTasks() {
+  uint32_t now = millis();
+  uint32_t nowUs = micros();
+  for (int i = 0; i < HEALTH_TASK_COUNT; i++) {
+    uint32_t worst = __atomic_exchange_n(&taskCycleMaxUs[i], 0, __ATOMIC_RELAXED);
+    // A cycle still running counts with the time it has taken so far
+    if (trace.busySinceMs[i] != 0) {
+      uint32_t running = nowUs - taskCycleStartUs[i];
+      if (running > worst) worst = running;
+    }
+    escalate(i, deadlineCheck(deadlines, i, worst), -1, taskPolicies[i].restart);
+  }
+  lastTaskCheckMs = now;
+}
+
+static void beforeStage(int stage, uint32_t runUs) {
+  int item = stageItems[stage];
+  if (item >= 0) trace.busySinceMs[item] = millis() | 1;
+}
+
+static void afterStage(int stage, uint32_t runUs) {
+  esp_task_wdt_reset();
+  int item = stageItems[stage];
+  if (item >= 0) {
+    trace.busySinceMs[item] = 0;
+    escalate(item, deadlineCheck(deadlines, item, runUs), stage, stageRestarts[stage]);
+  }
+  if (millis() - lastTaskCheckMs >= HEALTH_TASK_CHECK_MS) checkTasks();
+}
+
+void healthWatchStage(LoopScheduler &scheduler, int stage, uint32_t budgetUs, uint8_t allowed,
+                      void (*restart)()) {
+  if (stage < 0 || stage >= SCHED_MAX_STAGES) return;
+  stageItems[stage] = deadlineAdd(deadlines, scheduler.stages[stage].name, budgetUs, allowed);
+  stageRestarts[stage] = restart;
+}
+
+void startHealthMonitor(LoopScheduler &scheduler) {
+  watchedScheduler = &scheduler;
+  lastTaskCheckMs = millis();
+  schedulerSetHooks(scheduler, beforeStage, afterStage);
+  esp_task_wdt_add(NULL);
+}
+
+void healthTaskStart(HealthTask task) {
+  esp_task_wdt_add(NULL);
+}
+
+void healthTaskBusy(HealthTask task) {
+  esp_task_wdt_reset();
+  taskCycleStartUs[task] = micros();
+  trace.busySinceMs[task] = millis() | 1;
+}
+
+void healthTaskIdle(HealthTask task) {
+  esp_task_wdt_reset();
+  if (trace.busySinceMs[task] == 0) return;
+  trace.busySinceMs[task] = 0;
+  uint32_t cycle = micros() - taskCycleStartUs[task];
+  if (cycle > taskCycleMaxUs[task]) taskCycleMaxUs[task] = cycle;
+}
+
+const DeadlineMonitor& healthDeadlines() {
+  return deadlines;
+}
+
+void printHealthStats() {
+  const char *last = deadlines.lastMiss >= 0 ? deadlines.items[deadlines.lastMiss].name : "none";
+  const char *resetIn = deadlines.resetItem >= 0 && deadlines.resetItem < deadlines.count ? deadlines.items[deadlines.resetItem].name : "-";
+  Serial.printf("Deadlines: %lu misses, last %s, %lu restarts; last reset %s in %s\n",
+                (unsigned long)deadlines.misses, last, (unsigned long)restarts, deadlines.resetReason, resetIn);
+  for (int i = 0; i < deadlines.count; i++) {
+    const DeadlineItem &item = deadlines.items[i];
+    if (item.misses == 0) continue;
+    Serial.printf("  %-9s budget %lu us, %lu misses of %lu, worst %lu us, %s%s\n", item.name,
+                  (unsigned long)item.budgetUs, (unsigned long)item.misses, (unsigned long)item.checks,
+                  (unsigned long)item.worstUs, deadlineActionName((DeadlineAction)item.worstAction),
+                  item.degraded ? " (degraded)" : "");
+  }
+}
@@ -0,0 +1,158 @@
+#include "heap_monitor.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct TaskTag {
+  TaskHandle_t task;
+  HeapSubsystem tag;
+};
+
+static TaskTag taskTags[HEAP_MAX_TAGGED_TASKS];
+static volatile int taskTagCount = 0;
+static portMUX_TYPE taskTagLock = portMUX_INITIALIZER_UNLOCKED;
+static HeapSubsystemStats stats[HEAP_SUBSYSTEM_COUNT];
+
+static uint8_t loopArenaBuffer[LOOP_ARENA_BYTES] __attribute__((aligned(ARENA_ALIGN)));
+static uint8_t telegramArenaBuffer[TELEGRAM_ARENA_BYTES] __attribute__((aligned(ARENA_ALIGN)));
+FrameArena loopArena = { loopArenaBuffer, sizeof(loopArenaBuffer), 0, 0, 0 };
+FrameArena telegramArena = { telegramArenaBuffer, sizeof(telegramArenaBuffer), 0, 0, 0 };
+
+static int findTaskTag(TaskHandle_t task) {
+  for (int i = 0; i < taskTagCount; i++) {
+    if (taskTags[i].task == task) return i;
+  }
+  return -1;
+}
+
+static HeapSubsystem currentTag() {
+  int index = findTaskTag(xTaskGetCurrentTaskHandle());
+  return index < 0 ? HEAP_SYSTEM : taskTags[index].tag;
+}
+
+// Only the owning task changes its own entry; adding one is locked
+static void setCurrentTag(HeapSubsystem subsystem) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  int index = findTaskTag(task);
+  if (index >= 0) {
+    taskTags[index].tag = subsystem;
+    return;
+  }
+  portENTER_CRITICAL(&taskTagLock);
+  if (taskTagCount < HEAP_MAX_TAGGED_TASKS) {
+    taskTags[taskTagCount].task = task;
+    taskTags[taskTagCount].tag = subsystem;
+    __atomic_store_n(&taskTagCount, taskTagCount + 1, __ATOMIC_RELEASE);
+  }
+  portEXIT_CRITICAL(&taskTagLock);
+}
+
+void heapTagTask(HeapSubsystem subsystem) {
+  setCurrentTag(subsystem);
+}
+
+HeapScope::HeapScope(HeapSubsystem subsystem)
+  : subsystem(subsystem), previous(currentTag()), freeAtStart(heap_caps_get_free_size(MALLOC_CAP_8BIT)) {
+  setCurrentTag(subsystem);
+}
+
+HeapScope::~HeapScope() {
+  int32_t delta = (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT) - (int32_t)freeAtStart;
+  __atomic_fetch_add(&stats[subsystem].scopeDelta, delta, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&stats[subsystem].scopes, 1, __ATOMIC_RELAXED);
+  setCurrentTag(previous);
+}
+
+#ifdef HEAP_TRACK_ALLOCATIONS
+static void countAlloc(size_t size) {
+  HeapSubsystemStats &s = stats[currentTag()];
+  __atomic_fetch_add(&s.allocs, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&s.allocBytes, size, __ATOMIC_RELAXED);
+}
+
+static void countFree(size_t size) {
+  HeapSubsystemStats &s = stats[currentTag()];
+  __atomic_fetch_add(&s.frees, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&s.freeBytes, size, __ATOMIC_RELAXED);
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+  void *ptr = __real_malloc(size);
+  if (ptr) countAlloc(size);
+  return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  void *ptr = __real_calloc(count, size);
+  if (ptr) countAlloc(count * size);
+  return ptr;
+}
+
+// String growth goes through here; it is the main source of churn
+void *__wrap_realloc(void *ptr, size_t size) {
+  size_t oldSize = ptr ? heap_caps_get_allocated_size(ptr) : 0;
+  void *result = __real_realloc(ptr, size);
+  if (ptr && (result || size == 0)) countFree(oldSize);
+  if (result && size) countAlloc(size);
+  return result;
+}
+
+void __wrap_free(void *ptr) {
+  if (ptr) countFree(heap_caps_get_allocated_size(ptr));
+  __real_free(ptr);
+}
+}
+#endif
+
+void heapCollect(HeapReport &report) {
+  report.uptimeS = millis() / 1000;
+  report.freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  report.minFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  report.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+#ifdef HEAP_TRACK_ALLOCATIONS
+  report.allocTracking = true;
+#else
+  report.allocTracking = false;
+#endif
+  for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; i++) {
+    HeapSubsystemStats &s = report.subsystems[i];
+    s.allocs = __atomic_load_n(&stats[i].allocs, __ATOMIC_RELAXED);
+    s.allocBytes = __atomic_load_n(&stats[i].allocBytes, __ATOMIC_RELAXED);
+    s.frees = __atomic_load_n(&stats[i].frees, __ATOMIC_RELAXED);
+    s.freeBytes = __atomic_load_n(&stats[i].freeBytes, __ATOMIC_RELAXED);
+    s.scopes = __atomic_load_n(&stats[i].scopes, __ATOMIC_RELAXED);
+    s.scopeDelta = __atomic_load_n(&stats[i].scopeDelta, __ATOMIC_RELAXED);
+  }
+  // Word-sized reads of another task's arena; good enough for a report
+  const FrameArena *arenas[HEAP_ARENA_COUNT] = { &loopArena, &telegramArena };
+  for (int i = 0; i < HEAP_ARENA_COUNT; i++) {
+    report.arenas[i].capacity = arenas[i]->capacity;
+    report.arenas[i].peak = arenas[i]->peak;
+    report.arenas[i].overflows = arenas[i]->overflows;
+  }
+}
+
+void printHeapReport(const HeapReport &report) {
+  Serial.printf("Heap: free %u, min %u, largest block %u (%u%% fragmented)\n",
+                report.freeBytes, report.minFreeBytes, report.largestFreeBlock,
+                heapFragmentationPct(report.freeBytes, report.largestFreeBlock));
+  for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; i++) {
+    const HeapSubsystemStats &s = report.subsystems[i];
+    if (s.allocs == 0 && s.scopes == 0) continue;
+    Serial.printf("  %-9s allocs %u (%u B), frees %u (%u B), scope delta %d B over %u\n",
+                  heapSubsystemName((HeapSubsystem)i), s.allocs, s.allocBytes,
+                  s.frees, s.freeBytes, s.scopeDelta, s.scopes);
+  }
+  for (int i = 0; i < HEAP_ARENA_COUNT; i++) {
+    const HeapArenaStats &a = report.arenas[i];
+    Serial.printf("  arena %-9s peak %u of %u B, overflows %u\n",
+                  heapArenaName((HeapArena)i), a.peak, a.capacity, a.overflows);
+  }
+}
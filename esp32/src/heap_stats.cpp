@@ -0,0 +1,28 @@
+#include "heap_stats.h"
+
+const char* heapSubsystemName(HeapSubsystem subsystem) {
+  switch (subsystem) {
+    case HEAP_SYSTEM: return "system";
+    case HEAP_SENSORS: return "sensors";
+    case HEAP_LOGIC: return "logic";
+    case HEAP_DISPLAY: return "display";
+    case HEAP_FIREBASE: return "firebase";
+    case HEAP_TELEGRAM: return "telegram";
+    case HEAP_CONFIG: return "config";
+    case HEAP_MESH: return "mesh";
+    default: return "unknown";
+  }
+}
+
+const char* heapArenaName(HeapArena arena) {
+  switch (arena) {
+    case ARENA_LOOP: return "loop";
+    case ARENA_TELEGRAM: return "telegram";
+    default: return "unknown";
+  }
+}
+
+uint8_t heapFragmentationPct(uint32_t freeBytes, uint32_t largestFreeBlock) {
+  if (freeBytes == 0 || largestFreeBlock >= freeBytes) return 0;
+  return (uint8_t)(100 - (uint64_t)largestFreeBlock * 100 / freeBytes);
+}
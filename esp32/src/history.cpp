@@ -0,0 +1,166 @@
+#include "history.h"
+#include <string.h>
+#include "fastmath.h"
+
+static const uint32_t levelPeriodMs[HISTORY_LEVEL_COUNT] = { 1000, 60000, 3600000 };
+static const uint16_t levelCapacity[HISTORY_LEVEL_COUNT] = { HISTORY_SECONDS, HISTORY_MINUTES, HISTORY_HOURS };
+
+void historyInit(SensorHistory &history) {
+  memset(&history, 0, sizeof(history));
+  uint16_t offset = 0;
+  for (int i = 0; i < HISTORY_LEVEL_COUNT; i++) {
+    history.rings[i].offset = offset;
+    history.rings[i].capacity = levelCapacity[i];
+    offset += levelCapacity[i];
+  }
+}
+
+uint16_t historyCount(const SensorHistory &history, HistoryLevel level) {
+  return level < HISTORY_LEVEL_COUNT ? history.rings[level].count : 0;
+}
+
+const HistoryBucket* historyAt(const SensorHistory &history, HistoryLevel level, uint16_t age) {
+  if (level >= HISTORY_LEVEL_COUNT) return NULL;
+  const HistoryRing &ring = history.rings[level];
+  if (age >= ring.count) return NULL;
+  uint16_t index = (ring.head + ring.capacity - 1 - age) % ring.capacity;
+  return &history.buckets[ring.offset + index];
+}
+
+// Refits the last HISTORY_RATE_WINDOW minute means (x = 0 for the oldest).
+// Summed afresh each minute, O(30), so rounding never builds up the way
+// sliding float sums do over weeks of uptime. y is taken relative to the
+// oldest point, which leaves the slope alone and keeps the sums small.
+static void slopeRefit(const SensorHistory &history, SlopeWindow &fit, HistoryChannel channel) {
+  uint16_t n = historyCount(history, HISTORY_LEVEL_MINUTES);
+  if (n > HISTORY_RATE_WINDOW) n = HISTORY_RATE_WINDOW;
+  memset(&fit, 0, sizeof(fit));
+  if (n == 0) return;
+  float origin = historyAt(history, HISTORY_LEVEL_MINUTES, n - 1)->channels[channel].mean;
+  for (uint16_t x = 0; x < n; x++) {
+    float y = historyAt(history, HISTORY_LEVEL_MINUTES, n - 1 - x)->channels[channel].mean - origin;
+    fit.sumX += x;
+    fit.sumY += y;
+    fit.sumXY += x * y;
+    fit.sumXX += (float)x * x;
+  }
+  fit.n = n;
+}
+
+// Per point (minute), or 0 when the fit is degenerate
+static float slopePerPoint(const SlopeWindow &fit) {
+  float n = fit.n;
+  float denominator = n * fit.sumXX - fit.sumX * fit.sumX;
+  if (fit.n < 2 || denominator <= 0) return 0;
+  return (n * fit.sumXY - fit.sumX * fit.sumY) / denominator;
+}
+
+static void onSecond(SensorHistory &history, const HistoryBucket &bucket, uint32_t endMs) {
+  float rain = bucket.channels[HISTORY_RAIN].mean;
+  if (rain >= HISTORY_RAIN_WET) {
+    history.raining = true;
+    history.lastWetMs = endMs;
+  } else if (history.raining && endMs - history.lastWetMs >= HISTORY_RAIN_DRY_MS) {
+    history.raining = false;
+    history.rainEventHours = 0;
+  }
+  if (history.raining && history.rainEventHours < HISTORY_RAIN_EVENT_MAX_H) {
+    history.rainEventHours += rain / 100 * (levelPeriodMs[HISTORY_LEVEL_SECONDS] / 3600000.0f);
+  }
+}
+
+static void onMinute(SensorHistory &history) {
+  slopeRefit(history, history.tiltFit, HISTORY_TILT);
+  slopeRefit(history, history.moistureFit, HISTORY_MOISTURE);
+}
+
+static void onHour(SensorHistory &history) {
+  const HistoryRing &ring = history.rings[HISTORY_LEVEL_HOURS];
+  history.rain24hHours += historyAt(history, HISTORY_LEVEL_HOURS, 0)->channels[HISTORY_RAIN].mean / 100;
+  if (ring.count > 24) {
+    history.rain24hHours -= historyAt(history, HISTORY_LEVEL_HOURS, 24)->channels[HISTORY_RAIN].mean / 100;
+  }
+  if (history.rain24hHours < 0) history.rain24hHours = 0;  // rounding
+}
+
+static void addToLevel(SensorHistory &history, int level, const HistoryPartial &in, uint32_t nowMs);
+
+static void closeLevel(SensorHistory &history, int level, uint32_t nowMs) {
+  HistoryRing &ring = history.rings[level];
+  HistoryPartial closed = ring.partial;
+  ring.partial.samples = 0;
+
+  HistoryBucket &bucket = history.buckets[ring.offset + ring.head];
+  bucket.startMs = closed.startMs;
+  for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+    bucket.channels[c].min = closed.min[c];
+    bucket.channels[c].max = closed.max[c];
+    bucket.channels[c].mean = closed.sum[c] / closed.samples;
+  }
+  ring.head = (ring.head + 1) % ring.capacity;
+  if (ring.count < ring.capacity) ring.count++;
+
+  switch (level) {
+    case HISTORY_LEVEL_SECONDS: onSecond(history, bucket, nowMs); break;
+    case HISTORY_LEVEL_MINUTES: onMinute(history); break;
+    case HISTORY_LEVEL_HOURS: onHour(history); break;
+  }
+  if (level + 1 < HISTORY_LEVEL_COUNT) addToLevel(history, level + 1, closed, nowMs);
+}
+
+// Folds `in` (one sample or one closed bucket of the level below) into the
+// level's open bucket. A bucket closes when `in` starts a period after it
+// (a sample, or a gap), or as soon as the bucket below that completes it
+// arrives, so the coarse levels do not lag a period behind.
+static void addToLevel(SensorHistory &history, int level, const HistoryPartial &in, uint32_t nowMs) {
+  HistoryPartial &p = history.rings[level].partial;
+  if (p.samples && in.startMs - p.startMs >= levelPeriodMs[level]) closeLevel(history, level, nowMs);
+  if (p.samples == 0) {
+    p = in;
+  } else {
+    for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+      if (in.min[c] < p.min[c]) p.min[c] = in.min[c];
+      if (in.max[c] > p.max[c]) p.max[c] = in.max[c];
+      p.sum[c] += in.sum[c];
+    }
+    p.samples += in.samples;
+  }
+  if (level > 0 && in.startMs + levelPeriodMs[level - 1] - p.startMs >= levelPeriodMs[level]) {
+    closeLevel(history, level, nowMs);
+  }
+}
+
+void historyAdd(SensorHistory &history, const SensorSample &sample, uint32_t nowMs) {
+  float values[HISTORY_CHANNEL_COUNT];
+  values[HISTORY_TILT] = fastMaxAbs(sample.angleX, sample.angleY);
+  values[HISTORY_MOISTURE] = sample.soilMoisture * 100;
+  values[HISTORY_RAIN] = sample.rain * 100;
+  values[HISTORY_VIBRATION] = sample.vibrationRMS;
+  HistoryPartial in;
+  in.startMs = nowMs;
+  in.samples = 1;
+  for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+    // NaN from a failed reading would stick in every aggregate above it
+    float v = values[c] == values[c] ? values[c] : 0;
+    in.min[c] = in.max[c] = in.sum[c] = v;
+  }
+  addToLevel(history, HISTORY_LEVEL_SECONDS, in, nowMs);
+}
+
+void historyFeatures(const SensorHistory &history, TrendFeatures &features) {
+  features.ratesValid = history.tiltFit.n >= HISTORY_RATE_MIN_POINTS;
+  features.tiltVelocity = features.ratesValid ? slopePerPoint(history.tiltFit) * 60 : 0;
+  features.moistureRate = features.ratesValid ? slopePerPoint(history.moistureFit) * 60 : 0;
+  features.rainEventHours = history.raining ? history.rainEventHours : 0;
+  features.rain24hHours = history.rain24hHours;
+}
+
+const char* historyChannelName(HistoryChannel channel) {
+  switch (channel) {
+    case HISTORY_TILT: return "tilt";
+    case HISTORY_MOISTURE: return "moisture";
+    case HISTORY_RAIN: return "rain";
+    case HISTORY_VIBRATION: return "vibration";
+    default: return "unknown";
+  }
+}
@@ -0,0 +1,214 @@
+#include "i2c_bus.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// Above the sensor task (3) on its core, so a queued sensor read starts at
+// once; below the alarm task (5)
+#define I2C_TASK_STACK 2048
+#define I2C_TASK_PRIORITY 4
+#define I2C_TASK_CORE 1
+
+struct I2cJob {
+  uint8_t device;
+  uint8_t address;
+  uint8_t txLen;
+  uint8_t rxLen;
+  uint8_t tx[I2C_ASYNC_MAX_BYTES];
+  uint8_t *rx;
+  I2cDone done;
+  void *arg;
+  uint32_t queuedUs;
+};
+
+struct I2cDeviceStats {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t errors;
+  uint32_t maxWaitUs;     // queued to started
+  uint64_t busyUs;        // bus held, including Wire calls under I2cBusLock
+};
+
+static const char *const deviceNames[I2C_DEVICE_COUNT] = { "mpu6050", "lcd", "other" };
+
+static TaskHandle_t busTaskHandle = NULL;
+static QueueHandle_t sensorQueue = NULL;
+static QueueHandle_t displayQueue = NULL;
+static SemaphoreHandle_t busMutex = NULL;
+static uint32_t busClockHz = 0;                  // under busMutex
+static I2cDeviceStats stats[I2C_DEVICE_COUNT];   // under busMutex
+static uint32_t windowStartUs = 0;
+static uint32_t displayDropped = 0;
+
+static void setClockFor(uint8_t device) {
+  uint32_t clock = device == I2C_DEVICE_MPU6050 ? I2C_BUS_CLOCK_HZ : I2C_SLOW_CLOCK_HZ;
+  if (clock == busClockHz) return;
+  Wire.setClock(clock);
+  busClockHz = clock;
+}
+
+static void account(uint8_t device, uint32_t startUs, uint32_t bytes, bool ok) {
+  I2cDeviceStats &s = stats[device];
+  s.transactions++;
+  s.bytes += bytes;
+  if (!ok) s.errors++;
+  s.busyUs += micros() - startUs;
+}
+
+static bool runJob(const I2cJob &job) {
+  Wire.beginTransmission(job.address);
+  Wire.write(job.tx, job.txLen);
+  if (job.rxLen == 0) return Wire.endTransmission() == 0;
+  if (Wire.endTransmission(false) != 0) return false;
+  if (Wire.requestFrom(job.address, job.rxLen) != job.rxLen) return false;
+  for (int i = 0; i < job.rxLen; i++) job.rx[i] = Wire.read();
+  return true;
+}
+
+static void execute(const I2cJob &job) {
+  xSemaphoreTake(busMutex, portMAX_DELAY);
+  uint32_t start = micros();
+  uint32_t wait = start - job.queuedUs;
+  if (wait > stats[job.device].maxWaitUs) stats[job.device].maxWaitUs = wait;
+  setClockFor(job.device);
+  bool ok = runJob(job);
+  account(job.device, start, job.txLen + job.rxLen, ok);
+  xSemaphoreGive(busMutex);
+  if (job.done) job.done(ok, job.arg);
+}
+
+static void busTask(void *param) {
+  I2cJob job;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // The sensor queue is looked at again before every display chunk
+    while (xQueueReceive(sensorQueue, &job, 0) == pdTRUE ||
+           xQueueReceive(displayQueue, &job, 0) == pdTRUE) {
+      execute(job);
+    }
+  }
+}
+
+void setupI2cBus() {
+  if (busTaskHandle != NULL) return;
+  Wire.begin();
+  Wire.setClock(I2C_BUS_CLOCK_HZ);
+  busClockHz = I2C_BUS_CLOCK_HZ;
+  busMutex = xSemaphoreCreateMutex();
+  sensorQueue = xQueueCreate(I2C_SENSOR_QUEUE_LENGTH, sizeof(I2cJob));
+  displayQueue = xQueueCreate(I2C_DISPLAY_QUEUE_LENGTH, sizeof(I2cJob));
+  windowStartUs = micros();
+  xTaskCreatePinnedToCore(busTask, "i2c", I2C_TASK_STACK, NULL,
+                          I2C_TASK_PRIORITY, &busTaskHandle, I2C_TASK_CORE);
+}
+
+bool i2cTransferAsync(I2cDevice device, uint8_t address, const uint8_t *tx, size_t txLen,
+                      uint8_t *rx, size_t rxLen, I2cDone done, void *arg) {
+  if (busTaskHandle == NULL || txLen > I2C_ASYNC_MAX_BYTES || rxLen > I2C_MAX_READ_BYTES) return false;
+  I2cJob job;
+  job.device = device;
+  job.address = address;
+  job.txLen = (uint8_t)txLen;
+  job.rxLen = (uint8_t)rxLen;
+  memcpy(job.tx, tx, txLen);
+  job.rx = rx;
+  job.done = done;
+  job.arg = arg;
+  job.queuedUs = micros();
+  if (xQueueSend(sensorQueue, &job, 0) != pdTRUE) return false;
+  xTaskNotifyGive(busTaskHandle);
+  return true;
+}
+
+struct SyncTransfer {
+  TaskHandle_t task;
+  volatile bool ok;
+};
+
+static void syncDone(bool ok, void *arg) {
+  SyncTransfer *sync = (SyncTransfer *)arg;
+  sync->ok = ok;
+  xTaskNotifyGive(sync->task);
+}
+
+bool i2cTransfer(I2cDevice device, uint8_t address, const uint8_t *tx, size_t txLen,
+                 uint8_t *rx, size_t rxLen) {
+  SyncTransfer sync = { xTaskGetCurrentTaskHandle(), false };
+  if (!i2cTransferAsync(device, address, tx, txLen, rx, rxLen, syncDone, &sync)) return false;
+  // No timeout: `sync` is on this stack until the bus task is done with it.
+  // A stuck bus is the task watchdog's business.
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  return sync.ok;
+}
+
+bool i2cWriteQueued(I2cDevice device, uint8_t address, const uint8_t *data, size_t len, uint32_t waitMs) {
+  if (busTaskHandle == NULL) return false;
+  I2cJob job;
+  job.device = device;
+  job.address = address;
+  job.rxLen = 0;
+  job.rx = NULL;
+  job.done = NULL;
+  job.arg = NULL;
+  for (size_t offset = 0; offset < len; offset += job.txLen) {
+    job.txLen = (uint8_t)(len - offset < I2C_ASYNC_MAX_BYTES ? len - offset : I2C_ASYNC_MAX_BYTES);
+    memcpy(job.tx, data + offset, job.txLen);
+    job.queuedUs = micros();
+    if (xQueueSend(displayQueue, &job, pdMS_TO_TICKS(waitMs)) != pdTRUE) {
+      displayDropped++;
+      return false;
+    }
+    xTaskNotifyGive(busTaskHandle);
+  }
+  return true;
+}
+
+void i2cWaitQueued(uint32_t waitMs) {
+  uint32_t start = millis();
+  while (displayQueue != NULL && uxQueueMessagesWaiting(displayQueue) > 0 && millis() - start < waitMs) {
+    vTaskDelay(1);
+  }
+}
+
+void i2cBusReset() {
+  I2cBusLock lock(I2C_DEVICE_OTHER);
+  Wire.end();
+  Wire.begin();
+  Wire.setClock(busClockHz);
+}
+
+I2cBusLock::I2cBusLock(I2cDevice device) : device(device) {
+  if (busMutex != NULL) xSemaphoreTake(busMutex, portMAX_DELAY);
+  setClockFor(device);
+  startUs = micros();
+}
+
+I2cBusLock::~I2cBusLock() {
+  account(device, startUs, 0, true);
+  if (busMutex != NULL) xSemaphoreGive(busMutex);
+}
+
+void printI2cBusStats() {
+  // Copied out first: printing under the lock would hold up sensor reads
+  I2cDeviceStats copy[I2C_DEVICE_COUNT];
+  if (busMutex != NULL) xSemaphoreTake(busMutex, portMAX_DELAY);
+  uint32_t now = micros();
+  uint32_t window = now - windowStartUs;
+  memcpy(copy, stats, sizeof(stats));
+  memset(stats, 0, sizeof(stats));
+  windowStartUs = now;
+  if (busMutex != NULL) xSemaphoreGive(busMutex);
+
+  if (window == 0) window = 1;
+  Serial.printf("I2C: %lu kHz fast mode, %lu display writes dropped\n",
+                (unsigned long)(I2C_BUS_CLOCK_HZ / 1000), (unsigned long)displayDropped);
+  for (int i = 0; i < I2C_DEVICE_COUNT; i++) {
+    const I2cDeviceStats &s = copy[i];
+    Serial.printf("  %-8s %lu transactions, %lu bytes, %lu errors, busy %.2f%%, wait max %lu us\n",
+                  deviceNames[i], (unsigned long)s.transactions, (unsigned long)s.bytes,
+                  (unsigned long)s.errors, s.busyUs * 100.0 / window, (unsigned long)s.maxWaitUs);
+  }
+}
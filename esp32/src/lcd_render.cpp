@@ -0,0 +1,49 @@
+#include "lcd_render.h"
+#include <string.h>
+
+void lcdRender(const char *text, LcdFrame &frame) {
+  for (int row = 0; row < LCD_ROWS; row++) {
+    memset(frame.rows[row], ' ', LCD_COLS);
+    frame.rows[row][LCD_COLS] = '\0';
+  }
+  int row = 0;
+  int col = 0;
+  for (const char *p = text; *p != '\0'; p++) {
+    if (*p == '\n') {
+      if (++row >= LCD_ROWS) break;
+      col = 0;
+    } else if (col < LCD_COLS) {
+      frame.rows[row][col++] = *p;
+    }
+  }
+}
+
+static int encodeByte(uint8_t value, uint8_t mode, uint8_t *out) {
+  int n = 0;
+  for (int shift = 0; shift <= 4; shift += 4) {
+    uint8_t bits = (uint8_t)((value << shift) & 0xF0) | mode;
+    out[n++] = bits;
+    out[n++] = bits | LCD_EXPANDER_EN;
+    out[n++] = bits;
+  }
+  return n;
+}
+
+int lcdEncodeRow(uint8_t row, const char *text, bool backlight, uint8_t *out) {
+  static const uint8_t rowAddress[LCD_ROWS] = { 0x00, 0x40 };
+  uint8_t light = backlight ? LCD_EXPANDER_BACKLIGHT : 0;
+  // Set DDRAM address
+  int n = encodeByte(0x80 | rowAddress[row < LCD_ROWS ? row : 0], light, out);
+  for (int col = 0; col < LCD_COLS; col++) {
+    n += encodeByte((uint8_t)text[col], light | LCD_EXPANDER_RS, out + n);
+  }
+  return n;
+}
+
+uint8_t lcdChangedRows(const LcdFrame &shown, const LcdFrame &next) {
+  uint8_t changed = 0;
+  for (int row = 0; row < LCD_ROWS; row++) {
+    if (memcmp(shown.rows[row], next.rows[row], LCD_COLS) != 0) changed |= 1 << row;
+  }
+  return changed;
+}
@@ -0,0 +1,196 @@
+#include "local_api.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+enum {
+  HISTORY_PHASE_OPEN = 0,
+  HISTORY_PHASE_BUCKETS,
+  HISTORY_PHASE_CLOSE,
+  HISTORY_PHASE_DONE
+};
+
+static int16_t toFixed16(float value, float scale) {
+  float scaled = value * scale;
+  if (!(scaled > -32768.0f)) return -32768;  // NaN too
+  if (scaled > 32767.0f) return 32767;
+  return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static uint16_t toBasisPoints(float fraction) {
+  float scaled = fraction * 10000.0f + 0.5f;
+  if (!(scaled > 0)) return 0;
+  if (scaled > 10000.0f) return 10000;
+  return (uint16_t)scaled;
+}
+
+static uint16_t saturate16(uint32_t value) {
+  return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
+void liveFrameInit(LiveFrameWriter &writer, uint8_t *out) {
+  writer.out = out;
+  writer.count = 0;
+  writer.hasPrevious = false;
+  writer.sequence = 0;
+  writer.timestampMs = 0;
+}
+
+bool liveFrameAdd(LiveFrameWriter &writer, const SensorSample &sample) {
+  if (writer.count >= LIVE_FRAME_MAX_SAMPLES) return false;
+  LiveFrameHeader *header = (LiveFrameHeader *)writer.out;
+  if (writer.count == 0) {
+    // The first record is relative to the last sample of the previous frame
+    // or, at the start of the stream, to the one just before it
+    header->magic = LIVE_FRAME_MAGIC;
+    header->version = LIVE_FRAME_VERSION;
+    header->reserved = 0;
+    header->sequence = writer.hasPrevious ? writer.sequence : sample.sequence - 1;
+    header->timestampMs = writer.hasPrevious ? writer.timestampMs : sample.timestampMs;
+  }
+  LiveSampleRecord record;
+  record.sequenceDelta = writer.hasPrevious ? saturate16(sample.sequence - writer.sequence) : 1;
+  record.timeDeltaMs = writer.hasPrevious ? saturate16(sample.timestampMs - writer.timestampMs) : 0;
+  record.accel[0] = toFixed16(sample.accelX, 100);
+  record.accel[1] = toFixed16(sample.accelY, 100);
+  record.accel[2] = toFixed16(sample.accelZ, 100);
+  record.gyro[0] = toFixed16(sample.gyroX, 1000);
+  record.gyro[1] = toFixed16(sample.gyroY, 1000);
+  record.gyro[2] = toFixed16(sample.gyroZ, 1000);
+  record.temperature = toFixed16(sample.temperature, 100);
+  record.angleX = toFixed16(sample.angleX, 100);
+  record.angleY = toFixed16(sample.angleY, 100);
+  record.vibrationRMS = toFixed16(sample.vibrationRMS, 1000);
+  record.rain = toBasisPoints(sample.rain);
+  record.soilMoisture = toBasisPoints(sample.soilMoisture);
+  memcpy(writer.out + sizeof(LiveFrameHeader) + writer.count * sizeof(LiveSampleRecord), &record, sizeof(record));
+  writer.count++;
+  header->count = writer.count;
+  writer.hasPrevious = true;
+  writer.sequence = sample.sequence;
+  writer.timestampMs = sample.timestampMs;
+  return true;
+}
+
+size_t liveFrameFinish(LiveFrameWriter &writer) {
+  size_t len = writer.count ? sizeof(LiveFrameHeader) + writer.count * sizeof(LiveSampleRecord) : 0;
+  writer.count = 0;
+  return len;
+}
+
+int liveFrameDecode(const uint8_t *data, size_t len, SensorSample *samples, int maxSamples) {
+  LiveFrameHeader header;
+  if (len < sizeof(header)) return -1;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != LIVE_FRAME_MAGIC || header.version != LIVE_FRAME_VERSION ||
+      header.count > LIVE_FRAME_MAX_SAMPLES || len != sizeof(header) + header.count * sizeof(LiveSampleRecord)) {
+    return -1;
+  }
+  uint32_t sequence = header.sequence;
+  uint32_t timestampMs = header.timestampMs;
+  int n = 0;
+  for (; n < header.count && n < maxSamples; n++) {
+    LiveSampleRecord r;
+    memcpy(&r, data + sizeof(header) + n * sizeof(r), sizeof(r));
+    sequence += r.sequenceDelta;
+    timestampMs += r.timeDeltaMs;
+    SensorSample &s = samples[n];
+    s.sequence = sequence;
+    s.timestampMs = timestampMs;
+    s.accelX = r.accel[0] / 100.0f;
+    s.accelY = r.accel[1] / 100.0f;
+    s.accelZ = r.accel[2] / 100.0f;
+    s.gyroX = r.gyro[0] / 1000.0f;
+    s.gyroY = r.gyro[1] / 1000.0f;
+    s.gyroZ = r.gyro[2] / 1000.0f;
+    s.temperature = r.temperature / 100.0f;
+    s.angleX = r.angleX / 100.0f;
+    s.angleY = r.angleY / 100.0f;
+    s.vibrationRMS = r.vibrationRMS / 1000.0f;
+    s.rain = r.rain / 10000.0f;
+    s.soilMoisture = r.soilMoisture / 10000.0f;
+  }
+  return n;
+}
+
+void historyStreamInit(HistoryStream &stream, HistoryLevel level) {
+  stream.level = level;
+  stream.phase = HISTORY_PHASE_OPEN;
+  stream.any = false;
+  stream.lastStartMs = 0;
+  stream.lastAge = 0;
+}
+
+// JSON has no NaN/Inf; see telemetry.cpp
+static double num(float value) {
+  return isfinite(value) ? value : 0.0;
+}
+
+// Oldest bucket newer than the last one written, by start time, so buckets
+// closed while the response is being sent are neither repeated nor skipped.
+// That is normally the one just below the last bucket's age; when buckets
+// closed in between the ages have moved on and the ring is searched.
+static bool nextBucket(HistoryStream &stream, HistoryBucketReader reader, HistoryBucket &bucket) {
+  uint16_t count = 0;
+  HistoryBucket candidate;
+  if (stream.any && stream.lastAge > 0 && reader(stream.level, stream.lastAge, candidate, count) &&
+      candidate.startMs == stream.lastStartMs && reader(stream.level, stream.lastAge - 1, bucket, count)) {
+    stream.lastAge--;
+    return true;
+  }
+  bool found = false;
+  for (uint16_t age = 0; reader(stream.level, age, candidate, count); age++) {
+    if (stream.any && (int32_t)(candidate.startMs - stream.lastStartMs) <= 0) break;
+    bucket = candidate;
+    stream.lastAge = age;
+    found = true;
+  }
+  return found;
+}
+
+size_t historyStreamFill(HistoryStream &stream, HistoryBucketReader reader, char *out, size_t size) {
+  size_t len = 0;
+  if (stream.phase == HISTORY_PHASE_OPEN && size > 1) {
+    out[len++] = '[';
+    stream.phase = HISTORY_PHASE_BUCKETS;
+  }
+  while (stream.phase == HISTORY_PHASE_BUCKETS) {
+    HistoryBucket bucket;
+    if (!nextBucket(stream, reader, bucket)) {
+      stream.phase = HISTORY_PHASE_CLOSE;
+      break;
+    }
+    const HistoryAggregate *c = bucket.channels;
+    int n = snprintf(out + len, size - len,
+      "%s{\"t\":%lu,\"tilt\":[%.2f,%.2f,%.2f],\"moisture\":[%.2f,%.2f,%.2f],"
+      "\"rain\":[%.2f,%.2f,%.2f],\"vibration\":[%.3f,%.3f,%.3f]}",
+      stream.any ? "," : "", (unsigned long)bucket.startMs,
+      num(c[HISTORY_TILT].min), num(c[HISTORY_TILT].mean), num(c[HISTORY_TILT].max),
+      num(c[HISTORY_MOISTURE].min), num(c[HISTORY_MOISTURE].mean), num(c[HISTORY_MOISTURE].max),
+      num(c[HISTORY_RAIN].min), num(c[HISTORY_RAIN].mean), num(c[HISTORY_RAIN].max),
+      num(c[HISTORY_VIBRATION].min), num(c[HISTORY_VIBRATION].mean), num(c[HISTORY_VIBRATION].max));
+    // A bucket that does not fit waits for the next buffer; snprintf needs
+    // room for its terminator, which is not sent
+    if (n < 0 || (size_t)n >= size - len) {
+      if (len == 0) stream.phase = HISTORY_PHASE_CLOSE;  // never fits: end the array rather than stall
+      break;
+    }
+    len += n;
+    stream.any = true;
+    stream.lastStartMs = bucket.startMs;
+  }
+  if (stream.phase == HISTORY_PHASE_CLOSE && len < size) {
+    out[len++] = ']';
+    stream.phase = HISTORY_PHASE_DONE;
+  }
+  return len;
+}
+
+bool historyLevelFromName(const char *name, HistoryLevel &level) {
+  if (name == NULL) return false;
+  if (strcmp(name, "seconds") == 0) level = HISTORY_LEVEL_SECONDS;
+  else if (strcmp(name, "minutes") == 0) level = HISTORY_LEVEL_MINUTES;
+  else if (strcmp(name, "hours") == 0) level = HISTORY_LEVEL_HOURS;
+  else return false;
+  return true;
+}
@@ -0,0 +1,164 @@
+#include "local_server.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "telemetry.h"
+#include "device_id.h"
+#include "mesh_module.h"
+#include "config.h"
+
+#ifndef LOCAL_SERVER_ENABLED
+#define LOCAL_SERVER_ENABLED 0
+#endif
+
+#define STREAM_TASK_STACK 3072
+#define STREAM_TASK_PRIORITY 1
+#define STREAM_TASK_CORE 0
+#define WS_CLEANUP_MS 1000
+
+static AsyncWebServer server(LOCAL_SERVER_PORT);
+static AsyncWebSocket liveSocket("/ws/live");
+static HistoryBucketReader historyReader = NULL;
+static QueueHandle_t liveQueue = NULL;
+// The socket's client list has no lock of its own: the async TCP task
+// changes it on connect and disconnect while the stream task sends
+static SemaphoreHandle_t socketMutex = NULL;
+static volatile uint32_t liveClients = 0;   // updated in the async TCP task
+static volatile uint32_t streamedSamples = 0;
+static volatile uint32_t droppedSamples = 0;    // queue full
+static volatile uint32_t skippedFrames = 0;     // a client's send queue was full
+static volatile uint32_t httpRequests = 0;
+
+bool localServerEnabled() {
+  return LOCAL_SERVER_ENABLED && !isMeshLeaf();
+}
+
+void liveStreamSample(const SensorSample &sample) {
+  // Nothing is queued while nobody is listening
+  if (liveQueue == NULL || liveClients == 0) return;
+  if (xQueueSend(liveQueue, &sample, 0) != pdTRUE) droppedSamples++;
+}
+
+bool localClientsConnected() {
+  return liveClients > 0;
+}
+
+// Held around every call into liveSocket
+struct SocketLock {
+  SocketLock() { xSemaphoreTake(socketMutex, portMAX_DELAY); }
+  ~SocketLock() { xSemaphoreGive(socketMutex); }
+};
+
+static void sendFrame(uint8_t *frame, size_t len) {
+  if (len == 0) return;
+  SocketLock lock;
+  // The socket copies the frame once into a shared buffer for all clients
+  if (!liveSocket.availableForWriteAll()) {
+    skippedFrames++;
+    return;
+  }
+  liveSocket.binaryAll(frame, len);
+}
+
+static void streamTask(void *param) {
+  static uint8_t frame[LIVE_FRAME_MAX_BYTES];
+  LiveFrameWriter writer;
+  liveFrameInit(writer, frame);
+  SensorSample sample;
+  uint32_t frameStart = millis();
+  uint32_t lastCleanup = millis();
+  for (;;) {
+    if (xQueueReceive(liveQueue, &sample, pdMS_TO_TICKS(LIVE_FLUSH_MS)) == pdTRUE) {
+      if (writer.count == 0) frameStart = millis();
+      if (!liveFrameAdd(writer, sample)) {
+        sendFrame(frame, liveFrameFinish(writer));
+        frameStart = millis();
+        liveFrameAdd(writer, sample);
+      }
+      streamedSamples++;
+    }
+    if (writer.count > 0 && (writer.count == LIVE_FRAME_MAX_SAMPLES || millis() - frameStart >= LIVE_FLUSH_MS)) {
+      sendFrame(frame, liveFrameFinish(writer));
+    }
+    if (millis() - lastCleanup >= WS_CLEANUP_MS) {
+      SocketLock lock;
+      liveSocket.cleanupClients();
+      lastCleanup = millis();
+    }
+  }
+}
+
+static void onLiveEvent(AsyncWebSocket *socket, AsyncWebSocketClient *client, AwsEventType type,
+                        void *arg, uint8_t *data, size_t len) {
+  if (type == WS_EVT_CONNECT || type == WS_EVT_DISCONNECT) {
+    {
+      // A leaving client is only freed after this, so not while a frame
+      // is going out to it
+      SocketLock lock;
+      liveClients = socket->count();
+    }
+    Serial.printf("Local server: live client %u %s (%u connected)\n", client->id(),
+                  type == WS_EVT_CONNECT ? "connected" : "left", liveClients);
+  }
+}
+
+static void handleState(AsyncWebServerRequest *request) {
+  httpRequests++;
+  char json[TELEMETRY_JSON_MAX];
+  int len = formatTelemetryJson(json, sizeof(json), readLatestSnapshot(), getDeviceId(), 0);
+  if (len < 0) {
+    request->send(500);
+    return;
+  }
+  // ~600 bytes, copied once into the response
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", String(json));
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+static void handleHistory(AsyncWebServerRequest *request) {
+  httpRequests++;
+  HistoryLevel level = HISTORY_LEVEL_MINUTES;
+  if (request->hasParam("level") && !historyLevelFromName(request->getParam("level")->value().c_str(), level)) {
+    request->send(400, "text/plain", "level: seconds, minutes or hours");
+    return;
+  }
+  // The filler writes each chunk directly into the response's send buffer
+  HistoryStream stream;
+  historyStreamInit(stream, level);
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+    [stream](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+      return historyStreamFill(stream, historyReader, (char *)buffer, maxLen);
+    });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+void setupLocalServer(HistoryBucketReader reader) {
+  if (!localServerEnabled() || liveQueue != NULL) return;
+  historyReader = reader;
+  socketMutex = xSemaphoreCreateMutex();
+  liveQueue = xQueueCreate(LIVE_QUEUE_LENGTH, sizeof(SensorSample));
+  if (liveQueue == NULL || socketMutex == NULL) return;
+  liveSocket.onEvent(onLiveEvent);
+  server.addHandler(&liveSocket);
+  server.on("/api/state", HTTP_GET, handleState);
+  server.on("/api/history", HTTP_GET, handleHistory);
+  server.onNotFound([](AsyncWebServerRequest *request) { request->send(404); });
+  server.begin();
+  xTaskCreatePinnedToCore(streamTask, "stream", STREAM_TASK_STACK, NULL,
+                          STREAM_TASK_PRIORITY, NULL, STREAM_TASK_CORE);
+  Serial.printf("Local server: http://%s/api/state, ws://%s/ws/live\n",
+                WiFi.localIP().toString().c_str(), WiFi.localIP().toString().c_str());
+}
+
+void printLocalServerStats() {
+  if (liveQueue == NULL) return;
+  Serial.printf("Local server: %u live clients, %u samples streamed, %u dropped, %u frames skipped, %u requests\n",
+                liveClients, streamedSamples, droppedSamples, skippedFrames, httpRequests);
+}
@@ -1,28 +1,32 @@
 #include "logic.h"
 #include "actuators.h"
+#include "alarm_task.h"
 #include "sensors.h"
+#include "fastmath.h"
+#include "runtime_config.h"
+#include "risk.h"
+#include "heap_monitor.h"
+#include "lcd_render.h"
 #include <Arduino.h>
 
-// Vibration detection thresholds based on RMS acceleration
-#define VIBRATION_SAFE_THRESHOLD 0.5      // Below 0.5 m/s² is considered stable
-#define VIBRATION_WARNING_THRESHOLD 1.0   // Between 0.5-1.0 m/s² is light vibration
-
-String getSoilCondition(float soilMoistureValue) {
+const char* getSoilCondition(float soilMoistureValue) {
+  RiskThresholds t = getRuntimeConfig().thresholds;
   float moisture = soilMoistureValue * 100;
   
-  if (moisture < 30) {
+  if (moisture < t.moistureWarning) {
     return "Kering";
-  } else if (moisture >= 30 && moisture < 70) {
+  } else if (moisture >= t.moistureWarning && moisture < t.moistureDanger) {
     return "Lembab";
   } else {
     return "Basah";
   }
 }
 
-String getVibrationStatus(float vibrationRMS) {
-  if (vibrationRMS < VIBRATION_SAFE_THRESHOLD) {
+const char* getVibrationStatus(float vibrationRMS) {
+  RiskThresholds t = getRuntimeConfig().thresholds;
+  if (vibrationRMS < t.vibrationWarning) {
     return "Stabil";
-  } else if (vibrationRMS < VIBRATION_WARNING_THRESHOLD) {
+  } else if (vibrationRMS < t.vibrationDanger) {
     return "Ringan";
   } else {
     return "Signifikan";
@@ -34,59 +38,38 @@ void determineRiskLevel(
   float angleY, 
   float soilMoistureValue, 
   float rainValue,
-  String &riskLevel, 
+  float vibrationRMS,
+  const TrendFeatures &trend,
+  RiskLevel &riskLevel, 
   bool &alertTrigger
 ) {
-  float integerMoisture = soilMoistureValue * 100;  // Convert to percentage
-  float integerRain = rainValue * 100;              // Convert to percentage
-  float tiltAngle = max(abs(angleX), abs(angleY));  // Use the maximum tilt angle
-  float vibrationRMS = getVibrationRMS();           // Get the RMS value for vibration
-  String soilCondition = getSoilCondition(soilMoistureValue);
-  String vibrationStatus = getVibrationStatus(vibrationRMS);
-  String status = "";
-  
-  // Default to safe
-  riskLevel = "safe";
-  alertTrigger = false;
-  
-  // Safe/Aman condition
-  if (tiltAngle <= 10.0 && 
-      integerMoisture < 30 && // Dry soil
-      integerRain < 20 && 
-      vibrationRMS < VIBRATION_SAFE_THRESHOLD) {
-    riskLevel = "safe";
-    alertTrigger = false;
-    status = "tanah aman";
-    writeServo1(90);
-    writeServo2(90);
-    activateBuzzer(false);
-  }
-  // Warning/Waspada condition
-  else if ((tiltAngle > 5.0 && tiltAngle <= 15.0) || 
-          (integerMoisture >= 30 && integerMoisture < 70) || // Moist soil
-          (integerRain >= 20 && integerRain < 30) || 
-          (vibrationRMS >= VIBRATION_SAFE_THRESHOLD && vibrationRMS < VIBRATION_WARNING_THRESHOLD)) {
-    riskLevel = "warning";
-    alertTrigger = false;
+  // One consistent copy of the thresholds for the whole classification.
+  // classifyRisk() decides danger with riskDangerReading(), the same test
+  // as the fast path, so the loop never drops an alarm the fast path raised.
+  RuntimeConfig config = getRuntimeConfig();
+  classifyRisk(config.thresholds, angleX, angleY, soilMoistureValue, rainValue,
+               vibrationRMS, riskLevel, alertTrigger);
+  applyTrendRisk(config.thresholds, trend, riskLevel, alertTrigger);
 
-    status = "tanah waspada";
-    writeServo1(90);
-    writeServo2(90);
-    activateBuzzer(false);
-  }
-  // Danger/Awas condition
-  else if (tiltAngle > 15.0 || 
-          integerMoisture >= 70 || // Wet soil
-          integerRain >= 30 || 
-          vibrationRMS >= VIBRATION_WARNING_THRESHOLD) {
-    riskLevel = "danger";
-    alertTrigger = true;
-    status = "tanah AWAS!";
-    writeServo1(0);
-    writeServo2(0);
-    activateBuzzer(true);
+  // Silent mode keeps the site quiet during maintenance; test mode holds the
+  // alarm outputs so the buzzer and barrier can be checked on site. The
+  // alarm task drives them; a danger sample has usually switched them on
+  // already through the fast path.
+  bool alarmOutputs = config.mode == MODE_TEST || (config.mode == MODE_NORMAL && alertTrigger);
+  requestAlarmOutputs(alarmOutputs);
+}
+
+// The LCD follows at its own, slower rate than the alarm outputs
+void displayRiskStatus(const LatestSnapshot &snapshot) {
+  const char *status;
+  switch (snapshot.risk.level) {
+    case RISK_DANGER: status = "tanah AWAS!"; break;
+    case RISK_WARNING: status = "tanah waspada"; break;
+    default: status = "tanah aman"; break;
   }
+  float tiltAngle = fastMaxAbs(snapshot.sample.angleX, snapshot.sample.angleY);     // Use the maximum tilt angle
 
-    status += "\nTilt:" + String(tiltAngle, 1);
-    writeLCD(status);
-}
\ No newline at end of file
+  ArenaString message(loopArena, LCD_COLS * LCD_ROWS + 2);
+  message.appendf("%s\nTilt:%.1f", status, tiltAngle);
+  writeLCD(message.c_str());
+}
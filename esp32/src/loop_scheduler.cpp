@@ -0,0 +1,126 @@
+#include "loop_scheduler.h"
+#include <string.h>
+
+// Wrap-safe "a is before b" for microsecond timestamps
+static bool before(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+void schedulerInit(LoopScheduler &scheduler, SchedulerClock clock) {
+  memset(&scheduler, 0, sizeof(scheduler));
+  scheduler.clock = clock;
+  scheduler.windowStartUs = clock();
+  scheduler.runningStage = -1;
+}
+
+int schedulerAddStage(LoopScheduler &scheduler, const char *name, StageRun run,
+                      uint32_t periodUs, uint32_t offsetUs) {
+  if (scheduler.stageCount >= SCHED_MAX_STAGES || run == NULL || periodUs == 0) return -1;
+  SchedulerStage &stage = scheduler.stages[scheduler.stageCount];
+  memset(&stage, 0, sizeof(stage));
+  stage.name = name;
+  stage.run = run;
+  stage.periodUs = periodUs;
+  stage.nextDueUs = scheduler.clock() + offsetUs;
+  return scheduler.stageCount++;
+}
+
+void schedulerSetPeriod(LoopScheduler &scheduler, int stage, uint32_t periodUs) {
+  if (stage < 0 || stage >= scheduler.stageCount || periodUs == 0) return;
+  SchedulerStage &s = scheduler.stages[stage];
+  uint32_t next = scheduler.clock() + periodUs;
+  if (before(next, s.nextDueUs)) s.nextDueUs = next;
+  s.periodUs = periodUs;
+}
+
+void schedulerSetDegrade(LoopScheduler &scheduler, int stage, uint8_t shift) {
+  if (stage < 0 || stage >= scheduler.stageCount || shift > 8) return;
+  scheduler.stages[stage].degradeShift = shift;
+}
+
+void schedulerSkipNext(LoopScheduler &scheduler, int stage) {
+  if (stage < 0 || stage >= scheduler.stageCount) return;
+  scheduler.stages[stage].skipNext = true;
+}
+
+void schedulerSetHooks(LoopScheduler &scheduler, StageHook before, StageHook after) {
+  scheduler.beforeStage = before;
+  scheduler.afterStage = after;
+}
+
+static int earliestDue(const LoopScheduler &scheduler, uint32_t nowUs) {
+  int due = -1;
+  for (int i = 0; i < scheduler.stageCount; i++) {
+    const SchedulerStage &stage = scheduler.stages[i];
+    if (before(nowUs, stage.nextDueUs)) continue;
+    // Ties go to the stage added first
+    if (due < 0 || before(stage.nextDueUs, scheduler.stages[due].nextDueUs)) due = i;
+  }
+  return due;
+}
+
+static void runStage(LoopScheduler &scheduler, int index, uint32_t startUs) {
+  SchedulerStage &stage = scheduler.stages[index];
+  StageStats &s = stage.stats;
+  uint32_t period = stage.periodUs << stage.degradeShift;
+  uint32_t lateness = startUs - stage.nextDueUs;
+  // Stay on the grid; whole periods already gone are dropped, not replayed
+  uint32_t missed = lateness / period;
+  s.skipped += missed;
+  stage.nextDueUs += (missed + 1) * period;
+  if (stage.skipNext) {
+    stage.skipNext = false;
+    s.shed++;
+    return;
+  }
+
+  if (lateness > s.maxLatenessUs) s.maxLatenessUs = lateness;
+  s.totalLatenessUs += lateness;
+
+  scheduler.runningStage = index;
+  if (scheduler.beforeStage) scheduler.beforeStage(index, 0);
+  stage.run();
+  uint32_t runUs = scheduler.clock() - startUs;
+  scheduler.runningStage = -1;
+
+  s.runs++;
+  if (runUs > s.maxRunUs) s.maxRunUs = runUs;
+  s.totalRunUs += runUs;
+  if (runUs > period) s.overruns++;
+  scheduler.busyUs += runUs;
+  // Last, so the hook may skip or re-rate this stage
+  if (scheduler.afterStage) scheduler.afterStage(index, runUs);
+}
+
+uint32_t schedulerRunDue(LoopScheduler &scheduler) {
+  // Bounded so a stage that is always due cannot starve the caller
+  for (int pass = 0; pass < scheduler.stageCount; pass++) {
+    uint32_t now = scheduler.clock();
+    int due = earliestDue(scheduler, now);
+    if (due < 0) break;
+    runStage(scheduler, due, now);
+  }
+
+  uint32_t now = scheduler.clock();
+  uint32_t wait = UINT32_MAX;
+  for (int i = 0; i < scheduler.stageCount; i++) {
+    uint32_t due = scheduler.stages[i].nextDueUs;
+    uint32_t left = before(now, due) ? due - now : 0;
+    if (left < wait) wait = left;
+  }
+  return wait;
+}
+
+uint8_t schedulerIdlePct(const LoopScheduler &scheduler, uint32_t nowUs) {
+  uint32_t window = nowUs - scheduler.windowStartUs;
+  if (window == 0 || scheduler.busyUs >= window) return 0;
+  return (uint8_t)(100 - scheduler.busyUs * 100 / window);
+}
+
+void schedulerResetStats(LoopScheduler &scheduler, uint32_t nowUs) {
+  for (int i = 0; i < scheduler.stageCount; i++) {
+    memset(&scheduler.stages[i].stats, 0, sizeof(StageStats));
+  }
+  scheduler.busyUs = 0;
+  scheduler.windowStartUs = nowUs;
+}
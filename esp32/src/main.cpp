@@ -8,11 +8,216 @@
 #include "sensors.h"
 #include "actuators.h"
 #include "wifi_module.h"
-#include "firebase_module.h"
+#include "uplink.h"
 #include "telegram_module.h"
+#include "secure_transport.h"
+#include "remote_config.h"
+#include "mesh_module.h"
+#include "recorder.h"
+#include "heap_monitor.h"
 #include "logic.h"
+#include "loop_scheduler.h"
+#include "adaptive_rate.h"
+#include "deep_sleep.h"
+#include "anomaly.h"
+#include "history.h"
+#include "local_server.h"
+#include "alarm_task.h"
+#include "health_monitor.h"
+#include "i2c_bus.h"
+#include "runtime_config.h"
 
 
+// Stage periods of the loop scheduler. Sampling is not one of them: it runs
+// in the sensor task. Sampling and upload rates follow the rate profile
+// (adaptive_rate.h); 5 Hz upload at full rate, leaves included.
+#define CLASSIFY_PERIOD_US 50000       // 20 Hz
+#define MESH_POLL_PERIOD_US 50000      // drains the ESP-NOW queue well before it fills
+#define DISPLAY_PERIOD_US 500000       // 2 Hz
+#define TELEGRAM_PERIOD_US 2000000     // 0.5 Hz
+#define REPORT_PERIOD_US 60000000      // once a minute
+#define SLEEP_CHECK_PERIOD_US 1000000  // deep sleep (DEEP_SLEEP_ENABLED) considered once a second
+
+// Soft deadline per stage run (health_monitor.h) and how far a stage that
+// keeps overrunning is escalated. The network stages block on HTTPS or
+// MQTT; a hang beyond WATCHDOG_TIMEOUT_S reboots through the watchdog.
+#define CLASSIFY_BUDGET_US 20000
+#define UPLOAD_BUDGET_US 2000000
+#define MESH_BUDGET_US 20000
+#define TELEGRAM_BUDGET_US 5000        // only wakes the Telegram task
+#define UPLINK_BUDGET_US 1000000
+#define DISPLAY_BUDGET_US 50000        // LCD rows are only queued for the I2C bus task
+#define REPORT_BUDGET_US 3000000       // serial dump plus the diagnostics upload
+#define SLEEP_BUDGET_US 50000
+#define ESCALATE_SKIP DEADLINE_ALLOW(DEADLINE_SKIP)
+#define ESCALATE_DEGRADE (DEADLINE_ALLOW(DEADLINE_SKIP) | DEADLINE_ALLOW(DEADLINE_DEGRADE))
+#define ESCALATE_RESTART (ESCALATE_DEGRADE | DEADLINE_ALLOW(DEADLINE_RESTART))
+
+static LoopScheduler loopScheduler;
+static int uploadStageIndex = -1;
+static AdaptiveRate adaptiveRate;    // loop task only
+static AnomalyDetector anomalyDetector;
+static SensorHistory sensorHistory;     // ~16 KB, see history.h
+// historyAdd and the local server's bucket reads run on different tasks
+static portMUX_TYPE historyMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t schedulerClock() {
+  return micros();
+}
+
+static bool readHistoryBucket(HistoryLevel level, uint16_t age, HistoryBucket &bucket, uint16_t &count) {
+  portENTER_CRITICAL(&historyMux);
+  const HistoryBucket *found = historyAt(sensorHistory, level, age);
+  if (found) bucket = *found;
+  count = historyCount(sensorHistory, level);
+  portEXIT_CRITICAL(&historyMux);
+  return found != NULL;
+}
+
+static void applyRateProfile(RateProfile profile) {
+  const RatePolicy &policy = ratePolicy(profile);
+  setSensorRateProfile(profile);
+  schedulerSetPeriod(loopScheduler, uploadStageIndex, policy.uploadIntervalMs * 1000UL);
+  // A gateway keeps listening for its leaves; a leaf has no access point
+  if (getMeshRole() == MESH_ROLE_STANDALONE) setWiFiPowerSave(policy.radioPowerSave);
+  Serial.printf("Rate profile %s: %u Hz sampling, upload every %lu ms\n", rateProfileName(profile),
+                policy.sampleRateHz, (unsigned long)policy.uploadIntervalMs);
+}
+
+static void classifyStage() {
+  // Latest sample from the sensor task; the loop never touches the sensors
+  SensorSample sample = readLatestSample();
+  uint32_t now = millis();
+  portENTER_CRITICAL(&historyMux);
+  historyAdd(sensorHistory, sample, now);
+  portEXIT_CRITICAL(&historyMux);
+  TrendFeatures trend;
+  historyFeatures(sensorHistory, trend);
+  RiskLevel riskLevel;
+  bool alertTrigger;
+  {
+    HeapScope heapScope(HEAP_LOGIC);
+    // Determine risk level and alert trigger
+    determineRiskLevel(sample.angleX, sample.angleY, sample.soilMoisture, sample.rain,
+                       sample.vibrationRMS, trend, riskLevel, alertTrigger);
+  }
+  anomalyUpdate(anomalyDetector, sample, now);
+  riskLevel = anomalyRiskLevel(riskLevel, anomalyDetector.mask);
+  if (adaptiveRateUpdate(adaptiveRate, getRuntimeConfig().thresholds, riskLevel, sample, now)) {
+    applyRateProfile(adaptiveRate.profile);
+  }
+  RiskStatus status = { now, sample.sequence, riskLevel, alertTrigger, adaptiveRate.profile };
+  anomalyFillStatus(anomalyDetector, status);
+  status.trend = trend;
+  publishRiskStatus(status);
+}
+
+static void uploadStage() {
+  if (isMeshLeaf()) {
+    meshLeafSend(readLatestSnapshot());
+  } else {
+    if (uplinkSendSample(readLatestSnapshot())) deepSleepUploadDone();
+  }
+}
+
+static void displayStage() {
+  LatestSnapshot snapshot = readLatestSnapshot();
+  printSensorSample(snapshot.sample);
+  displayRiskStatus(snapshot);
+}
+
+static void printSchedulerStats() {
+  uint32_t now = micros();
+  Serial.printf("Loop: %u%% idle\n", schedulerIdlePct(loopScheduler, now));
+  for (int i = 0; i < loopScheduler.stageCount; i++) {
+    const SchedulerStage &stage = loopScheduler.stages[i];
+    const StageStats &s = stage.stats;
+    uint32_t runs = s.runs ? s.runs : 1;
+    Serial.printf("  %-9s %u runs, run avg %u max %u us, late avg %u max %u us, %u overruns, %u skipped, %u shed%s\n",
+                  stage.name, s.runs, (uint32_t)(s.totalRunUs / runs), s.maxRunUs,
+                  (uint32_t)(s.totalLatenessUs / runs), s.maxLatenessUs, s.overruns, s.skipped, s.shed,
+                  stage.degradeShift ? " (degraded)" : "");
+  }
+  schedulerResetStats(loopScheduler, now);
+}
+
+static void printAnomalyStats() {
+  Serial.printf("Anomaly: %lu alarms, mask 0x%X\n", (unsigned long)anomalyDetector.alarms, anomalyDetector.mask);
+  for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) {
+    const ChannelStats &c = anomalyDetector.channels[i];
+    Serial.printf("  %-9s mean %.2f sd %.2f, baseline %.2f sd %.2f, score %.2f\n",
+                  anomalyChannelName((AnomalyChannel)i), c.mean, sqrtf(anomalyLongRunVariance(c)),
+                  c.baseline, sqrtf(c.variance), c.score);
+  }
+}
+
+static void printHistoryStats() {
+  TrendFeatures trend;
+  historyFeatures(sensorHistory, trend);
+  Serial.printf("History: %u s, %u min, %u h buckets; creep %.2f deg/h, moisture %.2f %%/h%s; "
+                "rain event %.2f h, 24 h %.2f h\n",
+                historyCount(sensorHistory, HISTORY_LEVEL_SECONDS), historyCount(sensorHistory, HISTORY_LEVEL_MINUTES),
+                historyCount(sensorHistory, HISTORY_LEVEL_HOURS), trend.tiltVelocity, trend.moistureRate,
+                trend.ratesValid ? "" : " (warming up)", trend.rainEventHours, trend.rain24hHours);
+}
+
+static void sleepStage() {
+  if (localClientsConnected()) return;
+  deepSleepIfIdle(readLatestRiskStatus(), adaptiveRate, anomalyDetector, getRuntimeConfig().thresholds);
+}
+
+static void reportStage() {
+  printSchedulerStats();
+  Serial.printf("Rate profile %s for %lu s, %lu changes\n", rateProfileName(adaptiveRate.profile),
+                (unsigned long)((millis() - adaptiveRate.profileSinceMs) / 1000), (unsigned long)adaptiveRate.transitions);
+  printHealthStats();
+  printAlarmStats();
+  printAnomalyStats();
+  printHistoryStats();
+  printUplinkStats();
+  printTransportStats();
+  printMeshStats();
+  printRecorderStats();
+  printI2cBusStats();
+  printLocalServerStats();
+  printDeepSleepStats();
+  HeapReport heap;
+  heapCollect(heap);
+  printHeapReport(heap);
+  if (!isMeshLeaf()) uplinkSendDiagnostics(heap, healthDeadlines());
+}
+
+// Adds a stage and its soft deadline
+static int addStage(const char *name, StageRun run, uint32_t periodUs, uint32_t offsetUs,
+                    uint32_t budgetUs, uint8_t escalations, void (*restart)() = NULL) {
+  int stage = schedulerAddStage(loopScheduler, name, run, periodUs, offsetUs);
+  healthWatchStage(loopScheduler, stage, budgetUs, escalations, restart);
+  return stage;
+}
+
+static void setupLoopScheduler() {
+  schedulerInit(loopScheduler, schedulerClock);
+  addStage("classify", classifyStage, CLASSIFY_PERIOD_US, 0, CLASSIFY_BUDGET_US, ESCALATE_DEGRADE);
+  // A leaf uploads over ESP-NOW: nothing to reconnect
+  uploadStageIndex = addStage("upload", uploadStage, ratePolicy(RATE_FULL).uploadIntervalMs * 1000UL, 10000,
+                              UPLOAD_BUDGET_US, ESCALATE_RESTART, isMeshLeaf() ? NULL : reconnectWiFi);
+  if (!isMeshLeaf()) {
+    addStage("mesh", meshGatewayPoll, MESH_POLL_PERIOD_US, 20000, MESH_BUDGET_US, ESCALATE_SKIP);
+    // Telegram polling and sending run in their own task (TELEGRAM_ON_DEVICE)
+    addStage("telegram", kickTelegramTask, TELEGRAM_PERIOD_US, 30000, TELEGRAM_BUDGET_US, 0);
+    if (uplinkNeedsPoll()) {
+      addStage("uplink", uplinkPoll, UPLINK_POLL_PERIOD_US, 25000, UPLINK_BUDGET_US, ESCALATE_RESTART, reconnectWiFi);
+    }
+  }
+  addStage("display", displayStage, DISPLAY_PERIOD_US, 40000, DISPLAY_BUDGET_US, ESCALATE_RESTART, setupLCD);
+  addStage("report", reportStage, REPORT_PERIOD_US, REPORT_PERIOD_US, REPORT_BUDGET_US, 0);
+  if (deepSleepEnabled()) {
+    addStage("sleep", sleepStage, SLEEP_CHECK_PERIOD_US, SLEEP_CHECK_PERIOD_US, SLEEP_BUDGET_US, 0);
+  }
+  // Only a deep-sleep wake starts below full rate
+  if (adaptiveRate.profile != RATE_FULL) applyRateProfile(adaptiveRate.profile);
+}
+
 void setup() {
   ESP32PWM::allocateTimer(0);
   ESP32PWM::allocateTimer(1);
@@ -20,60 +225,60 @@ void setup() {
   ESP32PWM::allocateTimer(3);
 
   Serial.begin(115200);
-  delay(1000); // Give serial monitor time to open
+  setupHealthMonitor();
+  adaptiveRateInit(adaptiveRate, millis());
+  anomalyInit(anomalyDetector, millis());
+  historyInit(sensorHistory);
+  // A wake from deep sleep restores the rate and anomaly state and skips
+  // the pauses meant for someone watching the boot
+  bool resumed = resumeFromDeepSleep(adaptiveRate, anomalyDetector);
+  if (!resumed) delay(1000); // Give serial monitor time to open
   
+  // MPU6050 and LCD share the bus; its task starts before either is touched
+  setupI2cBus();
   setupActuators();
+  startAlarmTask();
   setupSensors();
   
   writeLCD("Initializing\nMPU6050...");
   setupMPU6050();
+  setupRecorder();
+  startSensorTask();
   
-  writeLCD("Initializing\nWiFi...");
-  setupWiFi();
-  
-  writeLCD("Initializing\nFirebase...");
-  setupFirebase();
-  
-  writeLCD("Initializing\nTelegram...");
-  setupTelegram();
+  if (isMeshLeaf()) {
+    // Leaves stay off the network and reach the cloud through the gateway;
+    // they classify with the default thresholds (no remote config stream)
+    writeLCD("Initializing\nMesh...");
+    setupMesh();
+  } else {
+    writeLCD("Initializing\nWiFi...");
+    uint8_t channel;
+    uint8_t bssid[6];
+    if (deepSleepWiFiHint(channel, bssid)) setupWiFi(channel, bssid);
+    else setupWiFi();
+    setupMesh();
+    setupLocalServer(readHistoryBucket);
+    
+    writeLCD("Initializing\nUplink...");
+    setupUplink();
+    setupRemoteConfig();
+    
+    writeLCD("Initializing\nTelegram...");
+    setupTelegram();
+    startTelegramTask();
+  }
 
   // System ready message
   writeLCD("System Ready!\n:)");
-  delay(2000);
+  if (!resumed) delay(2000);
+  setupLoopScheduler();
+  startHealthMonitor(loopScheduler);
 }
 
 void loop() {
-  // Sensor data reading and processing
-  sensors_event_t a, g, temp;
-  float rainValue;
-  float soilMoistureValue;
-  float angleX, angleY;
-  readAllSensorsData(rainValue, soilMoistureValue, a, g, temp);
-  
-  // Calculate tilt angles in degrees
-  angleX = atan2(a.acceleration.x, sqrt(a.acceleration.y * a.acceleration.y + a.acceleration.z * a.acceleration.z)) * 180.0 / PI;
-  angleY = atan2(a.acceleration.y, sqrt(a.acceleration.x * a.acceleration.x + a.acceleration.z * a.acceleration.z)) * 180.0 / PI;
-  
-  // Determine risk level and alert trigger
-  String riskLevel;
-  bool alertTrigger;
-  determineRiskLevel(angleX, angleY, soilMoistureValue, rainValue, riskLevel, alertTrigger);
-  
-  // Cycle through different sensor data on LCD
-  static unsigned long lastDisplayToggle = 0;
-  static unsigned long lastFirebaseUpload = 0;
-  static int displayState = 0;
-  unsigned int mil = millis();
-  
-  // setiap 0.2 detik
-  if (mil - lastFirebaseUpload > 180) {
-    sendDataToFirebase(a, g, temp, angleX, angleY, soilMoistureValue, rainValue, riskLevel, alertTrigger);
-  }
-
-  // Check for new Telegram messages
-  // DISABLED: Telegram sending from backend
-  // checkNewMessages(&riskLevel, alertTrigger);
-  // sendSubscriptionStatusIfNeeded();
-  
-  delay(50); // Sample frequently for better vibration detection
-}
\ No newline at end of file
+  uint32_t waitUs = schedulerRunDue(loopScheduler);
+  // Everything built in the loop arena this iteration is dead by now
+  arenaReset(loopArena);
+  // Sleep whole ticks until the next deadline; a shorter wait spins once more
+  if (waitUs >= portTICK_PERIOD_MS * 1000) vTaskDelay(waitUs / (portTICK_PERIOD_MS * 1000));
+}
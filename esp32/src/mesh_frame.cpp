@@ -0,0 +1,72 @@
+#include "mesh_frame.h"
+#include <string.h>
+
+static int16_t toFixed16(float value, float scale) {
+  float scaled = value * scale;
+  if (scaled > 32767.0f) return 32767;
+  if (scaled < -32768.0f) return -32768;
+  return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static uint8_t toHalfPercent(float fraction) {
+  float scaled = fraction * 200.0f + 0.5f;
+  if (scaled < 0) return 0;
+  if (scaled > 200.0f) return 200;
+  return (uint8_t)scaled;
+}
+
+void encodeMeshFrame(const SensorSample &sample, const RiskStatus &risk, uint16_t sequence,
+                     MeshSampleFrame &frame) {
+  frame.magic = MESH_FRAME_MAGIC;
+  frame.version = MESH_FRAME_VERSION;
+  frame.sequence = sequence;
+  frame.uptimeMs = sample.timestampMs;
+  frame.accel[0] = toFixed16(sample.accelX, 100);
+  frame.accel[1] = toFixed16(sample.accelY, 100);
+  frame.accel[2] = toFixed16(sample.accelZ, 100);
+  frame.gyro[0] = toFixed16(sample.gyroX, 1000);
+  frame.gyro[1] = toFixed16(sample.gyroY, 1000);
+  frame.gyro[2] = toFixed16(sample.gyroZ, 1000);
+  frame.temperature = toFixed16(sample.temperature, 100);
+  frame.angleX = toFixed16(sample.angleX, 100);
+  frame.angleY = toFixed16(sample.angleY, 100);
+  frame.vibrationRMS = toFixed16(sample.vibrationRMS, 1000);
+  frame.rain = toHalfPercent(sample.rain);
+  frame.soilMoisture = toHalfPercent(sample.soilMoisture);
+  frame.risk = (uint8_t)(risk.level & 0x0F) | (uint8_t)((risk.rateProfile & 0x03) << 4) |
+               (risk.alertTrigger ? 0x80 : 0);
+}
+
+bool decodeMeshFrame(const uint8_t *data, size_t len, MeshSampleFrame &frame,
+                     SensorSample &sample, RiskStatus &risk) {
+  if (len != sizeof(MeshSampleFrame)) return false;
+  memcpy(&frame, data, sizeof(frame));
+  if (frame.magic != MESH_FRAME_MAGIC || frame.version != MESH_FRAME_VERSION) return false;
+  if ((frame.risk & 0x0F) > RISK_DANGER) return false;
+
+  sample.sequence = frame.sequence;
+  sample.timestampMs = frame.uptimeMs;
+  sample.accelX = frame.accel[0] / 100.0f;
+  sample.accelY = frame.accel[1] / 100.0f;
+  sample.accelZ = frame.accel[2] / 100.0f;
+  sample.gyroX = frame.gyro[0] / 1000.0f;
+  sample.gyroY = frame.gyro[1] / 1000.0f;
+  sample.gyroZ = frame.gyro[2] / 1000.0f;
+  sample.temperature = frame.temperature / 100.0f;
+  sample.angleX = frame.angleX / 100.0f;
+  sample.angleY = frame.angleY / 100.0f;
+  sample.vibrationRMS = frame.vibrationRMS / 1000.0f;
+  sample.rain = frame.rain / 200.0f;
+  sample.soilMoisture = frame.soilMoisture / 200.0f;
+
+  risk.timestampMs = frame.uptimeMs;
+  risk.sampleSequence = frame.sequence;
+  risk.level = (RiskLevel)(frame.risk & 0x0F);
+  risk.rateProfile = (frame.risk >> 4) & 0x03;
+  risk.alertTrigger = (frame.risk & 0x80) != 0;
+  // Anomaly scores and trends stay on the leaf; its level already includes them
+  risk.anomalyMask = 0;
+  memset(risk.anomalyScore, 0, sizeof(risk.anomalyScore));
+  memset(&risk.trend, 0, sizeof(risk.trend));
+  return true;
+}
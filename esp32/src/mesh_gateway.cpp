@@ -0,0 +1,102 @@
+#include "mesh_gateway.h"
+#include <string.h>
+#include "mesh_frame.h"
+
+void gatewayInit(MeshGateway &gateway) {
+  memset(&gateway, 0, sizeof(gateway));
+}
+
+static int findOrAddNode(MeshGateway &gateway, const uint8_t *mac) {
+  int freeSlot = -1;
+  for (int i = 0; i < MESH_MAX_NODES; i++) {
+    if (gateway.nodes[i].active) {
+      if (memcmp(gateway.nodes[i].mac, mac, MESH_MAC_LEN) == 0) return i;
+    } else if (freeSlot < 0) {
+      freeSlot = i;
+    }
+  }
+  if (freeSlot < 0) return -1;
+
+  MeshNodeState &node = gateway.nodes[freeSlot];
+  memset(&node, 0, sizeof(node));
+  memcpy(node.mac, mac, MESH_MAC_LEN);
+  node.active = true;
+  return freeSlot;
+}
+
+bool gatewayReceive(MeshGateway &gateway, const uint8_t *mac, const uint8_t *data, size_t len, uint32_t nowMs) {
+  MeshSampleFrame frame;
+  SensorSample sample;
+  RiskStatus risk;
+  if (!decodeMeshFrame(data, len, frame, sample, risk)) {
+    gateway.rejectedFrames++;
+    return false;
+  }
+  int index = findOrAddNode(gateway, mac);
+  if (index < 0) {
+    gateway.rejectedFrames++;
+    return false;
+  }
+
+  MeshNodeState &node = gateway.nodes[index];
+  int64_t offset = (int64_t)nowMs - frame.uptimeMs;
+  uint16_t behind = node.lastSequence - frame.sequence;
+  if (node.received > 0 && frame.uptimeMs < node.lastUptimeMs && behind != 0 && behind < 0x8000 &&
+      node.lastUptimeMs - frame.uptimeMs <= MESH_REORDER_WINDOW_MS) {
+    // Overtaken by a newer frame; keep the node's position where it is
+    node.late++;
+    return false;
+  }
+  if (node.received == 0 || frame.uptimeMs < node.lastUptimeMs) {
+    // First frame, or the leaf restarted and its clock went back
+    if (node.received > 0) node.reboots++;
+    node.clockOffsetMs = offset;
+  } else {
+    uint16_t gap = frame.sequence - node.lastSequence;
+    if (gap == 0) {
+      node.duplicates++;
+      return false;
+    }
+    node.lost += gap - 1;
+    // The smallest offset is the one with the least radio/queue latency
+    if (offset < node.clockOffsetMs) node.clockOffsetMs = offset;
+  }
+  node.lastSequence = frame.sequence;
+  node.lastUptimeMs = frame.uptimeMs;
+  node.lastSeenMs = nowMs;
+  node.received++;
+
+  if (gateway.batchCount >= MESH_BATCH_MAX) {
+    gateway.overflowDrops++;
+    return false;
+  }
+  if (gateway.batchCount == 0) gateway.batchStartMs = nowMs;
+  MeshBatchEntry &entry = gateway.batch[gateway.batchCount++];
+  entry.node = index;
+  entry.gatewayTimeMs = (uint32_t)(frame.uptimeMs + node.clockOffsetMs);
+  entry.sample = sample;
+  entry.risk = risk;
+  return true;
+}
+
+bool gatewayBatchReady(const MeshGateway &gateway, uint32_t nowMs) {
+  if (gateway.batchCount == 0) return false;
+  return gateway.batchCount >= MESH_BATCH_MAX || nowMs - gateway.batchStartMs >= MESH_BATCH_INTERVAL_MS;
+}
+
+int gatewayTakeBatch(MeshGateway &gateway, MeshBatchEntry *out, int maxEntries) {
+  int count = gateway.batchCount < maxEntries ? gateway.batchCount : maxEntries;
+  memcpy(out, gateway.batch, count * sizeof(MeshBatchEntry));
+  // Anything that did not fit stays queued for the next call
+  memmove(gateway.batch, gateway.batch + count, (gateway.batchCount - count) * sizeof(MeshBatchEntry));
+  gateway.batchCount -= count;
+  return count;
+}
+
+int gatewayNodeCount(const MeshGateway &gateway) {
+  int count = 0;
+  for (int i = 0; i < MESH_MAX_NODES; i++) {
+    if (gateway.nodes[i].active) count++;
+  }
+  return count;
+}
@@ -0,0 +1,114 @@
+#include "mesh_module.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include "espnow_radio.h"
+#include "mesh_frame.h"
+#include "mesh_gateway.h"
+#include "uplink.h"
+#include "heap_monitor.h"
+#include "config.h"
+
+#ifndef MESH_ROLE
+#define MESH_ROLE MESH_ROLE_STANDALONE
+#endif
+#ifndef MESH_CHANNEL
+#define MESH_CHANNEL MESH_DEFAULT_CHANNEL
+#endif
+
+static EspNowRadio radio(MESH_CHANNEL);
+static bool radioReady = false;
+
+// Leaf
+#ifdef MESH_GATEWAY_MAC
+static const uint8_t gatewayMac[MESH_MAC_LEN] = MESH_GATEWAY_MAC;
+#else
+static const uint8_t *gatewayMac = MESH_BROADCAST_MAC;
+#endif
+static uint16_t leafSequence = 0;
+static uint32_t leafLastSampleSequence = 0;
+static uint32_t leafSendFailures = 0;
+
+// Gateway
+static MeshGateway gateway;
+static MeshUpload uploads[MESH_BATCH_MAX];
+static MeshBatchEntry batch[MESH_BATCH_MAX];   // off the loop stack: ~3.6 KB
+static uint32_t lastHistoryMs[MESH_MAX_NODES];
+
+int getMeshRole() {
+  return MESH_ROLE;
+}
+
+bool isMeshLeaf() {
+  return MESH_ROLE == MESH_ROLE_LEAF;
+}
+
+void setupMesh() {
+  if (MESH_ROLE == MESH_ROLE_STANDALONE) return;
+  gatewayInit(gateway);
+  radioReady = radio.begin();
+  if (radioReady && MESH_ROLE == MESH_ROLE_LEAF) {
+    radioReady = radio.addPeer(gatewayMac);
+  }
+  Serial.printf("Mesh %s on channel %d: %s\n",
+                MESH_ROLE == MESH_ROLE_LEAF ? "leaf" : "gateway", MESH_CHANNEL,
+                radioReady ? "ready" : "failed");
+}
+
+void meshLeafSend(const LatestSnapshot &snapshot) {
+  if (!radioReady || MESH_ROLE != MESH_ROLE_LEAF) return;
+  HeapScope heapScope(HEAP_MESH);
+  // Nothing new from the sensor task since the last frame
+  if (snapshot.sample.sequence == leafLastSampleSequence && leafSequence != 0) return;
+
+  MeshSampleFrame frame;
+  encodeMeshFrame(snapshot.sample, snapshot.risk, ++leafSequence, frame);
+  if (!radio.send(gatewayMac, (const uint8_t*)&frame, sizeof(frame))) leafSendFailures++;
+  leafLastSampleSequence = snapshot.sample.sequence;
+}
+
+static void onMeshFrame(const uint8_t *mac, const uint8_t *data, size_t len, void *context) {
+  (void)context;
+  gatewayReceive(gateway, mac, data, len, millis());
+}
+
+void meshGatewayPoll() {
+  if (!radioReady || MESH_ROLE != MESH_ROLE_GATEWAY) return;
+  HeapScope heapScope(HEAP_MESH);
+  radio.poll(onMeshFrame, NULL);
+
+  uint32_t now = millis();
+  if (!gatewayBatchReady(gateway, now)) return;
+  int count = gatewayTakeBatch(gateway, batch, MESH_BATCH_MAX);
+  for (int i = 0; i < count; i++) {
+    const MeshNodeState &node = gateway.nodes[batch[i].node];
+    MeshUpload &upload = uploads[i];
+    // Same id a leaf would use for itself when online (its eFuse MAC)
+    snprintf(upload.deviceId, sizeof(upload.deviceId), "esp32-%02x%02x%02x%02x%02x%02x",
+             node.mac[0], node.mac[1], node.mac[2], node.mac[3], node.mac[4], node.mac[5]);
+    upload.snapshot.sample = batch[i].sample;
+    upload.snapshot.sample.timestampMs = batch[i].gatewayTimeMs;
+    upload.snapshot.risk = batch[i].risk;
+    upload.snapshot.risk.timestampMs = batch[i].gatewayTimeMs;
+    upload.history = batch[i].gatewayTimeMs - lastHistoryMs[batch[i].node] >= MESH_HISTORY_INTERVAL_MS;
+    if (upload.history) lastHistoryMs[batch[i].node] = batch[i].gatewayTimeMs;
+  }
+  uplinkSendMeshBatch(uploads, count);
+}
+
+void printMeshStats() {
+  if (MESH_ROLE == MESH_ROLE_LEAF) {
+    Serial.printf("Mesh leaf: %u frames, %u send failures\n", leafSequence, leafSendFailures);
+    return;
+  }
+  if (MESH_ROLE != MESH_ROLE_GATEWAY) return;
+  Serial.printf("Mesh gateway: %d nodes, %u rejected, %u batch drops, %u rx queue drops\n",
+                gatewayNodeCount(gateway), gateway.rejectedFrames, gateway.overflowDrops, radio.rxDropped());
+  for (int i = 0; i < MESH_MAX_NODES; i++) {
+    const MeshNodeState &node = gateway.nodes[i];
+    if (!node.active) continue;
+    Serial.printf("  %02x:%02x:%02x:%02x:%02x:%02x rx=%u lost=%u dup=%u late=%u reboots=%u age=%lums\n",
+                  node.mac[0], node.mac[1], node.mac[2], node.mac[3], node.mac[4], node.mac[5],
+                  node.received, node.lost, node.duplicates, node.late, node.reboots,
+                  (unsigned long)(millis() - node.lastSeenMs));
+  }
+}
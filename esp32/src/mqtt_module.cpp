@@ -0,0 +1,174 @@
+#include "mqtt_module.h"
+#include "config.h"
+
+#if defined(UPLINK_TRANSPORT) && UPLINK_TRANSPORT == UPLINK_MQTT
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <MQTT.h>
+#include <time.h>
+#include "mesh_frame.h"
+#include "telemetry.h"
+#include "remote_config.h"
+#include "heap_monitor.h"
+#include "secure_transport.h"
+
+#ifndef MQTT_TLS
+#define MQTT_TLS 1
+#endif
+#if MQTT_TLS && !defined(MQTT_ROOT_CA)
+#error "MQTT_TLS needs MQTT_ROOT_CA: the PEM root that signs the broker's certificate"
+#endif
+#ifndef MQTT_PORT
+#if MQTT_TLS
+#define MQTT_PORT 8883
+#else
+#define MQTT_PORT 1883
+#endif
+#endif
+#ifndef MQTT_USER
+#define MQTT_USER NULL
+#define MQTT_PASSWORD NULL
+#endif
+#ifndef MQTT_TOPIC_PREFIX
+#define MQTT_TOPIC_PREFIX "landslide"
+#endif
+
+#define MQTT_TOPIC_MAX 96
+
+#if MQTT_TLS
+static SecureTransportClient mqttNet(TRANSPORT_MQTT);
+#else
+// Plaintext: credentials and data can be read on the network, and anyone on
+// it could publish a config, so the config topic is not subscribed
+static WiFiClient mqttNet;
+#endif
+static MQTTClient mqtt(MQTT_BUFFER_BYTES);
+static char onlineTopic[MQTT_TOPIC_MAX];
+static char configTopic[MQTT_TOPIC_MAX];
+static uint32_t lastConnectAttempt = 0;
+static bool connectAttempted = false;
+static uint32_t lastHistoryUpload = 0;
+static bool historyStarted = false;
+
+static void topicFor(char *out, size_t size, const char *deviceId, const char *leaf) {
+  snprintf(out, size, "%s/%s/%s", MQTT_TOPIC_PREFIX, deviceId, leaf);
+}
+
+static void onMqttMessage(MQTTClient *client, char topic[], char bytes[], int length) {
+  if (!MQTT_TLS || strcmp(topic, configTopic) != 0) return;
+  // An empty retained message clears the config, like deleting the RTDB node
+  size_t mark = arenaMark(loopArena);
+  char *json = (char *)arenaAlloc(loopArena, length + 1);
+  if (json != NULL) {
+    memcpy(json, bytes, length);
+    json[length] = 0;
+    applyRemoteConfigJson(json);
+  }
+  arenaRelease(loopArena, mark);
+}
+
+static bool connectMqtt() {
+  if (mqtt.connected()) return true;
+  if (WiFi.status() != WL_CONNECTED) return false;
+  // Back off so a missing broker does not stall every upload for the timeout
+  if (connectAttempted && millis() - lastConnectAttempt < MQTT_RECONNECT_MS) return false;
+  connectAttempted = true;
+  lastConnectAttempt = millis();
+  if (!mqtt.connect(getDeviceId(), MQTT_USER, MQTT_PASSWORD)) {
+    Serial.printf("MQTT connect failed: error %d, return code %d\n", mqtt.lastError(), mqtt.returnCode());
+    return false;
+  }
+  // Resubscribing is harmless when the broker kept the session
+  if (MQTT_TLS) mqtt.subscribe(configTopic, 1);
+  mqtt.publish(onlineTopic, "1", true, 1);
+  Serial.printf("MQTT connected to %s:%d%s%s\n", MQTT_HOST, MQTT_PORT, MQTT_TLS ? " over TLS" : "",
+                mqtt.sessionPresent() ? " (session resumed)" : "");
+  return true;
+}
+
+void setupMqtt() {
+#ifdef DEVICE_ID
+  setDeviceId(DEVICE_ID);
+#endif
+  Serial.println("Device id: " + String(getDeviceId()));
+  topicFor(onlineTopic, sizeof(onlineTopic), getDeviceId(), "online");
+  topicFor(configTopic, sizeof(configTopic), getDeviceId(), "config");
+#if MQTT_TLS
+  mqttNet.begin();
+#else
+  Serial.println("MQTT without TLS: remote config is off");
+#endif
+  mqtt.begin(MQTT_HOST, MQTT_PORT, mqttNet);
+  mqtt.setOptions(MQTT_KEEPALIVE_S, false, MQTT_TIMEOUT_MS);
+  mqtt.setWill(onlineTopic, "0", true, 1);
+  mqtt.onMessageAdvanced(onMqttMessage);
+  connectMqtt();
+}
+
+static bool publishLive(const char *deviceId, const LatestSnapshot &snapshot) {
+  MeshSampleFrame frame;
+  encodeMeshFrame(snapshot.sample, snapshot.risk, (uint16_t)snapshot.sample.sequence, frame);
+  char topic[MQTT_TOPIC_MAX];
+  topicFor(topic, sizeof(topic), deviceId, "live");
+  return mqtt.publish(topic, (const char *)&frame, sizeof(frame), true, 0);
+}
+
+static bool publishHistory(const char *deviceId, const LatestSnapshot &snapshot, uint32_t epoch) {
+  char json[TELEMETRY_JSON_MAX];
+  int len = formatTelemetryJson(json, sizeof(json), snapshot, deviceId, epoch);
+  if (len < 0) return false;
+  char topic[MQTT_TOPIC_MAX];
+  topicFor(topic, sizeof(topic), deviceId, "history");
+  return mqtt.publish(topic, json, len, false, 1);
+}
+
+int sendDataToMqtt(const LatestSnapshot &snapshot) {
+  if (!connectMqtt()) return -1;
+  // Uplink allocations are counted under "firebase" whichever transport is built
+  HeapScope heapScope(HEAP_FIREBASE);
+  bool sent = publishLive(getDeviceId(), snapshot);
+  time_t now = time(nullptr);
+  if (now >= MIN_VALID_EPOCH && (!historyStarted || millis() - lastHistoryUpload >= HISTORY_INTERVAL_MS)) {
+    publishHistory(getDeviceId(), snapshot, (uint32_t)now);
+    lastHistoryUpload = millis();
+    historyStarted = true;
+  }
+  return sent ? (int)sizeof(MeshSampleFrame) : -1;
+}
+
+void sendMeshBatchToMqtt(const MeshUpload *uploads, int count) {
+  if (!connectMqtt()) return;
+  HeapScope heapScope(HEAP_FIREBASE);
+  time_t now = time(nullptr);
+  uint32_t nowMs = millis();
+  // Messages are cheap here, so every sample goes out on its own
+  for (int i = 0; i < count; i++) {
+    const MeshUpload &upload = uploads[i];
+    publishLive(upload.deviceId, upload.snapshot);
+    if (!upload.history) continue;
+    time_t ts = now - (time_t)((nowMs - upload.snapshot.sample.timestampMs) / 1000);
+    if (ts >= MIN_VALID_EPOCH) publishHistory(upload.deviceId, upload.snapshot, (uint32_t)ts);
+  }
+}
+
+void sendDiagnosticsToMqtt(const HeapReport &report, const DeadlineMonitor &deadlines) {
+  if (!connectMqtt()) return;
+  HeapScope heapScope(HEAP_FIREBASE);
+  char *buffer = (char *)arenaAlloc(loopArena, DIAGNOSTICS_JSON_MAX);  // too big for the loop stack
+  if (buffer == NULL) return;
+  time_t now = time(nullptr);
+  uint32_t epoch = now >= MIN_VALID_EPOCH ? (uint32_t)now : 0;
+  int len = formatDiagnosticsJson(buffer, DIAGNOSTICS_JSON_MAX, report, deadlines, epoch);
+  if (len < 0) return;
+  char topic[MQTT_TOPIC_MAX];
+  topicFor(topic, sizeof(topic), getDeviceId(), "diagnostics");
+  mqtt.publish(topic, buffer, len, true, 0);
+}
+
+void pollMqtt() {
+  if (!connectMqtt()) return;
+  mqtt.loop();
+}
+
+#endif
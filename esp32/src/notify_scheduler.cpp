@@ -0,0 +1,149 @@
+#include "notify_scheduler.h"
+#include <string.h>
+
+static void bucketRefill(TokenBucket &bucket, uint32_t nowMs) {
+  uint32_t elapsed = nowMs - bucket.lastMs;
+  bucket.lastMs = nowMs;
+  bucket.tokens += elapsed * bucket.refillPerMs;
+  if (bucket.tokens > bucket.capacity) bucket.tokens = bucket.capacity;
+}
+
+void bucketInit(TokenBucket &bucket, float ratePerSecond, float capacity, uint32_t nowMs) {
+  bucket.capacity = capacity;
+  bucket.tokens = capacity;
+  bucket.refillPerMs = ratePerSecond / 1000.0f;
+  bucket.lastMs = nowMs;
+}
+
+bool bucketCanTake(TokenBucket &bucket, uint32_t nowMs) {
+  bucketRefill(bucket, nowMs);
+  return bucket.tokens >= 1.0f;
+}
+
+bool bucketTake(TokenBucket &bucket, uint32_t nowMs) {
+  if (!bucketCanTake(bucket, nowMs)) return false;
+  bucket.tokens -= 1.0f;
+  return true;
+}
+
+void notifyInit(NotificationScheduler &scheduler, uint32_t nowMs) {
+  memset(&scheduler, 0, sizeof(scheduler));
+  bucketInit(scheduler.globalBucket, NOTIFY_GLOBAL_RATE_PER_S, NOTIFY_GLOBAL_BURST, nowMs);
+}
+
+int notifyFind(const NotificationScheduler &scheduler, const char *chatId) {
+  for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+    const NotifySubscriber &sub = scheduler.subscribers[i];
+    if (sub.active && strcmp(sub.chatId, chatId) == 0) return i;
+  }
+  return -1;
+}
+
+int notifySubscribe(NotificationScheduler &scheduler, const char *chatId, uint32_t intervalMs,
+                    RiskLevel minLevel, uint32_t nowMs) {
+  if (strlen(chatId) >= NOTIFY_CHAT_ID_MAX) return -1;
+  int slot = notifyFind(scheduler, chatId);
+  if (slot < 0) {
+    for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+      if (!scheduler.subscribers[i].active) {
+        slot = i;
+        break;
+      }
+    }
+    if (slot < 0) return -1;
+
+    NotifySubscriber &sub = scheduler.subscribers[slot];
+    memset(&sub, 0, sizeof(sub));
+    strcpy(sub.chatId, chatId);
+    float rate = chatId[0] == '-' ? NOTIFY_GROUP_RATE_PER_S : NOTIFY_CHAT_RATE_PER_S;
+    bucketInit(sub.bucket, rate, NOTIFY_CHAT_BURST, nowMs);
+    sub.active = true;
+  }
+
+  // Re-subscribing only updates the preferences and forces a fresh push
+  NotifySubscriber &sub = scheduler.subscribers[slot];
+  sub.intervalMs = intervalMs;
+  sub.minLevel = minLevel;
+  sub.lastSentLevel = RISK_UNKNOWN;
+  sub.lastSentMs = nowMs - intervalMs;
+  sub.pending = false;
+  return slot;
+}
+
+bool notifyUnsubscribe(NotificationScheduler &scheduler, const char *chatId) {
+  int slot = notifyFind(scheduler, chatId);
+  if (slot < 0) return false;
+  scheduler.subscribers[slot].active = false;
+  return true;
+}
+
+int notifySubscriberCount(const NotificationScheduler &scheduler) {
+  int count = 0;
+  for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+    if (scheduler.subscribers[i].active) count++;
+  }
+  return count;
+}
+
+int notifyNextDue(NotificationScheduler &scheduler, RiskLevel level, uint32_t nowMs) {
+  bool globalAvailable = bucketCanTake(scheduler.globalBucket, nowMs);
+
+  for (int n = 0; n < NOTIFY_MAX_SUBSCRIBERS; n++) {
+    int slot = (scheduler.nextSlot + n) % NOTIFY_MAX_SUBSCRIBERS;
+    NotifySubscriber &sub = scheduler.subscribers[slot];
+    if (!sub.active) continue;
+
+    if (level < sub.minLevel) {
+      sub.pending = false;
+      continue;
+    }
+
+    bool due = nowMs - sub.lastSentMs >= sub.intervalMs || level != sub.lastSentLevel;
+    if (due && !sub.pending) {
+      sub.pending = true;
+      sub.pendingSinceMs = nowMs;
+      sub.mergedWindows = 0;
+    } else if (sub.pending) {
+      // Still waiting when further windows start: they merge into the
+      // pending push rather than producing extra messages
+      uint32_t windows = (nowMs - sub.pendingSinceMs) / sub.intervalMs;
+      if (windows > sub.mergedWindows) {
+        scheduler.stats.coalesced += windows - sub.mergedWindows;
+        sub.mergedWindows = windows;
+      }
+    }
+
+    if (sub.pending && globalAvailable && bucketCanTake(sub.bucket, nowMs)) {
+      scheduler.nextSlot = (slot + 1) % NOTIFY_MAX_SUBSCRIBERS;
+      return slot;
+    }
+  }
+  return -1;
+}
+
+void notifyMarkSent(NotificationScheduler &scheduler, int slot, RiskLevel level, uint32_t nowMs) {
+  if (slot < 0 || slot >= NOTIFY_MAX_SUBSCRIBERS) return;
+  NotifySubscriber &sub = scheduler.subscribers[slot];
+  uint32_t delay = sub.pending ? nowMs - sub.pendingSinceMs : 0;
+  sub.pending = false;
+  sub.lastSentMs = nowMs;
+  sub.lastSentLevel = level;
+
+  NotifyStats &stats = scheduler.stats;
+  stats.sent++;
+  stats.totalDelayMs += delay;
+  if (delay > stats.maxDelayMs) stats.maxDelayMs = delay;
+  if (delay >= NOTIFY_LATE_MS) stats.delayed++;
+}
+
+bool notifyTryAcquire(NotificationScheduler &scheduler, const char *chatId, uint32_t nowMs) {
+  int slot = notifyFind(scheduler, chatId);
+  bool chatAvailable = slot < 0 || bucketCanTake(scheduler.subscribers[slot].bucket, nowMs);
+  if (!chatAvailable || !bucketCanTake(scheduler.globalBucket, nowMs)) {
+    scheduler.stats.throttled++;
+    return false;
+  }
+  bucketTake(scheduler.globalBucket, nowMs);
+  if (slot >= 0) bucketTake(scheduler.subscribers[slot].bucket, nowMs);
+  return true;
+}
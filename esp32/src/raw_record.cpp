@@ -0,0 +1,64 @@
+#include "raw_record.h"
+#include <string.h>
+
+uint16_t rawRecordCrc(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+struct __attribute__((packed)) RawRecordPayload {
+  uint32_t sequence;
+  uint32_t timestampMs;
+  float accel[3];
+  float gyro[3];
+  float temperature;
+  uint16_t rainRaw;
+  uint16_t soilRaw;
+  uint8_t flags;
+};
+
+static_assert(sizeof(RawRecordPayload) == RAW_RECORD_PAYLOAD, "raw record layout changed");
+
+void rawRecordEncode(const RawSensorFrame &frame, uint8_t *out) {
+  RawRecordPayload payload;
+  payload.sequence = frame.sequence;
+  payload.timestampMs = frame.timestampMs;
+  memcpy(payload.accel, frame.accel, sizeof(payload.accel));
+  memcpy(payload.gyro, frame.gyro, sizeof(payload.gyro));
+  payload.temperature = frame.temperature;
+  payload.rainRaw = frame.rainRaw;
+  payload.soilRaw = frame.soilRaw;
+  payload.flags = frame.flags;
+
+  out[0] = RAW_RECORD_SYNC0;
+  out[1] = RAW_RECORD_SYNC1;
+  memcpy(out + 2, &payload, RAW_RECORD_PAYLOAD);
+  uint16_t crc = rawRecordCrc(out + 2, RAW_RECORD_PAYLOAD);
+  out[2 + RAW_RECORD_PAYLOAD] = crc & 0xFF;
+  out[3 + RAW_RECORD_PAYLOAD] = crc >> 8;
+}
+
+bool rawRecordDecode(const uint8_t *data, size_t len, RawSensorFrame &frame) {
+  if (len < RAW_RECORD_SIZE) return false;
+  if (data[0] != RAW_RECORD_SYNC0 || data[1] != RAW_RECORD_SYNC1) return false;
+  uint16_t crc = data[2 + RAW_RECORD_PAYLOAD] | (data[3 + RAW_RECORD_PAYLOAD] << 8);
+  if (rawRecordCrc(data + 2, RAW_RECORD_PAYLOAD) != crc) return false;
+
+  RawRecordPayload payload;
+  memcpy(&payload, data + 2, RAW_RECORD_PAYLOAD);
+  frame.sequence = payload.sequence;
+  frame.timestampMs = payload.timestampMs;
+  memcpy(frame.accel, payload.accel, sizeof(frame.accel));
+  memcpy(frame.gyro, payload.gyro, sizeof(frame.gyro));
+  frame.temperature = payload.temperature;
+  frame.rainRaw = payload.rainRaw;
+  frame.soilRaw = payload.soilRaw;
+  frame.flags = payload.flags;
+  return true;
+}
@@ -0,0 +1,174 @@
+#include "recorder.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "raw_record.h"
+#include "series_codec.h"
+#include "heap_monitor.h"
+#include "health_monitor.h"
+#include "config.h"
+
+#ifndef RECORDER_SINK
+#define RECORDER_SINK RECORDER_OFF
+#endif
+
+#define RECORDER_TASK_STACK 4096
+#define RECORDER_TASK_PRIORITY 1
+#define RECORDER_TASK_CORE 0
+#define RECORDER_FLUSH_MS 1000
+
+static QueueHandle_t recordQueue = NULL;
+static volatile uint32_t recordedFrames = 0;
+static volatile uint32_t droppedFrames = 0;
+
+static const char *flashFiles[2] = { "/raw0.bin", "/raw1.bin" };
+static int activeFile = 0;
+static File recordFile;
+// The flash sink fills one compressed block in RAM and writes it whole, so
+// the files are a sequence of SERIES_BLOCK_BYTES blocks
+static uint8_t flashBlock[SERIES_BLOCK_BYTES];
+static uint8_t dumpBlock[SERIES_BLOCK_BYTES];
+static SeriesEncoder blockEncoder;
+static uint32_t blocksWritten = 0;
+
+static File openForAppend(int index) {
+  return LittleFS.open(flashFiles[index], FILE_APPEND);
+}
+
+static size_t fileSize(const char *path) {
+  if (!LittleFS.exists(path)) return 0;
+  File f = LittleFS.open(path, FILE_READ);
+  size_t size = f ? f.size() : 0;
+  f.close();
+  return size;
+}
+
+// Streams one compressed block as raw records; blocks that fail their CRC
+// (or files from before compression) are skipped
+static void dumpBlockRecords(const uint8_t *block, size_t len) {
+  SeriesDecoder decoder;
+  if (!seriesDecoderInit(decoder, block, len)) return;
+  RawSensorFrame frame;
+  uint8_t record[RAW_RECORD_SIZE];
+  while (seriesNext(decoder, frame)) {
+    rawRecordEncode(frame, record);
+    Serial.write(record, RAW_RECORD_SIZE);
+  }
+}
+
+// Serial 'D' dumps both files (older first) and the block being filled as
+// raw records, so tools/replay reads them unchanged; 'E' erases them
+static void handleFlashCommand() {
+  int command = Serial.read();
+  if (command == 'E') {
+    recordFile.close();
+    LittleFS.remove(flashFiles[0]);
+    LittleFS.remove(flashFiles[1]);
+    activeFile = 0;
+    recordFile = openForAppend(activeFile);
+    seriesEncoderInit(blockEncoder, flashBlock, sizeof(flashBlock));
+    Serial.println("Recorder: erased");
+  } else if (command == 'D') {
+    recordFile.close();
+    for (int i = 1; i <= 2; i++) {
+      File f = LittleFS.open(flashFiles[(activeFile + i) % 2], FILE_READ);
+      if (!f) continue;
+      while (f.read(dumpBlock, sizeof(dumpBlock)) == sizeof(dumpBlock)) {
+        dumpBlockRecords(dumpBlock, sizeof(dumpBlock));
+      }
+      f.close();
+    }
+    dumpBlockRecords(flashBlock, seriesFinish(blockEncoder));
+    Serial.flush();
+    recordFile = openForAppend(activeFile);
+  }
+}
+
+static void writeBlock() {
+  seriesFinish(blockEncoder);
+  if (recordFile.size() + SERIES_BLOCK_BYTES > RECORDER_FLASH_FILE_BYTES) {
+    recordFile.close();
+    activeFile = 1 - activeFile;
+    recordFile = LittleFS.open(flashFiles[activeFile], FILE_WRITE);  // truncates the older file
+  }
+  recordFile.write(flashBlock, SERIES_BLOCK_BYTES);
+  blocksWritten++;
+  seriesEncoderInit(blockEncoder, flashBlock, sizeof(flashBlock));
+}
+
+static void writeToFlash(const RawSensorFrame &frame) {
+  if (!recordFile) return;
+  if (seriesAppend(blockEncoder, frame)) return;
+  writeBlock();
+  seriesAppend(blockEncoder, frame);
+}
+
+static void recorderTask(void *param) {
+  RawSensorFrame frame;
+  uint8_t record[RAW_RECORD_SIZE];
+  uint32_t lastFlush = millis();
+  heapTagTask(HEAP_SENSORS);
+  healthTaskStart(HEALTH_TASK_RECORDER);
+  for (;;) {
+    healthTaskIdle(HEALTH_TASK_RECORDER);
+    bool received = xQueueReceive(recordQueue, &frame, pdMS_TO_TICKS(100)) == pdTRUE;
+    healthTaskBusy(HEALTH_TASK_RECORDER);
+    if (received) {
+      if (RECORDER_SINK == RECORDER_SERIAL) {
+        rawRecordEncode(frame, record);
+        Serial.write(record, RAW_RECORD_SIZE);
+      } else {
+        writeToFlash(frame);
+      }
+      recordedFrames++;
+    }
+    if (RECORDER_SINK == RECORDER_FLASH) {
+      if (Serial.available()) handleFlashCommand();
+      if (millis() - lastFlush >= RECORDER_FLUSH_MS) {
+        recordFile.flush();
+        lastFlush = millis();
+      }
+    }
+  }
+}
+
+void setupRecorder() {
+  if (RECORDER_SINK == RECORDER_OFF || recordQueue != NULL) return;
+  if (RECORDER_SINK == RECORDER_FLASH) {
+    if (!LittleFS.begin(true)) {
+      Serial.println("Recorder: LittleFS mount failed");
+      return;
+    }
+    // Keep filling the less full file; the other one holds older data
+    activeFile = fileSize(flashFiles[1]) < fileSize(flashFiles[0]) ? 1 : 0;
+    // A file that is not whole blocks (raw records from an older build) starts over
+    if (fileSize(flashFiles[activeFile]) % SERIES_BLOCK_BYTES != 0) {
+      recordFile = LittleFS.open(flashFiles[activeFile], FILE_WRITE);
+    } else {
+      recordFile = openForAppend(activeFile);
+    }
+    seriesEncoderInit(blockEncoder, flashBlock, sizeof(flashBlock));
+  }
+  recordQueue = xQueueCreate(RECORDER_QUEUE_LENGTH, sizeof(RawSensorFrame));
+  if (recordQueue == NULL) return;
+  xTaskCreatePinnedToCore(recorderTask, "recorder", RECORDER_TASK_STACK, NULL,
+                          RECORDER_TASK_PRIORITY, NULL, RECORDER_TASK_CORE);
+  Serial.printf("Recorder: %s\n", RECORDER_SINK == RECORDER_SERIAL ? "serial" : "flash");
+}
+
+void recordRawFrame(const RawSensorFrame &frame) {
+  if (recordQueue == NULL) return;
+  if (xQueueSend(recordQueue, &frame, 0) != pdTRUE) droppedFrames++;
+}
+
+void printRecorderStats() {
+  if (recordQueue == NULL) return;
+  Serial.printf("Recorder: %u frames, %u dropped", recordedFrames, droppedFrames);
+  if (RECORDER_SINK == RECORDER_FLASH && recordedFrames > 0) {
+    uint32_t stored = blocksWritten * SERIES_BLOCK_BYTES + (blockEncoder.bitPos + 7) / 8;
+    Serial.printf(", %.1f bytes/frame (raw %d)", (float)stored / recordedFrames, RAW_RECORD_SIZE);
+  }
+  Serial.println();
+}
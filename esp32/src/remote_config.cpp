@@ -0,0 +1,125 @@
+#include "remote_config.h"
+#include <FirebaseESP32.h>
+#include "device_id.h"
+#include "heap_monitor.h"
+#include "uplink.h"
+#include "config.h"
+
+#ifndef UPLINK_TRANSPORT
+#define UPLINK_TRANSPORT UPLINK_FIREBASE
+#endif
+
+FirebaseData configStream;
+
+// Staging buffer, only touched from the stream callback or the MQTT config message
+static RuntimeConfig stagedConfig;
+static unsigned long rejectedUpdates = 0;
+
+static const char *thresholdKeys[] = {
+  "tiltSafeMax", "tiltWarningMin", "tiltDanger",
+  "moistureWarning", "moistureDanger",
+  "rainWarning", "rainDanger",
+  "vibrationWarning", "vibrationDanger",
+  "creepWarning", "creepDanger"
+};
+
+String getRemoteConfigPath() {
+  return String("/devices/") + getDeviceId() + "/config";
+}
+
+unsigned long getRemoteConfigRejected() {
+  return rejectedUpdates;
+}
+
+static bool applyJsonObject(RuntimeConfig &config, FirebaseJson &json, const String &prefix) {
+  bool applied = false;
+  FirebaseJsonData result;
+
+  if (prefix.length() == 0) {
+    json.get(result, "mode");
+    if (result.success) applied |= applyConfigMode(config, result.stringValue.c_str());
+  }
+
+  for (unsigned i = 0; i < sizeof(thresholdKeys) / sizeof(thresholdKeys[0]); i++) {
+    json.get(result, prefix + thresholdKeys[i]);
+    if (result.success) applied |= applyConfigValue(config, thresholdKeys[i], result.floatValue);
+  }
+  return applied;
+}
+
+static void publishStagedConfig(bool applied) {
+  if (!applied) return;
+  if (publishRuntimeConfig(stagedConfig)) {
+    RuntimeConfig live = getRuntimeConfig();
+    Serial.printf("Config v%u applied (mode %s)\n", live.version, deviceModeName(live.mode));
+  } else {
+    rejectedUpdates++;
+    Serial.println("Config update rejected: thresholds out of order or out of range");
+  }
+}
+
+static void configStreamCallback(StreamData data) {
+  HeapScope heapScope(HEAP_CONFIG);
+  // Start from what is live so a partial update keeps the other fields
+  stagedConfig = getRuntimeConfig();
+  String path = data.dataPath();
+  String type = data.dataType();
+  bool applied = false;
+
+  if (type == "json") {
+    FirebaseJson &json = data.jsonObject();
+    if (path == "/") {
+      applied = applyJsonObject(stagedConfig, json, "thresholds/");
+      applied |= applyJsonObject(stagedConfig, json, "");
+    } else if (path == "/thresholds") {
+      applied = applyJsonObject(stagedConfig, json, "");
+    }
+  } else if (path == "/mode" && type == "string") {
+    applied = applyConfigMode(stagedConfig, data.stringData().c_str());
+  } else if (path.startsWith("/thresholds/") && (type == "int" || type == "float" || type == "double")) {
+    String key = path.substring(strlen("/thresholds/"));
+    float value = type == "int" ? (float)data.intData() : data.floatData();
+    applied = applyConfigValue(stagedConfig, key.c_str(), value);
+  } else if (type == "null") {
+    // Node deleted: fall back to the built-in defaults
+    defaultRuntimeConfig(stagedConfig);
+    applied = true;
+  }
+
+  publishStagedConfig(applied);
+}
+
+void applyRemoteConfigJson(const char *json) {
+  HeapScope heapScope(HEAP_CONFIG);
+  stagedConfig = getRuntimeConfig();
+  bool applied;
+  if (json[0] == 0) {
+    defaultRuntimeConfig(stagedConfig);
+    applied = true;
+  } else {
+    FirebaseJson doc;
+    doc.setJsonData(json);
+    applied = applyJsonObject(stagedConfig, doc, "thresholds/");
+    applied |= applyJsonObject(stagedConfig, doc, "");
+  }
+  publishStagedConfig(applied);
+}
+
+static void configStreamTimeout(bool timeout) {
+  if (timeout) Serial.println("Config stream timed out, resuming...");
+}
+
+void setupRemoteConfig() {
+  RuntimeConfig defaults;
+  defaultRuntimeConfig(defaults);
+  publishRuntimeConfig(defaults);
+  // The MQTT uplink delivers the same document on its config topic
+  if (UPLINK_TRANSPORT != UPLINK_FIREBASE) return;
+
+  Serial.println("Config stream: " + getRemoteConfigPath());
+  if (!Firebase.beginStream(configStream, getRemoteConfigPath())) {
+    Serial.println("Config stream failed: " + configStream.errorReason());
+    return;
+  }
+  Firebase.setStreamCallback(configStream, configStreamCallback, configStreamTimeout);
+}
@@ -0,0 +1,56 @@
+#include "risk.h"
+#include "fastmath.h"
+
+bool riskDangerReading(const RiskThresholds &t, float angleX, float angleY, float soilMoistureValue,
+                       float rainValue, float vibrationRMS) {
+  return fastMaxAbs(angleX, angleY) > t.tiltDanger ||
+         soilMoistureValue * 100 >= t.moistureDanger ||  // Wet soil
+         rainValue * 100 >= t.rainDanger ||
+         vibrationRMS >= t.vibrationDanger;
+}
+
+void classifyRisk(const RiskThresholds &t, float angleX, float angleY, float soilMoistureValue,
+                  float rainValue, float vibrationRMS, RiskLevel &riskLevel, bool &alertTrigger) {
+  // Danger/Awas condition: any one channel, whatever the others read
+  if (riskDangerReading(t, angleX, angleY, soilMoistureValue, rainValue, vibrationRMS)) {
+    riskLevel = RISK_DANGER;
+    alertTrigger = true;
+    return;
+  }
+
+  float integerMoisture = soilMoistureValue * 100;  // Convert to percentage
+  float integerRain = rainValue * 100;              // Convert to percentage
+  float tiltAngle = fastMaxAbs(angleX, angleY);     // Use the maximum tilt angle
+
+  // Default to safe
+  riskLevel = RISK_SAFE;
+  alertTrigger = false;
+
+  // Safe/Aman condition
+  if (tiltAngle <= t.tiltSafeMax &&
+      integerMoisture < t.moistureWarning && // Dry soil
+      integerRain < t.rainWarning &&
+      vibrationRMS < t.vibrationWarning) {
+    riskLevel = RISK_SAFE;
+    alertTrigger = false;
+  }
+  // Warning/Waspada condition
+  else if ((tiltAngle > t.tiltWarningMin && tiltAngle <= t.tiltDanger) ||
+          (integerMoisture >= t.moistureWarning && integerMoisture < t.moistureDanger) || // Moist soil
+          (integerRain >= t.rainWarning && integerRain < t.rainDanger) ||
+          (vibrationRMS >= t.vibrationWarning && vibrationRMS < t.vibrationDanger)) {
+    riskLevel = RISK_WARNING;
+    alertTrigger = false;
+  }
+}
+
+void applyTrendRisk(const RiskThresholds &t, const TrendFeatures &trend, RiskLevel &riskLevel,
+                    bool &alertTrigger) {
+  if (!trend.ratesValid) return;
+  if (trend.tiltVelocity >= t.creepDanger) {
+    riskLevel = RISK_DANGER;
+    alertTrigger = true;
+  } else if (trend.tiltVelocity >= t.creepWarning && riskLevel < RISK_WARNING) {
+    riskLevel = RISK_WARNING;
+  }
+}
@@ -0,0 +1,86 @@
+#include "runtime_config.h"
+#include <string.h>
+#include "seqlock.h"
+
+static Seqlock<RuntimeConfig> publishedConfig;
+static bool configPublished = false;
+
+void defaultRuntimeConfig(RuntimeConfig &config) {
+  config.version = 0;
+  config.thresholds.tiltSafeMax = 10.0;
+  config.thresholds.tiltWarningMin = 5.0;
+  config.thresholds.tiltDanger = 15.0;
+  config.thresholds.moistureWarning = 30;
+  config.thresholds.moistureDanger = 70;
+  config.thresholds.rainWarning = 20;
+  config.thresholds.rainDanger = 30;
+  config.thresholds.vibrationWarning = 0.5;  // Below 0.5 m/s² is considered stable
+  config.thresholds.vibrationDanger = 1.0;   // Between 0.5-1.0 m/s² is light vibration
+  config.thresholds.creepWarning = 0.5;      // deg/h of sustained tilt growth
+  config.thresholds.creepDanger = 2.0;
+  config.mode = MODE_NORMAL;
+}
+
+bool validateRuntimeConfig(const RuntimeConfig &config) {
+  const RiskThresholds &t = config.thresholds;
+  if (t.tiltWarningMin < 0 || t.tiltWarningMin > t.tiltSafeMax || t.tiltSafeMax > t.tiltDanger) return false;
+  if (t.tiltDanger > 90) return false;
+  if (t.moistureWarning < 0 || t.moistureWarning >= t.moistureDanger || t.moistureDanger > 100) return false;
+  if (t.rainWarning < 0 || t.rainWarning >= t.rainDanger || t.rainDanger > 100) return false;
+  if (t.vibrationWarning < 0 || t.vibrationWarning >= t.vibrationDanger) return false;
+  if (t.creepWarning <= 0 || t.creepWarning >= t.creepDanger) return false;
+  return config.mode <= MODE_TEST;
+}
+
+bool applyConfigValue(RuntimeConfig &config, const char *key, float value) {
+  RiskThresholds &t = config.thresholds;
+  if (strcmp(key, "tiltSafeMax") == 0) t.tiltSafeMax = value;
+  else if (strcmp(key, "tiltWarningMin") == 0) t.tiltWarningMin = value;
+  else if (strcmp(key, "tiltDanger") == 0) t.tiltDanger = value;
+  else if (strcmp(key, "moistureWarning") == 0) t.moistureWarning = value;
+  else if (strcmp(key, "moistureDanger") == 0) t.moistureDanger = value;
+  else if (strcmp(key, "rainWarning") == 0) t.rainWarning = value;
+  else if (strcmp(key, "rainDanger") == 0) t.rainDanger = value;
+  else if (strcmp(key, "vibrationWarning") == 0) t.vibrationWarning = value;
+  else if (strcmp(key, "vibrationDanger") == 0) t.vibrationDanger = value;
+  else if (strcmp(key, "creepWarning") == 0) t.creepWarning = value;
+  else if (strcmp(key, "creepDanger") == 0) t.creepDanger = value;
+  else return false;
+  return true;
+}
+
+bool applyConfigMode(RuntimeConfig &config, const char *mode) {
+  if (strcmp(mode, "normal") == 0) config.mode = MODE_NORMAL;
+  else if (strcmp(mode, "silent") == 0) config.mode = MODE_SILENT;
+  else if (strcmp(mode, "test") == 0) config.mode = MODE_TEST;
+  else return false;
+  return true;
+}
+
+const char* deviceModeName(DeviceMode mode) {
+  switch (mode) {
+    case MODE_NORMAL: return "normal";
+    case MODE_SILENT: return "silent";
+    case MODE_TEST: return "test";
+    default: return "unknown";
+  }
+}
+
+RuntimeConfig getRuntimeConfig() {
+  if (!configPublished) {
+    RuntimeConfig config;
+    defaultRuntimeConfig(config);
+    return config;
+  }
+  return publishedConfig.read();
+}
+
+// Single writer: the remote config stream (or setup before it starts)
+bool publishRuntimeConfig(const RuntimeConfig &config) {
+  if (!validateRuntimeConfig(config)) return false;
+  RuntimeConfig accepted = config;
+  accepted.version = publishedConfig.version() + 1;
+  publishedConfig.write(accepted);
+  configPublished = true;
+  return true;
+}
@@ -0,0 +1,103 @@
+#include "secure_transport.h"
+#include <lwip/sockets.h>
+#include "ca_roots.h"
+#include "config.h"
+
+// The broker is on site, so its root comes from config.h
+#ifndef MQTT_ROOT_CA
+#define MQTT_ROOT_CA NULL
+#endif
+
+static TransportStats transportStats[TRANSPORT_COUNT];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+static const char *transportNames[TRANSPORT_COUNT] = { "firebase", "telegram", "mqtt" };
+
+SecureTransportClient::SecureTransportClient(TransportId id) : transportId(id) {}
+
+void SecureTransportClient::begin() {
+  setCACert(transportRootCA(transportId));
+}
+
+int SecureTransportClient::connect(const char *host, uint16_t port) {
+  unsigned long start = millis();
+  int result = WiFiClientSecure::connect(host, port);
+  recordTransportHandshake(transportId, result == 1, millis() - start);
+  if (result != 1) return result;
+
+  // Let the stack notice a dead peer instead of the next request timing out
+  int fd = sslclient->socket;
+  int enable = 1;
+  int idle = TRANSPORT_KEEPALIVE_IDLE_S;
+  int interval = TRANSPORT_KEEPALIVE_INTERVAL_S;
+  int count = TRANSPORT_KEEPALIVE_COUNT;
+  setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+  setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+  return result;
+}
+
+const char* transportRootCA(TransportId id) {
+  switch (id) {
+    case TRANSPORT_TELEGRAM: return TELEGRAM_ROOT_CA;
+    case TRANSPORT_MQTT: return MQTT_ROOT_CA;
+    default: return FIREBASE_ROOT_CA;
+  }
+}
+
+void recordTransportHandshake(TransportId id, bool ok, uint32_t durationMs) {
+  portENTER_CRITICAL(&statsMux);
+  TransportStats &stats = transportStats[id];
+  if (ok) {
+    stats.handshakes++;
+    stats.totalHandshakeMs += durationMs;
+    if (durationMs > stats.maxHandshakeMs) stats.maxHandshakeMs = durationMs;
+  } else {
+    stats.handshakeFailures++;
+  }
+  portEXIT_CRITICAL(&statsMux);
+}
+
+void recordTransportRequest(TransportId id, bool reused, uint32_t durationMs) {
+  portENTER_CRITICAL(&statsMux);
+  TransportStats &stats = transportStats[id];
+  stats.requests++;
+  if (reused) {
+    stats.reusedRequests++;
+    stats.totalWarmRequestMs += durationMs;
+  } else {
+    stats.totalColdRequestMs += durationMs;
+  }
+  portEXIT_CRITICAL(&statsMux);
+}
+
+TransportStats getTransportStats(TransportId id) {
+  portENTER_CRITICAL(&statsMux);
+  TransportStats stats = transportStats[id];
+  portEXIT_CRITICAL(&statsMux);
+  return stats;
+}
+
+// Average handshake cost. Measured directly where the transport owns the
+// socket (Telegram); for clients that connect internally (Firebase) it is
+// the difference between the average cold and warm request times.
+uint32_t estimateHandshakeMs(const TransportStats &stats) {
+  if (stats.handshakes > 0) return stats.totalHandshakeMs / stats.handshakes;
+  uint32_t cold = stats.requests - stats.reusedRequests;
+  if (cold == 0 || stats.reusedRequests == 0) return 0;
+  uint32_t coldAvg = stats.totalColdRequestMs / cold;
+  uint32_t warmAvg = stats.totalWarmRequestMs / stats.reusedRequests;
+  return coldAvg > warmAvg ? coldAvg - warmAvg : 0;
+}
+
+void printTransportStats() {
+  for (int i = 0; i < TRANSPORT_COUNT; i++) {
+    TransportStats stats = getTransportStats((TransportId)i);
+    if (i == TRANSPORT_MQTT && stats.handshakes == 0 && stats.handshakeFailures == 0) continue;
+    uint32_t cold = stats.requests - stats.reusedRequests;
+    Serial.printf("TLS %s: requests %u reused %u cold %u handshakes %u failed %u avg handshake %u ms max %u ms\n",
+                  transportNames[i], stats.requests, stats.reusedRequests, cold,
+                  stats.handshakes, stats.handshakeFailures,
+                  estimateHandshakeMs(stats), stats.maxHandshakeMs);
+  }
+}
@@ -0,0 +1,94 @@
+#include "sensor_pipeline.h"
+#include <string.h>
+#include "fastmath.h"
+
+// Same integer arithmetic as Arduino map()
+static long adcMap(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+float rainFromRaw(uint16_t raw) {
+  float calibratedValue = adcMap(raw, 4095, 0, 0, 100);
+  return calibratedValue / 100.0;
+}
+
+float soilMoistureFromRaw(uint16_t raw) {
+  float calibratedValue = adcMap(raw, DRY_SOIL_VALUE, WET_SOIL_VALUE, 0, 100);
+  if (calibratedValue < 0) calibratedValue = 0;
+  if (calibratedValue > 100) calibratedValue = 100;
+  return calibratedValue / 100.0;
+}
+
+void pipelineInit(SensorPipeline &pipeline) {
+  memset(&pipeline, 0, sizeof(pipeline));
+  fusionInit(pipeline.fusion, 1.0f / SENSOR_SAMPLE_RATE_HZ, FUSION_TIME_CONSTANT, FUSION_ACCEL_DECIMATION);
+  pipeline.rateProfile = RATE_FULL;
+  pipeline.vibrationWindow = ratePolicy(RATE_FULL).vibrationWindow;
+}
+
+static void applyRateProfile(SensorPipeline &pipeline, uint8_t profile) {
+  const RatePolicy &policy = ratePolicy((RateProfile)profile);
+  fusionSetRate(pipeline.fusion, 1.0f / policy.sampleRateHz, FUSION_TIME_CONSTANT);
+  pipeline.vibrationWindow = policy.vibrationWindow < VIBRATION_SAMPLES ? policy.vibrationWindow : VIBRATION_SAMPLES;
+  pipeline.rateProfile = profile;
+}
+
+static void fillDefaultMotion(SensorSample &sample) {
+  sample.accelX = 0;
+  sample.accelY = 0;
+  sample.accelZ = 9.8;
+  sample.gyroX = 0;
+  sample.gyroY = 0;
+  sample.gyroZ = 0;
+  sample.temperature = 25.0;
+  sample.vibrationRMS = 0;
+}
+
+void pipelineProcess(SensorPipeline &pipeline, const RawSensorFrame &raw, SensorSample &sample) {
+  uint8_t profile = (raw.flags & RAW_FLAG_RATE_MASK) >> RAW_FLAG_RATE_SHIFT;
+  if (profile != pipeline.rateProfile) applyRateProfile(pipeline, profile);
+  if (raw.flags & RAW_FLAG_ANALOG) {
+    pipeline.rain = rainFromRaw(raw.rainRaw);
+    pipeline.soilMoisture = soilMoistureFromRaw(raw.soilRaw);
+  }
+  sample.sequence = raw.sequence;
+  sample.timestampMs = raw.timestampMs;
+  sample.rain = pipeline.rain;
+  sample.soilMoisture = pipeline.soilMoisture;
+
+  if (!(raw.flags & RAW_FLAG_MOTION)) {
+    // No MPU6050 reading: keep the last tilt, report a level, still board
+    fillDefaultMotion(sample);
+    sample.angleX = pipeline.fusion.angleX;
+    sample.angleY = pipeline.fusion.angleY;
+    return;
+  }
+
+  float (*buffer)[3] = pipeline.vibrationBuffer;
+  buffer[pipeline.vibrationIndex][0] = raw.accel[0];
+  buffer[pipeline.vibrationIndex][1] = raw.accel[1];
+  buffer[pipeline.vibrationIndex][2] = raw.accel[2] - 9.8f;
+  pipeline.vibrationIndex = (pipeline.vibrationIndex + 1) % VIBRATION_SAMPLES;
+  // RMS over the newest `vibrationWindow` entries of the ring
+  float sumOfSquares = 0;
+  int index = pipeline.vibrationIndex;
+  for (int i = 0; i < pipeline.vibrationWindow; i++) {
+    index = index == 0 ? VIBRATION_SAMPLES - 1 : index - 1;
+    sumOfSquares += buffer[index][0] * buffer[index][0];
+    sumOfSquares += buffer[index][1] * buffer[index][1];
+    sumOfSquares += buffer[index][2] * buffer[index][2];
+  }
+
+  fusionUpdate(pipeline.fusion, raw.accel[0], raw.accel[1], raw.accel[2], raw.gyro[0], raw.gyro[1]);
+
+  sample.accelX = raw.accel[0];
+  sample.accelY = raw.accel[1];
+  sample.accelZ = raw.accel[2];
+  sample.gyroX = raw.gyro[0];
+  sample.gyroY = raw.gyro[1];
+  sample.gyroZ = raw.gyro[2];
+  sample.temperature = raw.temperature;
+  sample.angleX = pipeline.fusion.angleX;
+  sample.angleY = pipeline.fusion.angleY;
+  sample.vibrationRMS = fastSqrt(sumOfSquares / (pipeline.vibrationWindow * 3)) - 0.6f;
+}
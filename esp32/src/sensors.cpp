@@ -4,26 +4,41 @@
 #include <Arduino.h>
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
+#include "sensor_pipeline.h"
+#include "recorder.h"
+#include "local_server.h"
+#include "alarm_task.h"
+#include <esp_timer.h>
+#include "heap_monitor.h"
+#include "snapshot.h"
+#include "health_monitor.h"
+#include "i2c_bus.h"
 
 #define RAIN_SENSOR 35
 #define SOIL_MOISTURE 33
-#define VIBRATION_SAMPLES 20
+
+// Acquisition task; the sample math lives in sensor_pipeline.cpp
+#define SENSOR_TASK_STACK 4096
+#define SENSOR_TASK_PRIORITY 3
+#define SENSOR_TASK_CORE 1
+// A read waits behind at most one display chunk; well within a sample period
+#define MPU_READ_TIMEOUT_MS 5
 
 Adafruit_MPU6050 mpu;
 bool mpuAvailable = false;
-float vibrationBuffer[VIBRATION_SAMPLES][3];
-int vibrationIndex = 0;
-float vibrationRMS = 0.0;
 
-// Soil moisture calibration values
-const int DRY_SOIL_VALUE = 2650;
-const int WET_SOIL_VALUE = 0;
+static SensorPipeline pipeline;   // owned by the sensor task
+static SensorSample currentSample; // owned by the sensor task
+static TaskHandle_t sensorTaskHandle = NULL;
+static uint8_t sensorRateProfile = RATE_FULL; // set by the classifier, read by the sensor task
+static bool sensorRestartRequested = false;    // set by the loop, consumed by the sensor task
 
 float getVibrationRMS() {
-  return vibrationRMS;
+  return readLatestSample().vibrationRMS;
 }
 
 void scanI2CDevices() {
+    I2cBusLock lock(I2C_DEVICE_OTHER);
     Serial.println("Scanning I2C devices...");
     byte error, address;
     int nDevices = 0;
@@ -44,9 +59,14 @@ void setupSensors() {
   pinMode(SOIL_MOISTURE, INPUT);
 }
 
-void setupMPU6050() {
-  Wire.begin();
-  scanI2CDevices();
+// Driver reads go through the bus task at sensor priority
+static bool mpuTransfer(uint8_t address, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen,
+                        mpu6050_read_done_t done, void *arg) {
+  return i2cTransferAsync(I2C_DEVICE_MPU6050, address, tx, txLen, rx, rxLen, done, arg);
+}
+
+static void beginMPU6050() {
+  I2cBusLock lock(I2C_DEVICE_MPU6050);
   if (mpu.begin(0x68)) {
     mpuAvailable = true;
   } else if (mpu.begin(0x69)) {
@@ -58,69 +78,125 @@ void setupMPU6050() {
   mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
   mpu.setGyroRange(MPU6050_RANGE_500_DEG);
   mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
-  for (int i = 0; i < VIBRATION_SAMPLES; i++) {
-    vibrationBuffer[i][0] = 0;
-    vibrationBuffer[i][1] = 0;
-    vibrationBuffer[i][2] = 0;
-  }
+  mpu.setAsyncTransfer(mpuTransfer);
+}
+
+// The bus itself is set up by setupI2cBus()
+void setupMPU6050() {
+  scanI2CDevices();
+  beginMPU6050();
+}
+
+void requestSensorRestart() {
+  __atomic_store_n(&sensorRestartRequested, true, __ATOMIC_RELAXED);
+}
+
+// Sensor task: a bus left in a bad state by a glitch comes back after a re-init
+static void restartSensors() {
+  i2cBusReset();
+  beginMPU6050();
+  Serial.printf("Sensors restarted, MPU6050 %s\n", mpuAvailable ? "found" : "missing");
 }
 
 float readRainSensor() {
-  int rainValue = analogRead(RAIN_SENSOR);
-  float calibratedValue = map(rainValue, 4095, 0, 0, 100);
-  return calibratedValue / 100.0;
+  return rainFromRaw(analogRead(RAIN_SENSOR));
 }
 
 float readSoilMoistureSensor() {
-  int soilMoistureValue = analogRead(SOIL_MOISTURE);
-  float calibratedValue = map(soilMoistureValue, DRY_SOIL_VALUE, WET_SOIL_VALUE, 0, 100);
-  calibratedValue = constrain(calibratedValue, 0, 100);
-  return calibratedValue / 100.0;
-}
-
-void readMPU6050Data(sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp) {
-  if (mpuAvailable) {
-    if (!mpu.getEvent(&a, &g, &temp)) {
-      a.acceleration.x = 0;
-      a.acceleration.y = 0;
-      a.acceleration.z = 9.8;
-      g.gyro.x = 0;
-      g.gyro.y = 0;
-      g.gyro.z = 0;
-      temp.temperature = 25.0;
-      vibrationRMS = 0;
-      return;
-    }
-    vibrationBuffer[vibrationIndex][0] = a.acceleration.x;
-    vibrationBuffer[vibrationIndex][1] = a.acceleration.y;
-    vibrationBuffer[vibrationIndex][2] = a.acceleration.z - 9.8;
-    vibrationIndex = (vibrationIndex + 1) % VIBRATION_SAMPLES;
-    float sumOfSquares = 0;
-    for (int i = 0; i < VIBRATION_SAMPLES; i++) {
-      sumOfSquares += vibrationBuffer[i][0] * vibrationBuffer[i][0];
-      sumOfSquares += vibrationBuffer[i][1] * vibrationBuffer[i][1];
-      sumOfSquares += vibrationBuffer[i][2] * vibrationBuffer[i][2];
+  return soilMoistureFromRaw(analogRead(SOIL_MOISTURE));
+}
+
+static void mpuReadDone(bool ok, void *arg) {
+  xTaskNotifyGive((TaskHandle_t)arg);
+}
+
+// Runs only in the sensor task: the one place that talks to the MPU6050.
+// Starts the motion read on the bus and returns without waiting for it.
+static bool startMotionRead() {
+  if (!mpuAvailable) return false;
+  ulTaskNotifyTake(pdTRUE, 0);   // a late completion of a read that timed out
+  return mpu.startRead(mpuReadDone, xTaskGetCurrentTaskHandle());
+}
+
+static void acquireRawFrame(RawSensorFrame &raw, bool readAnalog, bool reading) {
+  sensors_event_t a, g, temp;
+  raw.flags = 0;
+  if (readAnalog) {
+    raw.rainRaw = analogRead(RAIN_SENSOR);
+    raw.soilRaw = analogRead(SOIL_MOISTURE);
+    raw.flags |= RAW_FLAG_ANALOG;
+  }
+  bool motion = false;
+  if (reading) {
+    // A stale notification only ends one wait early
+    while (mpu.readPending() && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MPU_READ_TIMEOUT_MS)) > 0) {}
+    motion = mpu.finishRead(&a, &g, &temp);
+  } else if (mpuAvailable) {
+    // The bus queue was full: read in place instead
+    I2cBusLock lock(I2C_DEVICE_MPU6050);
+    motion = mpu.getEvent(&a, &g, &temp);
+  }
+  if (motion) {
+    raw.accel[0] = a.acceleration.x;
+    raw.accel[1] = a.acceleration.y;
+    raw.accel[2] = a.acceleration.z;
+    raw.gyro[0] = g.gyro.x;
+    raw.gyro[1] = g.gyro.y;
+    raw.gyro[2] = g.gyro.z;
+    raw.temperature = temp.temperature;
+    raw.flags |= RAW_FLAG_MOTION;
+  }
+}
+
+void setSensorRateProfile(RateProfile profile) {
+  __atomic_store_n(&sensorRateProfile, (uint8_t)profile, __ATOMIC_RELAXED);
+}
+
+static void sensorTask(void *param) {
+  TickType_t lastWake = xTaskGetTickCount();
+  uint32_t sampleCount = 0;
+  RawSensorFrame raw = {};
+  bool handOffPending = false;   // `raw` and `currentSample` still to be recorded and streamed
+  heapTagTask(HEAP_SENSORS);
+  healthTaskStart(HEALTH_TASK_SENSORS);
+  for (;;) {
+    // Outside the cycle budget: the MPU6050 takes ~100 ms to come up
+    if (__atomic_exchange_n(&sensorRestartRequested, false, __ATOMIC_RELAXED)) restartSensors();
+    healthTaskBusy(HEALTH_TASK_SENSORS);
+    uint8_t profile = __atomic_load_n(&sensorRateProfile, __ATOMIC_RELAXED);
+    uint32_t acquiredUs = (uint32_t)esp_timer_get_time();
+    bool reading = startMotionRead();
+    // While the read is on the bus: hand the previous sample on. The new one
+    // is processed as soon as it lands, so the alarm does not wait a period.
+    if (handOffPending) {
+      recordRawFrame(raw);
+      liveStreamSample(currentSample);
     }
-    vibrationRMS = sqrt(sumOfSquares / (VIBRATION_SAMPLES * 3)) - 0.6;
-  } else {
-    a.acceleration.x = 0;
-    a.acceleration.y = 0;
-    a.acceleration.z = 9.8;
-    g.gyro.x = 0;
-    g.gyro.y = 0;
-    g.gyro.z = 0;
-    temp.temperature = 25.0;
-    vibrationRMS = 0;
+    acquireRawFrame(raw, sampleCount % ANALOG_DECIMATION == 0, reading);
+    // The frame carries its rate so the pipeline (and a replay) follows it
+    raw.flags |= profile << RAW_FLAG_RATE_SHIFT;
+    raw.sequence = ++sampleCount;
+    raw.timestampMs = millis();
+    pipelineProcess(pipeline, raw, currentSample);
+    // Before anything else sees the sample: a danger reading sounds the alarm now
+    alarmCheckSample(currentSample, acquiredUs);
+    publishSensorSample(currentSample);
+    handOffPending = true;
+    healthTaskIdle(HEALTH_TASK_SENSORS);
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / ratePolicy((RateProfile)profile).sampleRateHz));
   }
 }
 
-void readAllSensorsData(float &rainValue, float &soilMoistureValue, sensors_event_t &a, sensors_event_t &g, sensors_event_t &temp) {
-  rainValue = readRainSensor();
-  soilMoistureValue = readSoilMoistureSensor();
-  readMPU6050Data(a, g, temp);
+void startSensorTask() {
+  if (sensorTaskHandle != NULL) return;
+  pipelineInit(pipeline);
+  xTaskCreatePinnedToCore(sensorTask, "sensors", SENSOR_TASK_STACK, NULL,
+                          SENSOR_TASK_PRIORITY, &sensorTaskHandle, SENSOR_TASK_CORE);
+}
 
+void printSensorSample(const SensorSample &sample) {
   Serial.printf("AX: %.2f, AY: %.2f, AZ: %.2f | GX: %.2f, GY: %.2f, GZ: %.2f | T: %.2f | R: %.2f | M: %.2f | VIB: %.2f \n", 
-               a.acceleration.x, a.acceleration.y, a.acceleration.z, 
-               g.gyro.x, g.gyro.y, g.gyro.z, 
-               temp.temperature, rainValue, soilMoistureValue, vibrationRMS); 
-}
\ No newline at end of file
+               sample.accelX, sample.accelY, sample.accelZ, 
+               sample.gyroX, sample.gyroY, sample.gyroZ, 
+               sample.temperature, sample.rain, sample.soilMoisture, sample.vibrationRMS); 
+}
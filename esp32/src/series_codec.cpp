@@ -0,0 +1,273 @@
+#include "series_codec.h"
+#include <string.h>
+#include "raw_record.h"
+
+// Bits are packed most significant first
+
+static bool writeBits(SeriesEncoder &e, uint32_t value, int bits) {
+  size_t limit = (e.capacity - SERIES_HEADER_BYTES) * 8;
+  if (e.bitPos + bits > limit) return false;
+  uint8_t *out = e.block + SERIES_HEADER_BYTES + (e.bitPos >> 3);
+  int offset = e.bitPos & 7;
+  // Line the value up under the current byte, then OR in the bytes it spans
+  uint64_t word = (uint64_t)(value & (uint32_t)(((uint64_t)1 << bits) - 1)) << (64 - offset - bits);
+  for (int i = 0; i < (offset + bits + 7) >> 3; i++) out[i] |= (uint8_t)(word >> (56 - 8 * i));
+  e.bitPos += bits;
+  return true;
+}
+
+static bool readBits(SeriesDecoder &d, int bits, uint32_t &value) {
+  if (d.bitPos + bits > d.bitLength) return false;
+  const uint8_t *in = d.payload + (d.bitPos >> 3);
+  int offset = d.bitPos & 7;
+  uint64_t word = 0;
+  for (int i = 0; i < (offset + bits + 7) >> 3; i++) word |= (uint64_t)in[i] << (56 - 8 * i);
+  value = (uint32_t)((word << offset) >> (64 - bits));
+  d.bitPos += bits;
+  return true;
+}
+
+static uint32_t floatBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static void frameFloats(const RawSensorFrame &frame, uint32_t *out) {
+  for (int i = 0; i < 3; i++) out[i] = floatBits(frame.accel[i]);
+  for (int i = 0; i < 3; i++) out[3 + i] = floatBits(frame.gyro[i]);
+  out[6] = floatBits(frame.temperature);
+}
+
+static void setFrameFloats(RawSensorFrame &frame, const uint32_t *in) {
+  for (int i = 0; i < 3; i++) frame.accel[i] = bitsFloat(in[i]);
+  for (int i = 0; i < 3; i++) frame.gyro[i] = bitsFloat(in[3 + i]);
+  frame.temperature = bitsFloat(in[6]);
+}
+
+static void resetState(SeriesState &state) {
+  memset(&state, 0, sizeof(state));
+  memset(state.trailing, 0xFF, sizeof(state.trailing));
+}
+
+void seriesEncoderInit(SeriesEncoder &encoder, uint8_t *block, size_t capacity) {
+  encoder.block = block;
+  encoder.capacity = capacity;
+  encoder.bitPos = 0;
+  encoder.count = 0;
+  resetState(encoder.state);
+  memset(block, 0, capacity);
+}
+
+static bool writeTimestamp(SeriesEncoder &e, uint32_t timestampMs) {
+  int32_t delta = (int32_t)(timestampMs - e.state.previous.timestampMs);
+  int32_t dod = delta - e.state.previousDelta;
+  e.state.previousDelta = delta;
+  if (dod == 0) return writeBits(e, 0, 1);
+  if (dod >= -63 && dod <= 64) return writeBits(e, 0x2, 2) && writeBits(e, dod + 63, 7);
+  if (dod >= -255 && dod <= 256) return writeBits(e, 0x6, 3) && writeBits(e, dod + 255, 9);
+  if (dod >= -2047 && dod <= 2048) return writeBits(e, 0xE, 4) && writeBits(e, dod + 2047, 12);
+  return writeBits(e, 0xF, 4) && writeBits(e, (uint32_t)dod, 32);
+}
+
+static bool writeFloat(SeriesEncoder &e, int index, uint32_t value, uint32_t previous) {
+  uint32_t x = value ^ previous;
+  if (x == 0) return writeBits(e, 0, 1);
+  int leading = __builtin_clz(x);
+  int trailing = __builtin_ctz(x);
+  if (leading > 31) leading = 31;
+  uint8_t &prevLeading = e.state.leading[index];
+  uint8_t &prevTrailing = e.state.trailing[index];
+  if (prevTrailing != 0xFF && leading >= prevLeading && trailing >= prevTrailing) {
+    int length = 32 - prevLeading - prevTrailing;
+    return writeBits(e, 0x2, 2) && writeBits(e, x >> prevTrailing, length);
+  }
+  int length = 32 - leading - trailing;
+  prevLeading = leading;
+  prevTrailing = trailing;
+  return writeBits(e, 0x3, 2) && writeBits(e, leading, 5) && writeBits(e, length - 1, 5) &&
+         writeBits(e, x >> trailing, length);
+}
+
+static bool writeSmall(SeriesEncoder &e, uint32_t value, uint32_t previous, int bits) {
+  if (value == previous) return writeBits(e, 0, 1);
+  return writeBits(e, 1, 1) && writeBits(e, value, bits);
+}
+
+static bool encodeFrame(SeriesEncoder &e, const RawSensorFrame &frame) {
+  const RawSensorFrame &prev = e.state.previous;
+  uint32_t values[SERIES_FLOATS], previous[SERIES_FLOATS];
+  frameFloats(frame, values);
+  if (e.count == 0) {
+    // First frame of the block in full
+    if (!writeBits(e, frame.timestampMs, 32) || !writeBits(e, frame.sequence, 32)) return false;
+    for (int i = 0; i < SERIES_FLOATS; i++) {
+      if (!writeBits(e, values[i], 32)) return false;
+    }
+    return writeBits(e, frame.rainRaw, 16) && writeBits(e, frame.soilRaw, 16) && writeBits(e, frame.flags, 8);
+  }
+  if (!writeTimestamp(e, frame.timestampMs)) return false;
+  bool nextSequence = frame.sequence == prev.sequence + 1;
+  if (!(nextSequence ? writeBits(e, 0, 1) : writeBits(e, 1, 1) && writeBits(e, frame.sequence, 32))) return false;
+  frameFloats(prev, previous);
+  for (int i = 0; i < SERIES_FLOATS; i++) {
+    if (!writeFloat(e, i, values[i], previous[i])) return false;
+  }
+  return writeSmall(e, frame.rainRaw, prev.rainRaw, 16) && writeSmall(e, frame.soilRaw, prev.soilRaw, 16) &&
+         writeSmall(e, frame.flags, prev.flags, 8);
+}
+
+bool seriesAppend(SeriesEncoder &encoder, const RawSensorFrame &frame) {
+  if (encoder.count == UINT16_MAX) return false;
+  uint32_t startBit = encoder.bitPos;
+  SeriesState saved = encoder.state;
+  if (!encodeFrame(encoder, frame)) {
+    // Roll back, clearing the bits of the partial frame (writes only OR)
+    uint8_t *payload = encoder.block + SERIES_HEADER_BYTES;
+    uint32_t byte = startBit >> 3;
+    uint32_t end = (encoder.bitPos + 7) >> 3;
+    if (startBit & 7) payload[byte++] &= (uint8_t)(0xFF << (8 - (startBit & 7)));
+    if (end > byte) memset(payload + byte, 0, end - byte);
+    encoder.bitPos = startBit;
+    encoder.state = saved;
+    return false;
+  }
+  encoder.state.previous = frame;
+  if (encoder.count == 0) encoder.state.previousDelta = 0;
+  encoder.count++;
+  return true;
+}
+
+size_t seriesFinish(SeriesEncoder &encoder) {
+  uint8_t *h = encoder.block;
+  size_t payloadBytes = (encoder.bitPos + 7) / 8;
+  uint16_t crc = rawRecordCrc(h + SERIES_HEADER_BYTES, payloadBytes);
+  h[0] = SERIES_MAGIC0;
+  h[1] = SERIES_MAGIC1;
+  h[2] = SERIES_VERSION;
+  h[3] = 0;
+  h[4] = encoder.count & 0xFF;
+  h[5] = encoder.count >> 8;
+  h[6] = encoder.bitPos & 0xFF;
+  h[7] = (encoder.bitPos >> 8) & 0xFF;
+  h[8] = crc & 0xFF;
+  h[9] = crc >> 8;
+  h[10] = (encoder.bitPos >> 16) & 0xFF;
+  h[11] = 0;
+  return SERIES_HEADER_BYTES + payloadBytes;
+}
+
+bool seriesDecoderInit(SeriesDecoder &decoder, const uint8_t *block, size_t len) {
+  if (len < SERIES_HEADER_BYTES || block[0] != SERIES_MAGIC0 || block[1] != SERIES_MAGIC1 ||
+      block[2] != SERIES_VERSION) {
+    return false;
+  }
+  uint32_t bits = block[6] | (block[7] << 8) | ((uint32_t)block[10] << 16);
+  size_t payloadBytes = (bits + 7) / 8;
+  if (SERIES_HEADER_BYTES + payloadBytes > len) return false;
+  uint16_t crc = block[8] | (block[9] << 8);
+  if (rawRecordCrc(block + SERIES_HEADER_BYTES, payloadBytes) != crc) return false;
+  decoder.payload = block + SERIES_HEADER_BYTES;
+  decoder.bitLength = bits;
+  decoder.bitPos = 0;
+  decoder.count = block[4] | (block[5] << 8);
+  decoder.decoded = 0;
+  resetState(decoder.state);
+  return true;
+}
+
+static bool readTimestamp(SeriesDecoder &d, uint32_t &timestampMs) {
+  uint32_t bit, raw;
+  int32_t dod;
+  if (!readBits(d, 1, bit)) return false;
+  if (bit == 0) {
+    dod = 0;
+  } else {
+    int ones = 1;
+    while (ones < 4) {
+      if (!readBits(d, 1, bit)) return false;
+      if (bit == 0) break;
+      ones++;
+    }
+    static const int widths[] = { 0, 7, 9, 12, 32 };
+    static const int32_t bias[] = { 0, 63, 255, 2047, 0 };
+    if (!readBits(d, widths[ones], raw)) return false;
+    dod = (int32_t)raw - bias[ones];
+  }
+  int32_t delta = d.state.previousDelta + dod;
+  d.state.previousDelta = delta;
+  timestampMs = d.state.previous.timestampMs + delta;
+  return true;
+}
+
+static bool readFloat(SeriesDecoder &d, int index, uint32_t previous, uint32_t &value) {
+  uint32_t bit, x;
+  if (!readBits(d, 1, bit)) return false;
+  if (bit == 0) {
+    value = previous;
+    return true;
+  }
+  if (!readBits(d, 1, bit)) return false;
+  uint8_t &leading = d.state.leading[index];
+  uint8_t &trailing = d.state.trailing[index];
+  if (bit == 1) {
+    uint32_t l, length;
+    if (!readBits(d, 5, l) || !readBits(d, 5, length)) return false;
+    leading = l;
+    trailing = 32 - l - (length + 1);
+  } else if (trailing == 0xFF) {
+    return false;
+  }
+  if (!readBits(d, 32 - leading - trailing, x)) return false;
+  value = previous ^ (x << trailing);
+  return true;
+}
+
+static bool readSmall(SeriesDecoder &d, uint32_t previous, int bits, uint32_t &value) {
+  uint32_t bit;
+  if (!readBits(d, 1, bit)) return false;
+  if (bit == 0) {
+    value = previous;
+    return true;
+  }
+  return readBits(d, bits, value);
+}
+
+bool seriesNext(SeriesDecoder &decoder, RawSensorFrame &frame) {
+  if (decoder.decoded >= decoder.count) return false;
+  const RawSensorFrame &prev = decoder.state.previous;
+  uint32_t values[SERIES_FLOATS], previous[SERIES_FLOATS];
+  uint32_t v, rain, soil, flags;
+  if (decoder.decoded == 0) {
+    if (!readBits(decoder, 32, frame.timestampMs) || !readBits(decoder, 32, frame.sequence)) return false;
+    for (int i = 0; i < SERIES_FLOATS; i++) {
+      if (!readBits(decoder, 32, values[i])) return false;
+    }
+    if (!readBits(decoder, 16, rain) || !readBits(decoder, 16, soil) || !readBits(decoder, 8, flags)) return false;
+  } else {
+    if (!readTimestamp(decoder, frame.timestampMs) || !readBits(decoder, 1, v)) return false;
+    if (v == 0) frame.sequence = prev.sequence + 1;
+    else if (!readBits(decoder, 32, frame.sequence)) return false;
+    frameFloats(prev, previous);
+    for (int i = 0; i < SERIES_FLOATS; i++) {
+      if (!readFloat(decoder, i, previous[i], values[i])) return false;
+    }
+    if (!readSmall(decoder, prev.rainRaw, 16, rain) || !readSmall(decoder, prev.soilRaw, 16, soil) ||
+        !readSmall(decoder, prev.flags, 8, flags)) {
+      return false;
+    }
+  }
+  setFrameFloats(frame, values);
+  frame.rainRaw = rain;
+  frame.soilRaw = soil;
+  frame.flags = flags;
+  decoder.state.previous = frame;
+  decoder.decoded++;
+  return true;
+}
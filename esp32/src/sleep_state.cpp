@@ -0,0 +1,58 @@
+#include "sleep_state.h"
+#include <stddef.h>
+#include <string.h>
+#include "raw_record.h"
+#include "sensor_pipeline.h"
+
+// Inverse of rainFromRaw(): 4095 counts = dry, 0 = soaked
+static uint16_t rainRawForPercent(float percent) {
+  if (percent <= 0) return 4095;
+  if (percent >= 100) return 0;
+  return (uint16_t)(4095 - percent * 4095 / 100);
+}
+
+// Inverse of soilMoistureFromRaw()
+static uint16_t soilRawForPercent(float percent) {
+  if (percent <= 0) return DRY_SOIL_VALUE;
+  if (percent >= 100) return WET_SOIL_VALUE;
+  return (uint16_t)(DRY_SOIL_VALUE - percent * (DRY_SOIL_VALUE - WET_SOIL_VALUE) / 100);
+}
+
+UlpWakeLevels ulpWakeLevels(const RiskThresholds &thresholds) {
+  UlpWakeLevels levels;
+  levels.rainBelow = rainRawForPercent(thresholds.rainWarning * RATE_WATCH_FRACTION);
+  levels.soilBelow = soilRawForPercent(thresholds.moistureWarning * RATE_WATCH_FRACTION);
+  return levels;
+}
+
+bool sleepAllowed(const RiskStatus &risk, uint32_t awakeMs, uint32_t uploadsSinceWake) {
+  return risk.rateProfile == RATE_SAFE && risk.level == RISK_SAFE && !risk.alertTrigger &&
+         awakeMs >= DEEP_SLEEP_MIN_AWAKE_MS && uploadsSinceWake > 0;
+}
+
+static uint16_t stateCrc(const SleepState &state) {
+  return rawRecordCrc((const uint8_t *)&state, offsetof(SleepState, crc));
+}
+
+void sleepStateSeal(SleepState &state) {
+  state.magic = SLEEP_STATE_MAGIC;
+  state.crc = stateCrc(state);
+}
+
+bool sleepStateValid(const SleepState &state) {
+  return state.magic == SLEEP_STATE_MAGIC && state.crc == stateCrc(state);
+}
+
+void sleepStateRestore(const SleepState &state, uint32_t elapsedMs, uint32_t nowMs,
+                       AdaptiveRate &rate, AnomalyDetector &anomaly) {
+  rate = state.rate;
+  anomaly = state.anomaly;
+  anomaly.stepStartMs = nowMs;
+  anomaly.stepSamples = 0;
+  memset(anomaly.stepSums, 0, sizeof(anomaly.stepSums));
+  // Where the save happened on the new timeline; wraps like millis() does
+  uint32_t shift = nowMs - elapsedMs - state.savedAtMs;
+  rate.profileSinceMs += shift;
+  rate.holdUntilMs += shift;
+  rate.trendStartMs += shift;
+}
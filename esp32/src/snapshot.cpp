@@ -0,0 +1,37 @@
+#include "snapshot.h"
+#include "seqlock.h"
+
+static Seqlock<SensorSample> latestSample;
+static Seqlock<RiskStatus> latestRisk;
+
+void publishSensorSample(const SensorSample &sample) {
+  latestSample.write(sample);
+}
+
+void publishRiskStatus(const RiskStatus &status) {
+  latestRisk.write(status);
+}
+
+SensorSample readLatestSample() {
+  return latestSample.read();
+}
+
+RiskStatus readLatestRiskStatus() {
+  return latestRisk.read();
+}
+
+LatestSnapshot readLatestSnapshot() {
+  LatestSnapshot snapshot;
+  snapshot.sample = latestSample.read();
+  snapshot.risk = latestRisk.read();
+  return snapshot;
+}
+
+const char* riskLevelName(RiskLevel level) {
+  switch (level) {
+    case RISK_SAFE: return "safe";
+    case RISK_WARNING: return "warning";
+    case RISK_DANGER: return "danger";
+    default: return "unknown";
+  }
+}
@@ -1,120 +1,299 @@
 #include "telegram_module.h"
 #include <Arduino.h>
+#include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <UniversalTelegramBot.h>
 #include "sensors.h"
+#include "notify_scheduler.h"
+#include "secure_transport.h"
+#include "runtime_config.h"
+#include "heap_monitor.h"
+#include "health_monitor.h"
 #include "config.h"
 
+#ifndef TELEGRAM_ON_DEVICE
+#define TELEGRAM_ON_DEVICE 0 // backend/telegram_bot.py answers the bot by default
+#endif
+
+// Worker task: runs on the WiFi core below the sensor task so a slow TLS
+// exchange can only delay other Telegram traffic, never acquisition or alarms
+#define TELEGRAM_TASK_STACK 8192
+#define TELEGRAM_TASK_PRIORITY 1
+#define TELEGRAM_TASK_CORE 0
+#define TELEGRAM_QUEUE_LENGTH 6
+#define TELEGRAM_LONG_POLL_S 2          // getUpdates holds the request open this long
+#define TELEGRAM_RESPONSE_TIMEOUT_MS 8000
+#define TELEGRAM_HANDSHAKE_TIMEOUT_S 10
+#define TELEGRAM_THROTTLE_WAIT_MS 50
+#define SUBSCRIPTION_DEFAULT_INTERVAL_S 5
+#define SUBSCRIPTION_MIN_INTERVAL_S 1
+
 const char* botToken = TELEGRAM_BOT_TOKEN;
 const char* chatId = TELEGRAM_CHAT_ID;
 
-WiFiClientSecure secured_client;
+// One client for the lifetime of the task; UniversalTelegramBot only
+// reconnects when the server has closed it, so the TLS session is reused
+SecureTransportClient secured_client(TRANSPORT_TELEGRAM);
 UniversalTelegramBot bot(botToken, secured_client);
 
-// Timer untuk polling
-unsigned long lastTimeBotRan;
-const unsigned long botInterval = 2000; // 2 detik
+struct TelegramOutbound {
+  char chatId[TELEGRAM_CHAT_ID_MAX];
+  char text[TELEGRAM_MESSAGE_MAX];
+};
 
-bool isSubscribed = false;
-unsigned long lastSubscriptionSent = 0;
-const unsigned long subscriptionInterval = 5000; // 5 seconds
-String subscribedChatId = "";
+static QueueHandle_t outboundQueue = NULL;
+static TaskHandle_t telegramTaskHandle = NULL;
+static unsigned long droppedMessages = 0;
 
-String* riskLevel = nullptr;
-bool alertTrigger = false;
+// Only touched from the Telegram task
+static NotificationScheduler scheduler;
 
 void setupTelegram() {
   Serial.println("Initializing Telegram Bot...");
-  // secured_client.setCACert(TELEGRAM_CERTIFICATE_ROOT);
-  secured_client.setInsecure(); // Use this for testing, not recommended for production
-  lastTimeBotRan = millis();
+  secured_client.begin();
+  secured_client.setHandshakeTimeout(TELEGRAM_HANDSHAKE_TIMEOUT_S);
+  bot.longPoll = TELEGRAM_LONG_POLL_S;
+  bot.waitForResponse = TELEGRAM_LONG_POLL_S * 1000 + TELEGRAM_RESPONSE_TIMEOUT_MS;
+  outboundQueue = xQueueCreate(TELEGRAM_QUEUE_LENGTH, sizeof(TelegramOutbound));
+  notifyInit(scheduler, millis());
   Serial.println("Telegram Bot initialized.");
 }
 
-void checkNewMessages(
-  String *riskLevelz, 
-  const bool alertTriggerz
-) {
-  if (riskLevelz == nullptr) {
-    Serial.println("Risk level pointer is null.");
-    return;
+bool queueTelegramMessage(const char *chat_id, const char *text) {
+  if (outboundQueue == NULL) return false;
+  TelegramOutbound msg;
+  strncpy(msg.chatId, chat_id, sizeof(msg.chatId) - 1);
+  msg.chatId[sizeof(msg.chatId) - 1] = '\0';
+  strncpy(msg.text, text, sizeof(msg.text) - 1);
+  msg.text[sizeof(msg.text) - 1] = '\0';
+  if (xQueueSend(outboundQueue, &msg, 0) != pdTRUE) {
+    droppedMessages++;
+    return false;
   }
+  return true;
+}
 
-  if (millis() - lastTimeBotRan > botInterval) {
-    Serial.println("Checking for new Telegram messages...");
-    riskLevel = riskLevelz;
-    alertTrigger = alertTriggerz;
+unsigned long getTelegramDroppedMessages() {
+  return droppedMessages;
+}
 
-    int numNewMessages = bot.getUpdates(bot.last_message_received + 1);
-    while (numNewMessages) {
-      Serial.println("New message received.");
-      replyNewMessages(numNewMessages);
-      numNewMessages = bot.getUpdates(bot.last_message_received + 1);
+static void flushOutboundQueue() {
+  TelegramOutbound msg;
+  while (xQueueReceive(outboundQueue, &msg, 0) == pdTRUE) {
+    // Wait out the Bot API rate limits here, in the Telegram task only. A
+    // full queue can take longer than the watchdog timeout to drain, so the
+    // waits count as idle and every send is a cycle of its own.
+    healthTaskIdle(HEALTH_TASK_TELEGRAM);
+    while (!notifyTryAcquire(scheduler, msg.chatId, millis())) {
+      vTaskDelay(pdMS_TO_TICKS(TELEGRAM_THROTTLE_WAIT_MS));
+      healthTaskIdle(HEALTH_TASK_TELEGRAM);
+    }
+    healthTaskBusy(HEALTH_TASK_TELEGRAM);
+    bool reused = secured_client.connected();
+    unsigned long start = millis();
+    bool sent = bot.sendMessage(msg.chatId, msg.text, "");
+    recordTransportRequest(TRANSPORT_TELEGRAM, reused, millis() - start);
+    if (!sent) {
+      Serial.println("Telegram send failed, message dropped.");
+      droppedMessages++;
     }
-    lastTimeBotRan = millis();
   }
 }
 
-String getFormattedSensorData() {
-    float rainValue, soilMoistureValue;
-    sensors_event_t a, g, temp;
+static void telegramTask(void *param) {
+  heapTagTask(HEAP_TELEGRAM);
+  healthTaskStart(HEALTH_TASK_TELEGRAM);
+  for (;;) {
+    // One cycle per kick from the Telegram stage in loop(); the timeout
+    // only checks in with the watchdog
+    healthTaskIdle(HEALTH_TASK_TELEGRAM);
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WATCHDOG_IDLE_WAKE_MS)) == 0) continue;
+    healthTaskBusy(HEALTH_TASK_TELEGRAM);
+    if (WiFi.status() != WL_CONNECTED) continue;
 
-    readAllSensorsData(rainValue, soilMoistureValue, a, g, temp);
-    
-    String header = "";
-
-    if (*riskLevel == "safe") {
-      header = "✅ Tanah Aman";
-    } else if (*riskLevel == "warning") {
-      header = "⚠ Peringatan: Tanah Berpotensi Longsor (Tanah Waspada)";
-    } else if (*riskLevel == "danger") {
-      header = "⛔ BAHAYA: Tanah Longsor Terjadi (TANAH AWAS)";
+    flushOutboundQueue();
+    checkNewMessages();
+    sendSubscriptionStatusIfNeeded();
+    flushOutboundQueue();
+    // Replies were copied into the outbound queue; drop their text
+    arenaReset(telegramArena);
+  }
+}
+
+void startTelegramTask() {
+  if (!TELEGRAM_ON_DEVICE || outboundQueue == NULL || telegramTaskHandle != NULL) return;
+  xTaskCreatePinnedToCore(telegramTask, "telegram", TELEGRAM_TASK_STACK, NULL,
+                          TELEGRAM_TASK_PRIORITY, &telegramTaskHandle, TELEGRAM_TASK_CORE);
+}
+
+void kickTelegramTask() {
+  if (telegramTaskHandle != NULL) xTaskNotifyGive(telegramTaskHandle);
+}
+
+// Long-polls getUpdates once; blocks the Telegram task for at most
+// TELEGRAM_LONG_POLL_S plus the response timeout
+void checkNewMessages() {
+  bool reused = secured_client.connected();
+  unsigned long start = millis();
+  int numNewMessages = bot.getUpdates(bot.last_message_received + 1);
+  recordTransportRequest(TRANSPORT_TELEGRAM, reused, millis() - start);
+  if (numNewMessages > 0) {
+    Serial.println("New message received.");
+    replyNewMessages(numNewMessages);
+  }
+}
+
+// Built from the shared snapshot only; never reads the sensors itself
+void appendSensorData(ArenaString &out) {
+    LatestSnapshot snapshot = readLatestSnapshot();
+    const SensorSample &sample = snapshot.sample;
+
+    if (snapshot.risk.level == RISK_SAFE) {
+      out += "✅ Tanah Aman";
+    } else if (snapshot.risk.level == RISK_WARNING) {
+      out += "⚠ Peringatan: Tanah Berpotensi Longsor (Tanah Waspada)";
+    } else if (snapshot.risk.level == RISK_DANGER) {
+      out += "⛔ BAHAYA: Tanah Longsor Terjadi (TANAH AWAS)";
     } else {
-      header = "Status Tidak Dikenal";
+      out += "Status Tidak Dikenal";
     }
 
-    String data = header + "\n";
-    data += "Peringatan: " + String(alertTrigger ? "Aktif" : "Tidak Aktif") + "\n";
-    data += "________________\n";
-    data +="Rain: " + String(rainValue, 2) + "%\n";
-    data += "Soil Moisture: " + String(soilMoistureValue, 2) + "%\n";
-    data += "Accel X: " + String(a.acceleration.x, 2) + " m/s^2\n";
-    data += "Accel Y: " + String(a.acceleration.y, 2) + " m/s^2\n";
-    data += "Accel Z: " + String(a.acceleration.z, 2) + " m/s^2\n";
-    data += "Gyro X: " + String(g.gyro.x, 2) + " rad/s\n";
-    data += "Gyro Y: " + String(g.gyro.y, 2) + " rad/s\n";
-    data += "Gyro Z: " + String(g.gyro.z, 2) + " rad/s\n";
-    data += "Temperature: " + String(temp.temperature, 2) + " C\n";
-    data += "________________\n";
-    data += "Silahkan cek dashboard lengkap di https://landslide-early-warning-system.vercel.app/ 👈";
-    return data;
-}
-
-void handleSubscriptionCommands(const String& chat_id, const String& text) {
-    if (text == "/subscribe") {
-        isSubscribed = true;
-        subscribedChatId = chat_id;
-        bot.sendMessage(chat_id, "Berhasil berlangganan status sensor setiap 5 detik.", "");
-    } else if (text == "/unsubscribe") {
-        isSubscribed = false;
-        subscribedChatId = "";
-        bot.sendMessage(chat_id, "Berhenti berlangganan status sensor.", "");
+    out.appendf("\nPeringatan: %s\n", snapshot.risk.alertTrigger ? "Aktif" : "Tidak Aktif");
+    out += "________________\n";
+    out.appendf("Rain: %.2f%%\n", sample.rain);
+    out.appendf("Soil Moisture: %.2f%%\n", sample.soilMoisture);
+    out.appendf("Accel X: %.2f m/s^2\n", sample.accelX);
+    out.appendf("Accel Y: %.2f m/s^2\n", sample.accelY);
+    out.appendf("Accel Z: %.2f m/s^2\n", sample.accelZ);
+    out.appendf("Gyro X: %.2f rad/s\n", sample.gyroX);
+    out.appendf("Gyro Y: %.2f rad/s\n", sample.gyroY);
+    out.appendf("Gyro Z: %.2f rad/s\n", sample.gyroZ);
+    out.appendf("Temperature: %.2f C\n", sample.temperature);
+    out.appendf("Sampel: %.1f s sejak boot\n", sample.timestampMs / 1000.0f);
+    out += "________________\n";
+    out += "Silahkan cek dashboard lengkap di https://landslide-early-warning-system.vercel.app/ 👈";
+}
+
+static bool parseRiskLevel(const char *name, RiskLevel &level) {
+    if (strcmp(name, "safe") == 0) level = RISK_SAFE;
+    else if (strcmp(name, "warning") == 0) level = RISK_WARNING;
+    else if (strcmp(name, "danger") == 0) level = RISK_DANGER;
+    else return false;
+    return true;
+}
+
+// Matches "/command", "/command args" and, in group chats, "/command@bot"
+// addressed to this bot. Returns the arguments (possibly "") or NULL.
+static const char* matchCommand(const char *text, const char *command) {
+    size_t length = strlen(command);
+    if (strncmp(text, command, length) != 0) return NULL;
+    const char *rest = text + length;
+    if (*rest == '@') {
+        // Learn our own username once; until then no addressed command matches
+        if (bot.userName.length() == 0) bot.getMe();
+        size_t nameLength = bot.userName.length();
+        if (nameLength == 0 || strncasecmp(rest + 1, bot.userName.c_str(), nameLength) != 0) return NULL;
+        rest += 1 + nameLength;
     }
+    return *rest == '\0' || *rest == ' ' ? rest : NULL;
 }
 
+static bool isSubscriptionCommand(const char *text) {
+    return matchCommand(text, "/subscribe") != NULL || matchCommand(text, "/unsubscribe") != NULL;
+}
+
+// /subscribe [interval_s] [safe|warning|danger], /unsubscribe
+void handleSubscriptionCommands(const char *chat_id, const char *text) {
+    const char *args;
+    if ((args = matchCommand(text, "/subscribe")) != NULL) {
+        unsigned long intervalS = SUBSCRIPTION_DEFAULT_INTERVAL_S;
+        RiskLevel minLevel = RISK_SAFE;
+        char first[16] = "";
+        char second[16] = "";
+        sscanf(args, "%15s %15s", first, second);
+        if (first[0] != '\0') {
+            if (atol(first) > 0) {
+                intervalS = max((long)SUBSCRIPTION_MIN_INTERVAL_S, atol(first));
+            } else {
+                strcpy(second, first);
+            }
+            if (second[0] != '\0' && !parseRiskLevel(second, minLevel)) {
+                queueTelegramMessage(chat_id, "Format: /subscribe [detik] [safe|warning|danger]");
+                return;
+            }
+        }
+
+        if (notifySubscribe(scheduler, chat_id, intervalS * 1000, minLevel, millis()) < 0) {
+            queueTelegramMessage(chat_id, "Daftar langganan penuh, coba lagi nanti.");
+            return;
+        }
+        ArenaString reply(telegramArena);
+        reply.appendf("Berhasil berlangganan status sensor setiap %lu detik (level minimal: %s).",
+                      intervalS, riskLevelName(minLevel));
+        queueTelegramMessage(chat_id, reply.c_str());
+    } else if (matchCommand(text, "/unsubscribe") != NULL) {
+        notifyUnsubscribe(scheduler, chat_id);
+        queueTelegramMessage(chat_id, "Berhenti berlangganan status sensor.");
+    }
+}
+
+// Pushes at most one up-to-date status per due subscriber
 void sendSubscriptionStatusIfNeeded() {
-    if (isSubscribed && (millis() - lastSubscriptionSent > subscriptionInterval)) {
-        String data = getFormattedSensorData();
-        bot.sendMessage(subscribedChatId, "[Langganan] Status sensor:\n" + data, "");
-        lastSubscriptionSent = millis();
+    RiskLevel level = readLatestRiskStatus().level;
+    int slot;
+    while ((slot = notifyNextDue(scheduler, level, millis())) >= 0) {
+        const char *target = scheduler.subscribers[slot].chatId;
+        size_t mark = arenaMark(telegramArena);
+        ArenaString message(telegramArena, TELEGRAM_MESSAGE_MAX);
+        message += "[Langganan] Status sensor:\n";
+        appendSensorData(message);
+        bool queued = queueTelegramMessage(target, message.c_str());
+        arenaRelease(telegramArena, mark);
+        if (!queued) break;
+        notifyMarkSent(scheduler, slot, level, millis());
+        flushOutboundQueue();
+    }
+}
+
+void appendThresholds(ArenaString &out) {
+    RuntimeConfig config = getRuntimeConfig();
+    const RiskThresholds &t = config.thresholds;
+    out.appendf("Ambang batas bahaya saat ini (v%lu, mode %s):\n", (unsigned long)config.version, deviceModeName(config.mode));
+    out.appendf("Kemiringan: aman <= %.1f, waspada > %.1f, awas > %.1f deg\n", t.tiltSafeMax, t.tiltWarningMin, t.tiltDanger);
+    out.appendf("Kelembapan: waspada >= %.0f%%, awas >= %.0f%%\n", t.moistureWarning, t.moistureDanger);
+    out.appendf("Hujan: waspada >= %.0f%%, awas >= %.0f%%\n", t.rainWarning, t.rainDanger);
+    out.appendf("Getaran: waspada >= %.2f, awas >= %.2f m/s^2\n", t.vibrationWarning, t.vibrationDanger);
+    out.appendf("Laju rayapan: waspada >= %.2f, awas >= %.2f deg/jam", t.creepWarning, t.creepDanger);
+}
+
+void appendSubscriptionStats(ArenaString &out) {
+    const NotifyStats &stats = scheduler.stats;
+    out.appendf("Pelanggan: %d\n", notifySubscriberCount(scheduler));
+    out.appendf("Terkirim: %lu\n", (unsigned long)stats.sent);
+    out.appendf("Digabung: %lu\n", (unsigned long)stats.coalesced);
+    out.appendf("Terlambat: %lu\n", (unsigned long)stats.delayed);
+    out.appendf("Dibatasi: %lu\n", (unsigned long)stats.throttled);
+    out.appendf("Dibuang: %lu\n", droppedMessages);
+    out.appendf("Delay maks: %lu ms\n", (unsigned long)stats.maxDelayMs);
+    out.appendf("Delay rata-rata: %lu ms", (unsigned long)(stats.sent ? stats.totalDelayMs / stats.sent : 0));
+
+    static const char *const tlsNames[TRANSPORT_COUNT] = { "Firebase", "Telegram", "MQTT" };
+    for (int i = 0; i < TRANSPORT_COUNT; i++) {
+        TransportStats tls = getTransportStats((TransportId)i);
+        if (i == TRANSPORT_MQTT && tls.handshakes == 0) continue;
+        out.appendf("\nTLS %s: ", tlsNames[i]);
+        out.appendf("%lu req, %lu reuse, %lu handshake, ~%lu ms",
+                    (unsigned long)tls.requests, (unsigned long)tls.reusedRequests,
+                    (unsigned long)tls.handshakes, (unsigned long)estimateHandshakeMs(tls));
     }
 }
 
 void replyNewMessages(int numNewMessages) {
   for (int i = 0; i < numNewMessages; i++) {
-    String chat_id = bot.messages[i].chat_id;
-    String text = bot.messages[i].text;
-    String from_name = bot.messages[i].from_name;
+    // The bot owns these; read them in place instead of copying
+    const String &chat_id = bot.messages[i].chat_id;
+    const String &text = bot.messages[i].text;
+    const String &from_name = bot.messages[i].from_name;
 
     Serial.print("Message from: ");
     Serial.print(from_name);
@@ -123,38 +302,46 @@ void replyNewMessages(int numNewMessages) {
     Serial.print("): ");
     Serial.println(text);
 
+    size_t mark = arenaMark(telegramArena);
+    ArenaString reply(telegramArena);
     if (text == "/start") {
-      String welcome = "Halo " + from_name + ",\n";
-      welcome += "Selamat datang di Bot Sistem Peringatan Dini Longsor\n";
-      welcome += "/help: melihat perintah yang tersedia";
-      bot.sendMessage(chat_id, welcome, "");
+      reply.appendf("Halo %s,\n", from_name.c_str());
+      reply += "Selamat datang di Bot Sistem Peringatan Dini Longsor\n";
+      reply += "/help: melihat perintah yang tersedia";
+      queueTelegramMessage(chat_id.c_str(), reply.c_str());
     }
     else if (text == "/help") {
-      String helpMsg = "";
-      helpMsg += "/start - Memulai Bot\n";
-      helpMsg += "/status - Menampilkan status terkini dari semua sensor\n";
-      helpMsg += "/alert - Menampilkan log peringatan terakhir\n";
-      helpMsg += "/subscribe /unsubscribe - Terima notifikasi setiap 5 detik\n";
-      helpMsg += "/thresholds - Menampilkan ambang batas bahaya saat ini";
-      bot.sendMessage(chat_id, helpMsg, "");
+      queueTelegramMessage(chat_id.c_str(),
+        "/start - Memulai Bot\n"
+        "/status - Menampilkan status terkini dari semua sensor\n"
+        "/alert - Menampilkan log peringatan terakhir\n"
+        "/subscribe [detik] [safe|warning|danger] - Terima notifikasi berkala\n"
+        "/unsubscribe - Berhenti berlangganan\n"
+        "/stats - Statistik pengiriman notifikasi\n"
+        "/thresholds - Menampilkan ambang batas bahaya saat ini");
     }
     
     else if (text == "/status") {
-      bot.sendMessage(chat_id, getFormattedSensorData(), "");
+      appendSensorData(reply);
+      queueTelegramMessage(chat_id.c_str(), reply.c_str());
     }
-    else if (text == "/subscribe") {
-      bot.sendMessage(chat_id, "Berlangganan status sensor setiap 5 detik. /unsubscribe untuk berhenti.", "");
-      handleSubscriptionCommands(chat_id, text);
+    else if (isSubscriptionCommand(text.c_str())) {
+      handleSubscriptionCommands(chat_id.c_str(), text.c_str());
     }
-    else if (text == "/unsubscribe") {
-      bot.sendMessage(chat_id, "Berhenti berlangganan status sensor.", "");
-      handleSubscriptionCommands(chat_id, text);
+    else if (text == "/stats") {
+      appendSubscriptionStats(reply);
+      queueTelegramMessage(chat_id.c_str(), reply.c_str());
     }
     else if (text == "/thresholds") {
-      bot.sendMessage(chat_id, "Ambang batas bahaya saat ini: [data thresholds]", "");
+      appendThresholds(reply);
+      queueTelegramMessage(chat_id.c_str(), reply.c_str());
     }
     else {
-      bot.sendMessage(chat_id, "Tidak dapat menemukan perintah. Ketik /help untuk bantuan.", "");
+      queueTelegramMessage(chat_id.c_str(), "Tidak dapat menemukan perintah. Ketik /help untuk bantuan.");
     }
+    arenaRelease(telegramArena, mark);
+
+    // Replies go out between messages so a burst cannot overflow the queue
+    flushOutboundQueue();
   }
 }
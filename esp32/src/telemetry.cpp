@@ -0,0 +1,117 @@
+#include "telemetry.h"
+#include <stdio.h>
+#include <math.h>
+#include "fastmath.h"
+#include "adaptive_rate.h"
+#include "anomaly.h"
+
+// JSON has no NaN/Inf; a failed reading is sent as 0 rather than breaking the document
+static double num(float value) {
+  return isfinite(value) ? value : 0.0;
+}
+
+int formatTelemetryJson(char *out, size_t size, const LatestSnapshot &snapshot,
+                        const char *deviceId, uint32_t epoch) {
+  const SensorSample &s = snapshot.sample;
+  const RiskStatus &r = snapshot.risk;
+  RateProfile profile = (RateProfile)snapshot.risk.rateProfile;
+  const RatePolicy &policy = ratePolicy(profile);
+  int n = snprintf(out, size,
+    "{\"sensors\":{"
+      "\"accelerometer\":{\"x\":%.2f,\"y\":%.2f,\"z\":%.2f},"
+      "\"gyro\":{\"x\":%.2f,\"y\":%.2f,\"z\":%.2f},"
+      "\"vibrationRMS\":%.2f,\"soilMoisture\":%.2f,\"rainfall\":%.2f,"
+      "\"temperature\":%.2f,\"sampleTime\":%lu,"
+      "\"tilt\":{\"angleX\":%.1f,\"angleY\":%.1f,\"maxTilt\":%.1f}},"
+    "\"status\":{\"landslideRisk\":\"%s\",\"alertTriggered\":%s,"
+      "\"rateProfile\":\"%s\",\"sampleHz\":%u,\"uploadMs\":%lu,"
+      "\"anomaly\":{\"tilt\":%.2f,\"moisture\":%.2f,\"rain\":%.2f,\"vibration\":%.2f},"
+      "\"trend\":{\"tiltVelocity\":%.2f,\"moistureRate\":%.2f,\"rainEventHours\":%.2f,\"rain24hHours\":%.2f}},"
+    "\"deviceId\":\"%s\"",
+    num(s.accelX), num(s.accelY), num(s.accelZ), num(s.gyroX), num(s.gyroY), num(s.gyroZ),
+    num(s.vibrationRMS), num(s.soilMoisture), num(s.rain), num(s.temperature), (unsigned long)s.timestampMs,
+    num(s.angleX), num(s.angleY), num(fastMaxAbs(s.angleX, s.angleY)),
+    riskLevelName(snapshot.risk.level), snapshot.risk.alertTrigger ? "true" : "false",
+    rateProfileName(profile), policy.sampleRateHz, (unsigned long)policy.uploadIntervalMs,
+    num(r.anomalyScore[ANOMALY_TILT]), num(r.anomalyScore[ANOMALY_MOISTURE]),
+    num(r.anomalyScore[ANOMALY_RAIN]), num(r.anomalyScore[ANOMALY_VIBRATION]),
+    num(r.trend.tiltVelocity), num(r.trend.moistureRate), num(r.trend.rainEventHours), num(r.trend.rain24hHours),
+    deviceId);
+  if (n < 0 || (size_t)n >= size) return -1;
+
+  int m = epoch ? snprintf(out + n, size - n, ",\"ts\":%lu}", (unsigned long)epoch)
+                : snprintf(out + n, size - n, "}");
+  if (m < 0 || (size_t)(n + m) >= size) return -1;
+  return n + m;
+}
+
+// Names of items that are not there (no miss yet, reset cause unknown) are null
+static const char* deadlineItemName(const DeadlineMonitor &deadlines, int item) {
+  return item >= 0 && item < deadlines.count ? deadlines.items[item].name : NULL;
+}
+
+static int formatDeadlinesJson(char *out, size_t size, const DeadlineMonitor &deadlines) {
+  const char *lastMiss = deadlineItemName(deadlines, deadlines.lastMiss);
+  const char *resetIn = deadlineItemName(deadlines, deadlines.resetItem);
+  int n = snprintf(out, size, ",\"deadlines\":{\"misses\":%lu,\"lastMiss\":%s%s%s,\"reset\":\"%s\",\"resetIn\":%s%s%s,\"items\":{",
+    (unsigned long)deadlines.misses, lastMiss ? "\"" : "", lastMiss ? lastMiss : "null", lastMiss ? "\"" : "",
+    deadlines.resetReason, resetIn ? "\"" : "", resetIn ? resetIn : "null", resetIn ? "\"" : "");
+  if (n < 0 || (size_t)n >= size) return -1;
+  for (int i = 0; i < deadlines.count; i++) {
+    const DeadlineItem &item = deadlines.items[i];
+    int m = snprintf(out + n, size - n,
+      "%s\"%s\":{\"budget\":%lu,\"misses\":%lu,\"worst\":%lu,\"escalations\":%lu,\"action\":\"%s\",\"degraded\":%s}",
+      i ? "," : "", item.name, (unsigned long)item.budgetUs, (unsigned long)item.misses,
+      (unsigned long)item.worstUs, (unsigned long)item.escalations,
+      deadlineActionName((DeadlineAction)item.worstAction), item.degraded ? "true" : "false");
+    if (m < 0 || (size_t)(n + m) >= size) return -1;
+    n += m;
+  }
+  int m = snprintf(out + n, size - n, "}}");
+  if (m < 0 || (size_t)(n + m) >= size) return -1;
+  return n + m;
+}
+
+int formatDiagnosticsJson(char *out, size_t size, const HeapReport &report,
+                          const DeadlineMonitor &deadlines, uint32_t epoch) {
+  int n = snprintf(out, size,
+    "{\"uptime\":%lu,\"heap\":{\"free\":%lu,\"minFree\":%lu,\"largestBlock\":%lu,"
+    "\"fragmentation\":%u,\"allocTracking\":%s},\"subsystems\":{",
+    (unsigned long)report.uptimeS, (unsigned long)report.freeBytes, (unsigned long)report.minFreeBytes,
+    (unsigned long)report.largestFreeBlock, heapFragmentationPct(report.freeBytes, report.largestFreeBlock),
+    report.allocTracking ? "true" : "false");
+  if (n < 0 || (size_t)n >= size) return -1;
+
+  for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; i++) {
+    const HeapSubsystemStats &s = report.subsystems[i];
+    int m = snprintf(out + n, size - n,
+      "%s\"%s\":{\"allocs\":%lu,\"allocBytes\":%lu,\"frees\":%lu,\"freeBytes\":%lu,"
+      "\"scopes\":%lu,\"scopeDelta\":%ld}",
+      i ? "," : "", heapSubsystemName((HeapSubsystem)i), (unsigned long)s.allocs,
+      (unsigned long)s.allocBytes, (unsigned long)s.frees, (unsigned long)s.freeBytes,
+      (unsigned long)s.scopes, (long)s.scopeDelta);
+    if (m < 0 || (size_t)(n + m) >= size) return -1;
+    n += m;
+  }
+
+  for (int i = 0; i < HEAP_ARENA_COUNT; i++) {
+    const HeapArenaStats &a = report.arenas[i];
+    int m = snprintf(out + n, size - n, "%s\"%s\":{\"capacity\":%lu,\"peak\":%lu,\"overflows\":%lu}",
+      i ? "," : "},\"arenas\":{", heapArenaName((HeapArena)i), (unsigned long)a.capacity,
+      (unsigned long)a.peak, (unsigned long)a.overflows);
+    if (m < 0 || (size_t)(n + m) >= size) return -1;
+    n += m;
+  }
+
+  int m = snprintf(out + n, size - n, "}");
+  if (m < 0 || (size_t)(n + m) >= size) return -1;
+  n += m;
+  m = formatDeadlinesJson(out + n, size - n, deadlines);
+  if (m < 0) return -1;
+  n += m;
+
+  m = epoch ? snprintf(out + n, size - n, ",\"ts\":%lu}", (unsigned long)epoch)
+            : snprintf(out + n, size - n, "}");
+  if (m < 0 || (size_t)(n + m) >= size) return -1;
+  return n + m;
+}
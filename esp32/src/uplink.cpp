@@ -0,0 +1,92 @@
+#include "uplink.h"
+#include <Arduino.h>
+#include "firebase_module.h"
+#include "mqtt_module.h"
+#include "config.h"
+
+#ifndef UPLINK_TRANSPORT
+#define UPLINK_TRANSPORT UPLINK_FIREBASE
+#endif
+#ifndef UPLINK_BENCH_MESSAGES
+#define UPLINK_BENCH_MESSAGES 0
+#endif
+
+#if UPLINK_TRANSPORT == UPLINK_MQTT
+static const UplinkTransport transport = {
+  "mqtt", setupMqtt, sendDataToMqtt, sendMeshBatchToMqtt, sendDiagnosticsToMqtt, pollMqtt
+};
+#else
+static const UplinkTransport transport = {
+  "firebase", setupFirebase, sendDataToFirebase, sendMeshBatchToFirebase, sendDiagnosticsToFirebase, NULL
+};
+#endif
+
+static UplinkStats stats;
+
+void setupUplink() {
+  transport.setup();
+  runUplinkBenchmark(UPLINK_BENCH_MESSAGES);
+}
+
+const char* uplinkName() {
+  return transport.name;
+}
+
+bool uplinkSendSample(const LatestSnapshot &snapshot) {
+  uint32_t start = millis();
+  int bytes = transport.sendSample(snapshot);
+  uint32_t elapsed = millis() - start;
+  stats.samples++;
+  stats.totalSendMs += elapsed;
+  if (elapsed > stats.maxSendMs) stats.maxSendMs = elapsed;
+  if (bytes < 0) {
+    stats.failures++;
+    return false;
+  }
+  stats.payloadBytes += bytes;
+  return true;
+}
+
+void uplinkSendMeshBatch(const MeshUpload *uploads, int count) {
+  transport.sendMeshBatch(uploads, count);
+}
+
+void uplinkSendDiagnostics(const HeapReport &report, const DeadlineMonitor &deadlines) {
+  transport.sendDiagnostics(report, deadlines);
+}
+
+bool uplinkNeedsPoll() {
+  return transport.poll != NULL;
+}
+
+void uplinkPoll() {
+  if (transport.poll) transport.poll();
+}
+
+void runUplinkBenchmark(uint32_t messages) {
+  if (messages == 0) return;
+  UplinkStats before = stats;
+  stats.maxSendMs = 0;
+  LatestSnapshot snapshot = readLatestSnapshot();
+  uint32_t start = millis();
+  for (uint32_t i = 0; i < messages; i++) {
+    snapshot.sample.sequence++;
+    uplinkSendSample(snapshot);
+    uplinkPoll();
+  }
+  uint32_t elapsed = millis() - start;
+  if (elapsed == 0) elapsed = 1;
+  uint32_t failed = stats.failures - before.failures;
+  uint32_t bytes = stats.payloadBytes - before.payloadBytes;
+  Serial.printf("Uplink bench (%s): %u messages in %u ms, %u failed; %.1f msg/s, %.0f payload B/s, max %u ms\n",
+                transport.name, messages, elapsed, failed, (messages - failed) * 1000.0f / elapsed,
+                bytes * 1000.0f / elapsed, stats.maxSendMs);
+  if (before.maxSendMs > stats.maxSendMs) stats.maxSendMs = before.maxSendMs;
+}
+
+void printUplinkStats() {
+  uint32_t samples = stats.samples ? stats.samples : 1;
+  Serial.printf("Uplink (%s): %u samples, %u failed, %u payload bytes, send avg %u max %u ms\n",
+                transport.name, stats.samples, stats.failures, stats.payloadBytes,
+                stats.totalSendMs / samples, stats.maxSendMs);
+}
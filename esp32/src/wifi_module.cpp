@@ -1,14 +1,43 @@
 #include "wifi_module.h"
 #include <WiFi.h>
+#include <esp_wifi.h>
 #include <Arduino.h>
 #include "config.h"
 
+#define WIFI_FAST_JOIN_MS 3000  // then the access point has moved; join normally
+
 const char* ssid = WIFI_SSID;
 const char* password = WIFI_PASSWORD;
 
-void setupWiFi() {
-  WiFi.begin(ssid, password);
+static bool waitConnected(uint32_t timeoutMs) {
+  uint32_t start = millis();
   while (WiFi.status() != WL_CONNECTED) {
-    delay(1000);
+    if (timeoutMs && millis() - start >= timeoutMs) return false;
+    delay(100);
+  }
+  return true;
+}
+
+void setupWiFi(int32_t channel, const uint8_t *bssid) {
+  if (channel > 0 && bssid != NULL) {
+    WiFi.begin(ssid, password, channel, bssid);
+    if (!waitConnected(WIFI_FAST_JOIN_MS)) {
+      WiFi.disconnect();
+      WiFi.begin(ssid, password);
+    }
+  } else {
+    WiFi.begin(ssid, password);
   }
+  waitConnected(0);
+  // UTC wall clock for history buckets; syncs in the background
+  configTime(0, 0, "pool.ntp.org", "time.google.com");
+}
+
+void reconnectWiFi() {
+  WiFi.disconnect();
+  WiFi.begin(ssid, password);
+}
+
+void setWiFiPowerSave(bool enabled) {
+  esp_wifi_set_ps(enabled ? WIFI_PS_MAX_MODEM : WIFI_PS_NONE);
 }
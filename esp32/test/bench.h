@@ -0,0 +1,44 @@
+#pragma once
+// Timing helper shared by the native test suites.
+//
+// benchRun() times `op` and prints one JSON line per benchmark:
+//   BENCH {"name":"classifyRisk","iterations":200000,"ns_per_op":41.3,"budget_ns":400}
+// so CI can grep and chart results. When BENCH_RESULTS names a file the
+// line is appended there as well. A benchmark fails when it exceeds its
+// budget (test/bench_budgets.h) times BENCH_BUDGET_SCALE.
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+#include "bench_budgets.h"
+
+// Results go here so the optimiser cannot drop the benchmarked work
+static volatile float benchSink;
+
+template <typename Op>
+double benchRun(const char *name, uint32_t iterations, double budgetNs, Op op) {
+  for (uint32_t i = 0; i < iterations / 10; i++) op(i);  // warm caches and branch predictors
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) op(i);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  double perOp = ns / iterations;
+  double budget = budgetNs * BENCH_BUDGET_SCALE;
+
+  char line[192];
+  snprintf(line, sizeof(line), "BENCH {\"name\":\"%s\",\"iterations\":%u,\"ns_per_op\":%.1f,\"budget_ns\":%.0f}",
+           name, (unsigned)iterations, perOp, budget);
+  printf("%s\n", line);
+  const char *path = getenv("BENCH_RESULTS");
+  if (path) {
+    FILE *f = fopen(path, "a");
+    if (f) {
+      fprintf(f, "%s\n", line + 6);
+      fclose(f);
+    }
+  }
+  TEST_ASSERT_TRUE_MESSAGE(perOp <= budget, line);
+  return perOp;
+}
@@ -0,0 +1,31 @@
+#pragma once
+// Per-operation budgets for the native benchmarks, in nanoseconds on the
+// host. They sit roughly 10x above a typical desktop run so only a real
+// regression trips them. Scale all of them at once for slow CI machines
+// with -DBENCH_BUDGET_SCALE=<factor> in build_flags.
+
+#ifndef BENCH_BUDGET_SCALE
+#define BENCH_BUDGET_SCALE 1.0
+#endif
+
+#define BUDGET_CLASSIFY_RISK_NS 400
+#define BUDGET_NOTIFY_NEXT_DUE_NS 400
+#define BUDGET_PIPELINE_PROCESS_NS 3000
+#define BUDGET_FAST_ATAN2_NS 100
+#define BUDGET_FAST_SQRT_NS 100
+#define BUDGET_FUSION_UPDATE_NS 400
+#define BUDGET_TELEMETRY_JSON_NS 20000
+#define BUDGET_LCD_RENDER_NS 1500
+#define BUDGET_RAW_RECORD_DECODE_NS 10000
+#define BUDGET_MESH_GATEWAY_RECEIVE_NS 2000
+#define BUDGET_ARENA_STATUS_NS 4000
+#define BUDGET_SCHEDULER_RUN_NS 1000
+#define BUDGET_ADAPTIVE_RATE_NS 400
+#define BUDGET_ANOMALY_UPDATE_NS 400
+#define BUDGET_HISTORY_ADD_NS 300
+#define BUDGET_SERIES_APPEND_NS 10000
+#define BUDGET_SERIES_NEXT_NS 5000
+#define BUDGET_LIVE_FRAME_ADD_NS 1000
+#define BUDGET_HISTORY_STREAM_NS 5000000  // a whole 120-bucket response
+#define BUDGET_ALARM_FAST_TRIGGER_NS 400
+#define BUDGET_DEADLINE_CHECK_NS 150
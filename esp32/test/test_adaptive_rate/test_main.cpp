@@ -0,0 +1,124 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "adaptive_rate.h"
+#include "sensor_pipeline.h"
+
+static RiskThresholds thresholds;
+static SensorSample calm;
+static AdaptiveRate rate;
+
+void setUp() {
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  thresholds = config.thresholds;
+  memset(&calm, 0, sizeof(calm));
+  calm.angleX = 1.0f;
+  calm.soilMoisture = 0.10f;
+  calm.rain = 0.0f;
+  calm.vibrationRMS = 0.0f;
+  adaptiveRateInit(rate, 0);
+}
+void tearDown() {}
+
+// Classifies `sample` at 20 Hz for `durationMs`, like the classify stage
+static uint32_t feed(const SensorSample &sample, RiskLevel level, uint32_t fromMs, uint32_t durationMs) {
+  for (uint32_t t = fromMs; t < fromMs + durationMs; t += 50) {
+    adaptiveRateUpdate(rate, thresholds, level, sample, t);
+  }
+  return fromMs + durationMs;
+}
+
+static void test_boots_at_full_rate() {
+  TEST_ASSERT_EQUAL(RATE_FULL, rate.profile);
+  TEST_ASSERT_EQUAL_UINT16(SENSOR_SAMPLE_RATE_HZ, ratePolicy(RATE_FULL).sampleRateHz);
+  TEST_ASSERT_TRUE(ratePolicy(RATE_FULL).vibrationWindow <= VIBRATION_SAMPLES);
+  TEST_ASSERT_TRUE(ratePolicy(RATE_WATCH).vibrationWindow <= VIBRATION_SAMPLES);
+  TEST_ASSERT_TRUE(ratePolicy(RATE_SAFE).vibrationWindow <= VIBRATION_SAMPLES);
+}
+
+static void test_calm_slope_steps_down_one_profile_per_hold() {
+  uint32_t t = feed(calm, RISK_SAFE, 0, RATE_HOLD_MS - 1000);
+  TEST_ASSERT_EQUAL(RATE_FULL, rate.profile);
+  t = feed(calm, RISK_SAFE, t, 2000);
+  TEST_ASSERT_EQUAL(RATE_WATCH, rate.profile);
+  t = feed(calm, RISK_SAFE, t, RATE_HOLD_MS);
+  TEST_ASSERT_EQUAL(RATE_SAFE, rate.profile);
+  TEST_ASSERT_EQUAL_UINT32(2, rate.transitions);
+}
+
+static void test_warning_escalates_immediately() {
+  uint32_t t = feed(calm, RISK_SAFE, 0, 2 * RATE_HOLD_MS + 1000);
+  TEST_ASSERT_EQUAL(RATE_SAFE, rate.profile);
+  TEST_ASSERT_TRUE(adaptiveRateUpdate(rate, thresholds, RISK_WARNING, calm, t));
+  TEST_ASSERT_EQUAL(RATE_FULL, rate.profile);
+}
+
+static void test_near_threshold_holds_watch() {
+  uint32_t t = feed(calm, RISK_SAFE, 0, 2 * RATE_HOLD_MS + 1000);
+  SensorSample wet = calm;
+  wet.soilMoisture = thresholds.moistureWarning / 100.0f * 0.8f;
+  adaptiveRateUpdate(rate, thresholds, RISK_SAFE, wet, t);
+  TEST_ASSERT_EQUAL(RATE_WATCH, rate.profile);
+  t = feed(wet, RISK_SAFE, t, 2 * RATE_HOLD_MS);
+  TEST_ASSERT_EQUAL(RATE_WATCH, rate.profile);
+}
+
+static void test_rising_tilt_trend_raises_watch() {
+  uint32_t t = feed(calm, RISK_SAFE, 0, 2 * RATE_HOLD_MS + 1000);
+  TEST_ASSERT_EQUAL(RATE_SAFE, rate.profile);
+  // Creeping 1 degree a minute, still far below the warning angle
+  SensorSample creeping = calm;
+  for (int minute = 0; minute < 3 && rate.profile == RATE_SAFE; minute++) {
+    creeping.angleX += 1.0f;
+    t = feed(creeping, RISK_SAFE, t, RATE_TREND_WINDOW_MS);
+  }
+  TEST_ASSERT_EQUAL(RATE_WATCH, rate.profile);
+  TEST_ASSERT_TRUE(rate.tiltTrend >= RATE_TILT_TREND_DEG_PER_MIN);
+}
+
+static void test_flapping_level_does_not_flap_rate() {
+  uint32_t t = 0;
+  for (int i = 0; i < 20; i++) {
+    t = feed(calm, RISK_WARNING, t, 1000);
+    t = feed(calm, RISK_SAFE, t, 60000);
+  }
+  TEST_ASSERT_EQUAL(RATE_FULL, rate.profile);
+  TEST_ASSERT_EQUAL_UINT32(0, rate.transitions);
+}
+
+static void test_pipeline_follows_frame_rate() {
+  SensorPipeline pipeline;
+  pipelineInit(pipeline);
+  RawSensorFrame raw = {};
+  raw.accel[2] = 9.8f;
+  raw.flags = RAW_FLAG_MOTION | (RATE_SAFE << RAW_FLAG_RATE_SHIFT);
+  SensorSample sample;
+  pipelineProcess(pipeline, raw, sample);
+  TEST_ASSERT_EQUAL_UINT8(RATE_SAFE, pipeline.rateProfile);
+  TEST_ASSERT_EQUAL_INT(ratePolicy(RATE_SAFE).vibrationWindow, pipeline.vibrationWindow);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f / 25, pipeline.fusion.dt);
+}
+
+static void bench_adaptive_rate_update() {
+  SensorSample sample = calm;
+  benchRun("adaptiveRateUpdate", 200000, BUDGET_ADAPTIVE_RATE_NS, [&](uint32_t i) {
+    sample.angleX = (float)(i % 100) / 10.0f;
+    adaptiveRateUpdate(rate, thresholds, RISK_SAFE, sample, i * 50);
+    benchSink = rate.profile;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_boots_at_full_rate);
+  RUN_TEST(test_calm_slope_steps_down_one_profile_per_hold);
+  RUN_TEST(test_warning_escalates_immediately);
+  RUN_TEST(test_near_threshold_holds_watch);
+  RUN_TEST(test_rising_tilt_trend_raises_watch);
+  RUN_TEST(test_flapping_level_does_not_flap_rate);
+  RUN_TEST(test_pipeline_follows_frame_rate);
+  RUN_TEST(bench_adaptive_rate_update);
+  return UNITY_END();
+}
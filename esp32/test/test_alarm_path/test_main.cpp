@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "alarm_path.h"
+#include "risk.h"
+
+static RuntimeConfig config;
+static SensorSample calm;
+static AlarmState state;
+
+void setUp() {
+  defaultRuntimeConfig(config);
+  memset(&calm, 0, sizeof(calm));
+  calm.angleX = 1.0f;
+  calm.soilMoisture = 0.10f;
+  alarmStateInit(state);
+}
+void tearDown() {}
+
+static void test_fast_trigger_on_danger_only() {
+  TEST_ASSERT_FALSE(alarmFastTrigger(config, calm));
+  SensorSample tilted = calm;
+  tilted.angleX = config.thresholds.tiltDanger + 1;
+  TEST_ASSERT_TRUE(alarmFastTrigger(config, tilted));
+  SensorSample warning = calm;
+  warning.angleX = (config.thresholds.tiltWarningMin + config.thresholds.tiltDanger) / 2;
+  TEST_ASSERT_FALSE(alarmFastTrigger(config, warning));
+  SensorSample shaking = calm;
+  shaking.vibrationRMS = config.thresholds.vibrationDanger;
+  TEST_ASSERT_TRUE(alarmFastTrigger(config, shaking));
+}
+
+static void test_danger_channel_wins_over_warning_channel() {
+  // Saturated soil on a slope that is only tilting into its warning band
+  SensorSample sample = calm;
+  sample.soilMoisture = 0.90f;
+  sample.angleX = 12.0f;
+  TEST_ASSERT_TRUE(alarmFastTrigger(config, sample));
+  RiskLevel level;
+  bool alert;
+  classifyRisk(config.thresholds, sample.angleX, sample.angleY, sample.soilMoisture, sample.rain,
+               sample.vibrationRMS, level, alert);
+  TEST_ASSERT_EQUAL(RISK_DANGER, level);
+  TEST_ASSERT_TRUE(alert);
+  // Same with the danger on tilt and a warning on rain
+  sample = calm;
+  sample.angleY = config.thresholds.tiltDanger + 1;
+  sample.rain = 0.25f;
+  TEST_ASSERT_TRUE(alarmFastTrigger(config, sample));
+}
+
+static void test_fast_trigger_respects_mode() {
+  SensorSample tilted = calm;
+  tilted.angleY = -(config.thresholds.tiltDanger + 1);
+  config.mode = MODE_SILENT;
+  TEST_ASSERT_FALSE(alarmFastTrigger(config, tilted));
+  config.mode = MODE_TEST;
+  TEST_ASSERT_TRUE(alarmFastTrigger(config, tilted));
+}
+
+static void test_fast_hold_then_loop_takes_over() {
+  alarmOnFastTrigger(state, 1000);
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, 1000));
+  TEST_ASSERT_EQUAL_UINT32(ALARM_FAST_HOLD_MS, alarmHoldRemainingMs(state, 1000));
+  // The loop confirms, so the alarm outlasts the hold
+  alarmOnLoopRequest(state, true);
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, 1000 + ALARM_FAST_HOLD_MS + 1));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, alarmHoldRemainingMs(state, 1000 + ALARM_FAST_HOLD_MS + 1));
+  alarmOnLoopRequest(state, false);
+  TEST_ASSERT_FALSE(alarmUpdateOutputs(state, MODE_NORMAL, 1000 + ALARM_FAST_HOLD_MS + 2));
+}
+
+static void test_fast_hold_expires_without_loop() {
+  alarmOnFastTrigger(state, 0xFFFFFF00u);  // across the millis() wrap
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, 0xFFFFFF00u));
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, 0xFFFFFF00u + ALARM_FAST_HOLD_MS - 1));
+  TEST_ASSERT_EQUAL_UINT32(1, alarmHoldRemainingMs(state, 0xFFFFFF00u + ALARM_FAST_HOLD_MS - 1));
+  TEST_ASSERT_FALSE(alarmUpdateOutputs(state, MODE_NORMAL, 0xFFFFFF00u + ALARM_FAST_HOLD_MS));
+  TEST_ASSERT_FALSE(state.fastActive);
+}
+
+static void test_repeated_hits_extend_hold() {
+  alarmOnFastTrigger(state, 0);
+  alarmOnFastTrigger(state, 2000);
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, ALARM_FAST_HOLD_MS + 1000));
+}
+
+static void test_silent_mode_keeps_outputs_off() {
+  alarmOnFastTrigger(state, 0);
+  alarmOnLoopRequest(state, true);
+  TEST_ASSERT_FALSE(alarmUpdateOutputs(state, MODE_SILENT, 10));
+  TEST_ASSERT_TRUE(alarmUpdateOutputs(state, MODE_NORMAL, 10));
+}
+
+static void test_latency_histogram() {
+  AlarmLatency latency;
+  memset(&latency, 0, sizeof(latency));
+  alarmLatencyRecord(latency, 80);
+  alarmLatencyRecord(latency, 100);
+  alarmLatencyRecord(latency, 101);
+  alarmLatencyRecord(latency, 9000);
+  alarmLatencyRecord(latency, ALARM_DEADLINE_US + 1);
+  TEST_ASSERT_EQUAL_UINT32(5, latency.count);
+  TEST_ASSERT_EQUAL_UINT32(2, latency.buckets[0]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.buckets[1]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.buckets[ALARM_LATENCY_BUCKETS - 2]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.buckets[ALARM_LATENCY_BUCKETS - 1]);
+  TEST_ASSERT_EQUAL_UINT32(1, latency.deadlineMisses);
+  TEST_ASSERT_EQUAL_UINT32(ALARM_DEADLINE_US + 1, latency.maxUs);
+  TEST_ASSERT_EQUAL_UINT32(ALARM_DEADLINE_US, alarmLatencyBucketLimitUs(ALARM_LATENCY_BUCKETS - 2));
+}
+
+// Runs in the sensor task on every sample
+static void bench_alarm_fast_trigger() {
+  SensorSample sample = calm;
+  benchRun("alarmFastTrigger", 500000, BUDGET_ALARM_FAST_TRIGGER_NS, [&](uint32_t i) {
+    sample.angleX = (float)(i % 400) / 10.0f;
+    benchSink = alarmFastTrigger(config, sample);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fast_trigger_on_danger_only);
+  RUN_TEST(test_danger_channel_wins_over_warning_channel);
+  RUN_TEST(test_fast_trigger_respects_mode);
+  RUN_TEST(test_fast_hold_then_loop_takes_over);
+  RUN_TEST(test_fast_hold_expires_without_loop);
+  RUN_TEST(test_repeated_hits_extend_hold);
+  RUN_TEST(test_silent_mode_keeps_outputs_off);
+  RUN_TEST(test_latency_histogram);
+  RUN_TEST(bench_alarm_fast_trigger);
+  return UNITY_END();
+}
@@ -0,0 +1,169 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "anomaly.h"
+
+static AnomalyDetector detector;
+static SensorSample sample;
+static uint32_t nowMs;
+static uint32_t noise = 12345;
+
+void setUp() {
+  anomalyInit(detector, 0);
+  memset(&sample, 0, sizeof(sample));
+  sample.angleX = 2.0f;
+  sample.soilMoisture = 0.20f;
+  sample.rain = 0.05f;
+  sample.vibrationRMS = 0.05f;
+  nowMs = 0;
+}
+void tearDown() {}
+
+// Uniform in [-1, 1), repeatable
+static float jitter() {
+  noise = noise * 1103515245u + 12345u;
+  return ((noise >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+// Classifies at 20 Hz for `seconds`, with sensor-sized noise on tilt and
+// vibration; the analog channels step in whole percents like the ADC map
+static void run(float seconds, float moistureRatePerMin = 0, float tiltRatePerMin = 0) {
+  for (uint32_t i = 0; i < (uint32_t)(seconds * 20); i++) {
+    nowMs += 50;
+    SensorSample s = sample;
+    float minutes = 50 / 60000.0f;
+    sample.soilMoisture += moistureRatePerMin / 100 * minutes;
+    sample.angleX += tiltRatePerMin * minutes;
+    s.soilMoisture = floorf(sample.soilMoisture * 100) / 100;
+    s.angleX += 0.05f * jitter();
+    s.vibrationRMS += 0.01f * jitter();
+    anomalyUpdate(detector, s, nowMs);
+  }
+}
+
+static void test_steps_once_a_second() {
+  for (int i = 0; i < 19; i++) {
+    nowMs += 50;
+    TEST_ASSERT_FALSE(anomalyUpdate(detector, sample, nowMs));
+  }
+  nowMs += 50;
+  TEST_ASSERT_TRUE(anomalyUpdate(detector, sample, nowMs));
+  TEST_ASSERT_EQUAL_UINT32(1, detector.channels[ANOMALY_TILT].count);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 20.0f, detector.channels[ANOMALY_MOISTURE].mean);
+}
+
+static void test_welford_matches_batch_statistics() {
+  ChannelStats reference;
+  memset(&reference, 0, sizeof(reference));
+  AnomalyDetector d;
+  anomalyInit(d, 0);
+  float values[] = { 2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f };
+  uint32_t t = 0;
+  for (float v : values) {
+    SensorSample s = sample;
+    s.angleX = v;
+    t += ANOMALY_STEP_MS;
+    anomalyUpdate(d, s, t);
+  }
+  const ChannelStats &c = d.channels[ANOMALY_TILT];
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 5.0f, c.mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 32.0f / 7, anomalyLongRunVariance(c));
+}
+
+static void test_steady_noise_stays_quiet() {
+  run(6 * 3600);
+  TEST_ASSERT_EQUAL_UINT8(0, detector.mask);
+  TEST_ASSERT_EQUAL_UINT32(0, detector.alarms);
+  for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) TEST_ASSERT_TRUE(detector.channels[i].score < 0.5f);
+}
+
+static void test_no_score_during_warmup() {
+  run(ANOMALY_WARMUP_STEPS - 10);
+  sample.angleX += 5.0f;
+  run(5);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, detector.channels[ANOMALY_TILT].score);
+}
+
+static void test_slow_moisture_rise_alarms_before_the_threshold() {
+  run(600);
+  // 1% a minute from 20%: the 30% warning is 10 minutes away
+  uint32_t start = nowMs;
+  while (!(detector.mask & (1 << ANOMALY_MOISTURE)) && nowMs - start < 600000) run(1, 1.0f);
+  TEST_ASSERT_TRUE(detector.mask & (1 << ANOMALY_MOISTURE));
+  TEST_ASSERT_TRUE(sample.soilMoisture < 0.26f);
+}
+
+static void test_small_tilt_step_alarms_and_clears() {
+  run(600);
+  sample.angleX += 0.5f;
+  run(30);
+  TEST_ASSERT_TRUE(detector.mask & (1 << ANOMALY_TILT));
+  TEST_ASSERT_EQUAL_UINT32(1, detector.alarms);
+  // The baseline absorbs a step that stays put
+  run(2 * 3600);
+  TEST_ASSERT_FALSE(detector.mask & (1 << ANOMALY_TILT));
+}
+
+static void test_falling_values_are_not_anomalies() {
+  run(600);
+  sample.soilMoisture -= 0.10f;
+  run(120);
+  TEST_ASSERT_EQUAL_UINT8(0, detector.mask);
+}
+
+static void test_nan_does_not_poison_the_channel() {
+  run(300);
+  sample.vibrationRMS = NAN;
+  run(2);
+  sample.vibrationRMS = 0.05f;
+  run(60);
+  TEST_ASSERT_FALSE(isnan(detector.channels[ANOMALY_VIBRATION].baseline));
+  TEST_ASSERT_EQUAL_UINT8(0, detector.mask);
+}
+
+static void test_risk_escalation() {
+  TEST_ASSERT_EQUAL(RISK_SAFE, anomalyRiskLevel(RISK_SAFE, 0));
+  TEST_ASSERT_EQUAL(RISK_WARNING, anomalyRiskLevel(RISK_SAFE, 1 << ANOMALY_TILT));
+  TEST_ASSERT_EQUAL(RISK_SAFE, anomalyRiskLevel(RISK_SAFE, 1 << ANOMALY_MOISTURE));
+  TEST_ASSERT_EQUAL(RISK_SAFE, anomalyRiskLevel(RISK_SAFE, 1 << ANOMALY_VIBRATION));
+  TEST_ASSERT_EQUAL(RISK_WARNING, anomalyRiskLevel(RISK_SAFE, (1 << ANOMALY_MOISTURE) | (1 << ANOMALY_RAIN)));
+  TEST_ASSERT_EQUAL(RISK_DANGER, anomalyRiskLevel(RISK_DANGER, 0x0F));
+  TEST_ASSERT_EQUAL(RISK_UNKNOWN, anomalyRiskLevel(RISK_UNKNOWN, 0x0F));
+}
+
+static void test_status_carries_the_scores() {
+  run(600);
+  sample.angleX += 1.0f;
+  run(30);
+  RiskStatus status = {};
+  anomalyFillStatus(detector, status);
+  TEST_ASSERT_EQUAL_UINT8(detector.mask, status.anomalyMask);
+  TEST_ASSERT_TRUE(status.anomalyScore[ANOMALY_TILT] >= 1.0f);
+  TEST_ASSERT_TRUE(status.anomalyScore[ANOMALY_TILT] <= ANOMALY_CUSUM_CAP);
+}
+
+static void bench_anomaly_update() {
+  benchRun("anomalyUpdate", 200000, BUDGET_ANOMALY_UPDATE_NS, [&](uint32_t i) {
+    sample.angleX = (float)(i % 100) / 50.0f;
+    anomalyUpdate(detector, sample, i * 50);
+    benchSink = detector.mask;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_steps_once_a_second);
+  RUN_TEST(test_welford_matches_batch_statistics);
+  RUN_TEST(test_steady_noise_stays_quiet);
+  RUN_TEST(test_no_score_during_warmup);
+  RUN_TEST(test_slow_moisture_rise_alarms_before_the_threshold);
+  RUN_TEST(test_small_tilt_step_alarms_and_clears);
+  RUN_TEST(test_falling_values_are_not_anomalies);
+  RUN_TEST(test_nan_does_not_poison_the_channel);
+  RUN_TEST(test_risk_escalation);
+  RUN_TEST(test_status_carries_the_scores);
+  RUN_TEST(bench_anomaly_update);
+  return UNITY_END();
+}
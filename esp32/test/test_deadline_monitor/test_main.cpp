@@ -0,0 +1,116 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "deadline_monitor.h"
+
+#define ALL_ESCALATIONS (DEADLINE_ALLOW(DEADLINE_SKIP) | DEADLINE_ALLOW(DEADLINE_DEGRADE) | \
+                         DEADLINE_ALLOW(DEADLINE_RESTART) | DEADLINE_ALLOW(DEADLINE_REBOOT))
+
+static DeadlineMonitor monitor;
+
+void setUp() {
+  deadlineInit(monitor);
+}
+void tearDown() {}
+
+static void test_runs_within_budget_are_clean() {
+  int classify = deadlineAdd(monitor, "classify", 20000, ALL_ESCALATIONS);
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, classify, 20000));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.misses);
+  TEST_ASSERT_EQUAL_INT(-1, monitor.lastMiss);
+  TEST_ASSERT_EQUAL_UINT32(100, monitor.items[classify].checks);
+  TEST_ASSERT_EQUAL_UINT32(20000, monitor.items[classify].worstUs);
+}
+
+static void test_consecutive_misses_escalate_in_order() {
+  int upload = deadlineAdd(monitor, "upload", 1000000, ALL_ESCALATIONS);
+  DeadlineAction seen[DEADLINE_REBOOT_STREAK];
+  for (int i = 0; i < DEADLINE_REBOOT_STREAK; i++) seen[i] = deadlineCheck(monitor, upload, 3000000);
+  TEST_ASSERT_EQUAL(DEADLINE_MISS, seen[0]);
+  TEST_ASSERT_EQUAL(DEADLINE_SKIP, seen[DEADLINE_SKIP_STREAK - 1]);
+  TEST_ASSERT_EQUAL(DEADLINE_DEGRADE, seen[DEADLINE_DEGRADE_STREAK - 1]);
+  TEST_ASSERT_EQUAL(DEADLINE_RESTART, seen[DEADLINE_RESTART_STREAK - 1]);
+  TEST_ASSERT_EQUAL(DEADLINE_REBOOT, seen[DEADLINE_REBOOT_STREAK - 1]);
+  TEST_ASSERT_EQUAL(DEADLINE_MISS, seen[DEADLINE_RESTART_STREAK]);
+  const DeadlineItem &item = monitor.items[upload];
+  TEST_ASSERT_EQUAL_UINT32(DEADLINE_REBOOT_STREAK, item.misses);
+  TEST_ASSERT_EQUAL_UINT32(4, item.escalations);
+  TEST_ASSERT_EQUAL_UINT8(DEADLINE_REBOOT, item.worstAction);
+  TEST_ASSERT_EQUAL_INT(upload, monitor.lastMiss);
+}
+
+static void test_occasional_misses_only_count() {
+  int display = deadlineAdd(monitor, "display", 100000, ALL_ESCALATIONS);
+  for (int i = 0; i < 50; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_MISS, deadlineCheck(monitor, display, 150000));
+    TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, display, 10000));
+  }
+  TEST_ASSERT_EQUAL_UINT32(50, monitor.items[display].misses);
+  TEST_ASSERT_EQUAL_UINT32(0, monitor.items[display].escalations);
+}
+
+static void test_escalations_are_limited_to_the_allowed_ones() {
+  int report = deadlineAdd(monitor, "report", 2000000, 0);
+  int mesh = deadlineAdd(monitor, "mesh", 20000, DEADLINE_ALLOW(DEADLINE_SKIP));
+  for (int i = 0; i < 2 * DEADLINE_REBOOT_STREAK; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_MISS, deadlineCheck(monitor, report, 5000000));
+    DeadlineAction action = deadlineCheck(monitor, mesh, 50000);
+    TEST_ASSERT_EQUAL(i == DEADLINE_SKIP_STREAK - 1 ? DEADLINE_SKIP : DEADLINE_MISS, action);
+  }
+  TEST_ASSERT_EQUAL_UINT32(4 * DEADLINE_REBOOT_STREAK, monitor.misses);
+  TEST_ASSERT_EQUAL_INT(mesh, monitor.lastMiss);
+}
+
+static void test_degraded_item_recovers_after_clean_checks() {
+  int uplink = deadlineAdd(monitor, "uplink", 500000, DEADLINE_ALLOW(DEADLINE_DEGRADE));
+  for (int i = 0; i < DEADLINE_DEGRADE_STREAK; i++) deadlineCheck(monitor, uplink, 600000);
+  TEST_ASSERT_TRUE(monitor.items[uplink].degraded);
+  // A second overrunning spell while still degraded does not degrade again
+  for (int i = 0; i < DEADLINE_DEGRADE_STREAK; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, uplink, 1000));
+  }
+  for (int i = 0; i < DEADLINE_DEGRADE_STREAK; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_MISS, deadlineCheck(monitor, uplink, 600000));
+  }
+  for (int i = 0; i < DEADLINE_RECOVER_CHECKS - 1; i++) {
+    TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, uplink, 1000));
+  }
+  TEST_ASSERT_EQUAL(DEADLINE_RESTORE, deadlineCheck(monitor, uplink, 1000));
+  TEST_ASSERT_FALSE(monitor.items[uplink].degraded);
+  TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, uplink, 1000));
+  TEST_ASSERT_EQUAL_UINT32(1, monitor.items[uplink].escalations);
+}
+
+static void test_table_limits() {
+  for (int i = 0; i < DEADLINE_MAX_ITEMS; i++) {
+    TEST_ASSERT_EQUAL_INT(i, deadlineAdd(monitor, "item", 1000, 0));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, deadlineAdd(monitor, "item", 1000, 0));
+  deadlineInit(monitor);
+  TEST_ASSERT_EQUAL_INT(-1, deadlineAdd(monitor, "zero", 0, 0));
+  TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, 3, 5000));
+  TEST_ASSERT_EQUAL(DEADLINE_OK, deadlineCheck(monitor, -1, 5000));
+  TEST_ASSERT_EQUAL_STRING("degrade", deadlineActionName(DEADLINE_DEGRADE));
+}
+
+static void bench_deadline_check() {
+  int classify = deadlineAdd(monitor, "classify", 20000, ALL_ESCALATIONS);
+  benchRun("deadlineCheck", 500000, BUDGET_DEADLINE_CHECK_NS, [&](uint32_t i) {
+    benchSink = deadlineCheck(monitor, classify, (i & 63) == 0 ? 25000 : 5000);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_runs_within_budget_are_clean);
+  RUN_TEST(test_consecutive_misses_escalate_in_order);
+  RUN_TEST(test_occasional_misses_only_count);
+  RUN_TEST(test_escalations_are_limited_to_the_allowed_ones);
+  RUN_TEST(test_degraded_item_recovers_after_clean_checks);
+  RUN_TEST(test_table_limits);
+  RUN_TEST(bench_deadline_check);
+  return UNITY_END();
+}
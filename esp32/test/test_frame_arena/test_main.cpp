@@ -0,0 +1,134 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "frame_arena.h"
+
+static uint8_t buffer[1024] __attribute__((aligned(ARENA_ALIGN)));
+static FrameArena arena;
+
+void setUp() {
+  memset(buffer, 0xAA, sizeof(buffer));
+  arenaInit(arena, buffer, sizeof(buffer));
+}
+void tearDown() {}
+
+static void test_allocations_are_aligned_and_counted() {
+  uint8_t *a = (uint8_t *)arenaAlloc(arena, 3);
+  uint8_t *b = (uint8_t *)arenaAlloc(arena, 8);
+  TEST_ASSERT_EQUAL_PTR(buffer, a);
+  TEST_ASSERT_EQUAL_PTR(buffer + ARENA_ALIGN, b);
+  TEST_ASSERT_EQUAL_UINT32(ARENA_ALIGN + 8, arena.used);
+  TEST_ASSERT_NULL(arenaAlloc(arena, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_UINT32(1, arena.overflows);
+}
+
+static void test_reset_keeps_the_peak() {
+  arenaAlloc(arena, 300);
+  arenaReset(arena);
+  arenaAlloc(arena, 100);
+  TEST_ASSERT_EQUAL_UINT32(100, arena.used);
+  TEST_ASSERT_EQUAL_UINT32(300, arena.peak);
+}
+
+static void test_release_returns_to_mark() {
+  arenaAlloc(arena, 16);
+  size_t mark = arenaMark(arena);
+  arenaAlloc(arena, 200);
+  arenaRelease(arena, mark);
+  TEST_ASSERT_EQUAL_UINT32(16, arena.used);
+}
+
+static void test_string_appends_and_formats() {
+  ArenaString s(arena, 8);
+  s += "tanah aman";
+  s += '\n';
+  s.appendf("Tilt:%.1f", 3.26f);
+  TEST_ASSERT_EQUAL_STRING("tanah aman\nTilt:3.3", s.c_str());
+  TEST_ASSERT_EQUAL_UINT32(strlen("tanah aman\nTilt:3.3"), s.length());
+  TEST_ASSERT_FALSE(s.truncated());
+}
+
+static void test_top_string_grows_in_place() {
+  ArenaString s(arena, 8);
+  const char *start = s.c_str();
+  for (int i = 0; i < 20; i++) s += "0123456789";
+  TEST_ASSERT_EQUAL_PTR(start, s.c_str());
+  TEST_ASSERT_EQUAL_UINT32(200, s.length());
+}
+
+static void test_buried_string_is_moved() {
+  ArenaString a(arena, 8);
+  ArenaString b(arena, 8);
+  a += "longer than eight bytes";
+  b += "b";
+  TEST_ASSERT_EQUAL_STRING("longer than eight bytes", a.c_str());
+  TEST_ASSERT_EQUAL_STRING("b", b.c_str());
+}
+
+static void test_full_arena_truncates_string() {
+  ArenaString s(arena);
+  for (int i = 0; i < 400; i++) s.appendf("%d,", i);
+  TEST_ASSERT_TRUE(s.truncated());
+  TEST_ASSERT_EQUAL_UINT32(sizeof(buffer) - 1, s.length());
+  TEST_ASSERT_EQUAL_UINT32(strlen(s.c_str()), s.length());
+  TEST_ASSERT_EQUAL_UINT32(1, arena.overflows);
+}
+
+static void test_json_document() {
+  ArenaJson json(arena);
+  json.beginObject()
+      .addString("deviceId", "node-\"7\"")
+      .addFloat("rainfall", 0.0712f)
+      .addFloat("angleX", NAN, 1)
+      .beginObject("status")
+        .addBool("alertTriggered", true)
+        .addInt("offset", -12)
+        .addUInt("sequence", 4000000000ul)
+      .endObject()
+      .addRaw("tilt", "{\"x\":1}")
+      .endObject();
+  TEST_ASSERT_FALSE(json.truncated());
+  TEST_ASSERT_EQUAL_STRING("{\"deviceId\":\"node-\\\"7\\\"\",\"rainfall\":0.07,\"angleX\":0.0,"
+                           "\"status\":{\"alertTriggered\":true,\"offset\":-12,\"sequence\":4000000000},"
+                           "\"tilt\":{\"x\":1}}", json.c_str());
+}
+
+static void test_json_escapes_control_characters() {
+  ArenaJson json(arena);
+  json.beginObject().addString("text", "a\nb\\c\x01").endObject();
+  TEST_ASSERT_EQUAL_STRING("{\"text\":\"a\\nb\\\\c\\u0001\"}", json.c_str());
+}
+
+static void test_unclosed_json_reports_truncated() {
+  ArenaJson json(arena);
+  json.beginObject().addInt("a", 1);
+  TEST_ASSERT_TRUE(json.truncated());
+}
+
+static void bench_arena_status_line() {
+  static const char *status[] = { "tanah aman", "tanah waspada", "tanah AWAS!" };
+  benchRun("arenaStatusLine", 200000, BUDGET_ARENA_STATUS_NS, [&](uint32_t i) {
+    ArenaString message(arena, 34);
+    message.appendf("%s\nTilt:%.1f", status[i % 3], (float)(i % 200) / 10.0f);
+    benchSink = message.length();
+    arenaReset(arena);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_allocations_are_aligned_and_counted);
+  RUN_TEST(test_reset_keeps_the_peak);
+  RUN_TEST(test_release_returns_to_mark);
+  RUN_TEST(test_string_appends_and_formats);
+  RUN_TEST(test_top_string_grows_in_place);
+  RUN_TEST(test_buried_string_is_moved);
+  RUN_TEST(test_full_arena_truncates_string);
+  RUN_TEST(test_json_document);
+  RUN_TEST(test_json_escapes_control_characters);
+  RUN_TEST(test_unclosed_json_reports_truncated);
+  RUN_TEST(bench_arena_status_line);
+  return UNITY_END();
+}
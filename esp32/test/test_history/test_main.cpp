@@ -0,0 +1,212 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "history.h"
+#include "risk.h"
+
+static SensorHistory history;
+static SensorSample sample;
+static uint32_t nowMs;
+
+void setUp() {
+  historyInit(history);
+  memset(&sample, 0, sizeof(sample));
+  sample.angleX = 2.0f;
+  sample.soilMoisture = 0.20f;
+  sample.vibrationRMS = 0.05f;
+  nowMs = 0;
+}
+void tearDown() {}
+
+// Classifies at 20 Hz for `seconds`, the tilt growing `degPerHour`
+static void run(uint32_t seconds, float degPerHour = 0) {
+  for (uint32_t i = 0; i < seconds * 20; i++) {
+    sample.angleX += degPerHour / (3600 * 20);
+    historyAdd(history, sample, nowMs);
+    nowMs += 50;
+  }
+}
+
+static void test_buckets_cascade() {
+  run(3 * 3600 + 5);
+  TEST_ASSERT_EQUAL_UINT16(HISTORY_SECONDS, historyCount(history, HISTORY_LEVEL_SECONDS));
+  TEST_ASSERT_EQUAL_UINT16(HISTORY_MINUTES, historyCount(history, HISTORY_LEVEL_MINUTES));
+  TEST_ASSERT_EQUAL_UINT16(3, historyCount(history, HISTORY_LEVEL_HOURS));
+  const HistoryBucket *second = historyAt(history, HISTORY_LEVEL_SECONDS, 0);
+  const HistoryBucket *older = historyAt(history, HISTORY_LEVEL_SECONDS, 1);
+  TEST_ASSERT_EQUAL_UINT32(1000, second->startMs - older->startMs);
+  const HistoryBucket *hour = historyAt(history, HISTORY_LEVEL_HOURS, 0);
+  TEST_ASSERT_EQUAL_UINT32(2 * 3600000UL, hour->startMs);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 20.0f, hour->channels[HISTORY_MOISTURE].mean);
+  TEST_ASSERT_NULL(historyAt(history, HISTORY_LEVEL_HOURS, 3));
+}
+
+static void test_min_max_mean_survive_aggregation() {
+  // One 2 s spike of 10 degrees inside a calm minute
+  run(20);
+  float calm = sample.angleX;
+  sample.angleX = 10.0f;
+  run(2);
+  sample.angleX = calm;
+  run(60);
+  const HistoryBucket *minute = historyAt(history, HISTORY_LEVEL_MINUTES, 0);
+  TEST_ASSERT_NOT_NULL(minute);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, minute->channels[HISTORY_TILT].max);
+  TEST_ASSERT_EQUAL_FLOAT(calm, minute->channels[HISTORY_TILT].min);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, calm + (10.0f - calm) * 2 / 60, minute->channels[HISTORY_TILT].mean);
+}
+
+static void test_rates_wait_for_enough_minutes() {
+  run((HISTORY_RATE_MIN_POINTS - 1) * 60, 1.0f);
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  TEST_ASSERT_FALSE(trend.ratesValid);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, trend.tiltVelocity);
+  run(120, 1.0f);
+  historyFeatures(history, trend);
+  TEST_ASSERT_TRUE(trend.ratesValid);
+}
+
+static void test_creep_rate_tracks_tilt_velocity() {
+  run(3600, 0.8f);
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.8f, trend.tiltVelocity);
+  // Creep stops: the fit forgets it within the window
+  run((HISTORY_RATE_WINDOW + 2) * 60);
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.0f, trend.tiltVelocity);
+}
+
+static void test_sliding_fit_stays_exact_over_days() {
+  run(2 * 86400, 0.3f);
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  // By now the float tilt gains a little less than 0.3 deg/h per step of
+  // the ramp, so compare with the line the minute means actually follow
+  float newest = historyAt(history, HISTORY_LEVEL_MINUTES, 0)->channels[HISTORY_TILT].mean;
+  float oldest = historyAt(history, HISTORY_LEVEL_MINUTES, HISTORY_RATE_WINDOW - 1)->channels[HISTORY_TILT].mean;
+  float expected = (newest - oldest) / (HISTORY_RATE_WINDOW - 1) * 60;
+  TEST_ASSERT_FLOAT_WITHIN(0.03f, 0.3f, expected);
+  TEST_ASSERT_FLOAT_WITHIN(0.002f, expected, trend.tiltVelocity);
+  TEST_ASSERT_EQUAL_UINT16(HISTORY_RATE_WINDOW, history.tiltFit.n);
+}
+
+static void test_stationary_tilt_stays_flat_over_months() {
+  // Sliding float sums used to drift here, to about -1 deg/h after 70 days
+  uint32_t seed = 12345;
+  float worst = 0;
+  for (uint32_t day = 0; day < 70; day++) {
+    for (uint32_t second = 0; second < 86400; second++) {
+      seed = seed * 1664525u + 1013904223u;
+      sample.angleX = 2.0f + ((seed >> 8) / 16777216.0f - 0.5f) * 0.1f;  // +-0.05 deg
+      historyAdd(history, sample, nowMs);
+      nowMs += 1000;
+    }
+    TrendFeatures trend;
+    historyFeatures(history, trend);
+    if (fabsf(trend.tiltVelocity) > worst) worst = fabsf(trend.tiltVelocity);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, worst);
+}
+
+static void test_moisture_rate() {
+  for (int minute = 0; minute < 40; minute++) {
+    sample.soilMoisture += 0.002f;  // 0.2 % a minute = 12 %/h
+    run(60);
+  }
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 12.0f, trend.moistureRate);
+}
+
+static void test_rain_event_accumulates_and_ends() {
+  sample.rain = 0.50f;
+  run(2 * 3600);
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, trend.rainEventHours);
+  // A dry spell shorter than HISTORY_RAIN_DRY_MS keeps the event open
+  sample.rain = 0;
+  run(3 * 3600);
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, trend.rainEventHours);
+  run(3 * 3600 + 5);
+  historyFeatures(history, trend);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, trend.rainEventHours);
+}
+
+static void test_rain_24h_is_a_sliding_window() {
+  sample.rain = 1.0f;
+  run(6 * 3600 + 60);
+  TrendFeatures trend;
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 6.0f, trend.rain24hHours);
+  sample.rain = 0;
+  run(24 * 3600);
+  historyFeatures(history, trend);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.0f, trend.rain24hHours);
+}
+
+static void test_creep_raises_the_risk() {
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  const RiskThresholds &t = config.thresholds;
+  TrendFeatures trend = {};
+  RiskLevel level = RISK_SAFE;
+  bool alert = false;
+  trend.tiltVelocity = t.creepDanger * 2;
+  applyTrendRisk(t, trend, level, alert);
+  TEST_ASSERT_EQUAL(RISK_SAFE, level);  // not enough history yet
+  trend.ratesValid = true;
+  trend.tiltVelocity = t.creepWarning;
+  applyTrendRisk(t, trend, level, alert);
+  TEST_ASSERT_EQUAL(RISK_WARNING, level);
+  TEST_ASSERT_FALSE(alert);
+  trend.tiltVelocity = t.creepDanger;
+  applyTrendRisk(t, trend, level, alert);
+  TEST_ASSERT_EQUAL(RISK_DANGER, level);
+  TEST_ASSERT_TRUE(alert);
+  // Recovering tilt never lowers a level
+  level = RISK_WARNING;
+  alert = false;
+  trend.tiltVelocity = -5.0f;
+  applyTrendRisk(t, trend, level, alert);
+  TEST_ASSERT_EQUAL(RISK_WARNING, level);
+}
+
+static void test_nan_reading_does_not_stick() {
+  sample.vibrationRMS = NAN;
+  run(2);
+  sample.vibrationRMS = 0.05f;
+  run(60);
+  const HistoryBucket *minute = historyAt(history, HISTORY_LEVEL_MINUTES, 0);
+  TEST_ASSERT_FALSE(isnan(minute->channels[HISTORY_VIBRATION].mean));
+}
+
+static void bench_history_add() {
+  benchRun("historyAdd", 500000, BUDGET_HISTORY_ADD_NS, [&](uint32_t i) {
+    sample.angleX = (float)(i % 100) / 50.0f;
+    historyAdd(history, sample, i * 50);
+    benchSink = history.rings[HISTORY_LEVEL_SECONDS].head;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_buckets_cascade);
+  RUN_TEST(test_min_max_mean_survive_aggregation);
+  RUN_TEST(test_rates_wait_for_enough_minutes);
+  RUN_TEST(test_creep_rate_tracks_tilt_velocity);
+  RUN_TEST(test_sliding_fit_stays_exact_over_days);
+  RUN_TEST(test_stationary_tilt_stays_flat_over_months);
+  RUN_TEST(test_moisture_rate);
+  RUN_TEST(test_rain_event_accumulates_and_ends);
+  RUN_TEST(test_rain_24h_is_a_sliding_window);
+  RUN_TEST(test_creep_raises_the_risk);
+  RUN_TEST(test_nan_reading_does_not_stick);
+  RUN_TEST(bench_history_add);
+  return UNITY_END();
+}
@@ -0,0 +1,78 @@
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "lcd_render.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_two_lines_are_padded() {
+  LcdFrame frame;
+  lcdRender("tanah aman\nTilt:3.2", frame);
+  TEST_ASSERT_EQUAL_STRING("tanah aman      ", frame.rows[0]);
+  TEST_ASSERT_EQUAL_STRING("Tilt:3.2        ", frame.rows[1]);
+}
+
+static void test_long_text_is_cut_at_the_edge() {
+  LcdFrame frame;
+  lcdRender("Initializing Firebase now\nsecond line that is long\nthird", frame);
+  TEST_ASSERT_EQUAL_STRING("Initializing Fir", frame.rows[0]);
+  TEST_ASSERT_EQUAL_STRING("second line that", frame.rows[1]);
+}
+
+static void test_empty_text_blanks_the_display() {
+  LcdFrame frame;
+  lcdRender("", frame);
+  TEST_ASSERT_EQUAL_STRING("                ", frame.rows[0]);
+  TEST_ASSERT_EQUAL_STRING("                ", frame.rows[1]);
+}
+
+static void test_only_changed_rows_are_reported() {
+  LcdFrame shown, next;
+  lcdRender("tanah waspada\nTilt:11.0", shown);
+  lcdRender("tanah waspada\nTilt:11.0", next);
+  TEST_ASSERT_EQUAL_UINT8(0, lcdChangedRows(shown, next));
+  lcdRender("tanah waspada\nTilt:11.4", next);
+  TEST_ASSERT_EQUAL_UINT8(0x02, lcdChangedRows(shown, next));
+  lcdRender("tanah AWAS!\nTilt:16.0", next);
+  TEST_ASSERT_EQUAL_UINT8(0x03, lcdChangedRows(shown, next));
+}
+
+static void test_row_stream_for_the_backpack() {
+  LcdFrame frame;
+  lcdRender("\nAW", frame);
+  uint8_t out[LCD_ROW_STREAM_BYTES];
+  TEST_ASSERT_EQUAL_INT(LCD_ROW_STREAM_BYTES, lcdEncodeRow(1, frame.rows[1], true, out));
+  // Cursor to 0x40: command 0xC0 as two nibbles, each with an enable pulse
+  const uint8_t cursor[] = { 0xC8, 0xCC, 0xC8, 0x08, 0x0C, 0x08 };
+  TEST_ASSERT_TRUE(memcmp(cursor, out, sizeof(cursor)) == 0);
+  // 'A' (0x41) as data
+  const uint8_t a[] = { 0x49, 0x4D, 0x49, 0x19, 0x1D, 0x19 };
+  TEST_ASSERT_TRUE(memcmp(a, out + 6, sizeof(a)) == 0);
+  // Padding space (0x20), backlight off
+  lcdEncodeRow(0, frame.rows[0], false, out);
+  const uint8_t space[] = { 0x21, 0x25, 0x21, 0x01, 0x05, 0x01 };
+  TEST_ASSERT_TRUE(memcmp(space, out + LCD_ROW_STREAM_BYTES - 6, sizeof(space)) == 0);
+  TEST_ASSERT_EQUAL_UINT8(0x80, out[0]);
+}
+
+static void bench_lcd_render() {
+  static const char *messages[] = { "tanah aman\nTilt:1.5", "tanah waspada\nTilt:11.0", "tanah AWAS!\nTilt:16.2" };
+  LcdFrame shown, next;
+  lcdRender("", shown);
+  benchRun("lcdRender+diff", 200000, BUDGET_LCD_RENDER_NS, [&](uint32_t i) {
+    lcdRender(messages[i % 3], next);
+    benchSink = lcdChangedRows(shown, next);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_two_lines_are_padded);
+  RUN_TEST(test_long_text_is_cut_at_the_edge);
+  RUN_TEST(test_empty_text_blanks_the_display);
+  RUN_TEST(test_only_changed_rows_are_reported);
+  RUN_TEST(test_row_stream_for_the_backpack);
+  RUN_TEST(bench_lcd_render);
+  return UNITY_END();
+}
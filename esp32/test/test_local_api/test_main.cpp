@@ -0,0 +1,215 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "local_api.h"
+
+static SensorHistory history;
+static uint8_t frame[LIVE_FRAME_MAX_BYTES];
+
+void setUp() {
+  historyInit(history);
+}
+void tearDown() {}
+
+static SensorSample makeSample(uint32_t sequence, uint32_t timestampMs) {
+  SensorSample s = {};
+  s.sequence = sequence;
+  s.timestampMs = timestampMs;
+  s.accelX = 0.31f;
+  s.accelY = -0.18f;
+  s.accelZ = 9.79f;
+  s.gyroX = 0.012f;
+  s.gyroY = -0.004f;
+  s.gyroZ = 0.0f;
+  s.temperature = 24.12f;
+  s.angleX = 1.85f;
+  s.angleY = -1.05f;
+  s.vibrationRMS = 0.042f;
+  s.rain = 0.1234f;
+  s.soilMoisture = 0.5678f;
+  return s;
+}
+
+static bool readBucket(HistoryLevel level, uint16_t age, HistoryBucket &bucket, uint16_t &count) {
+  count = historyCount(history, level);
+  const HistoryBucket *found = historyAt(history, level, age);
+  if (found) bucket = *found;
+  return found != NULL;
+}
+
+// Seconds buckets with a tilt equal to their index
+static void fillSeconds(int seconds) {
+  SensorSample s = makeSample(0, 0);
+  s.angleY = 0;
+  for (int i = 0; i <= seconds; i++) {
+    s.angleX = (float)i;
+    historyAdd(history, s, i * 1000);
+  }
+}
+
+// Drains the stream in `chunk`-byte buffers, like the chunked response does
+static size_t drain(HistoryStream &stream, char *out, size_t outSize, size_t chunk) {
+  size_t total = 0, n;
+  char buffer[1024];
+  while ((n = historyStreamFill(stream, readBucket, buffer, chunk)) > 0) {
+    TEST_ASSERT_TRUE(total + n < outSize);
+    memcpy(out + total, buffer, n);
+    total += n;
+  }
+  out[total] = 0;
+  return total;
+}
+
+static void test_live_frame_round_trip() {
+  LiveFrameWriter writer;
+  liveFrameInit(writer, frame);
+  for (int i = 0; i < 10; i++) TEST_ASSERT_TRUE(liveFrameAdd(writer, makeSample(100 + i, 5000 + i * 10)));
+  size_t len = liveFrameFinish(writer);
+  TEST_ASSERT_EQUAL_UINT32(12 + 10 * 28, len);
+
+  SensorSample out[LIVE_FRAME_MAX_SAMPLES];
+  TEST_ASSERT_EQUAL_INT(10, liveFrameDecode(frame, len, out, LIVE_FRAME_MAX_SAMPLES));
+  SensorSample expected = makeSample(109, 5090);
+  TEST_ASSERT_EQUAL_UINT32(100, out[0].sequence);
+  TEST_ASSERT_EQUAL_UINT32(5000, out[0].timestampMs);
+  TEST_ASSERT_EQUAL_UINT32(109, out[9].sequence);
+  TEST_ASSERT_EQUAL_UINT32(5090, out[9].timestampMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected.accelZ, out[9].accelZ);
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, expected.gyroX, out[9].gyroX);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected.angleY, out[9].angleY);
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, expected.vibrationRMS, out[9].vibrationRMS);
+  TEST_ASSERT_FLOAT_WITHIN(0.00005f, expected.rain, out[9].rain);
+  TEST_ASSERT_FLOAT_WITHIN(0.00005f, expected.soilMoisture, out[9].soilMoisture);
+}
+
+static void test_live_frames_chain_and_show_gaps() {
+  LiveFrameWriter writer;
+  liveFrameInit(writer, frame);
+  uint32_t sequence = 1;
+  for (int i = 0; i < LIVE_FRAME_MAX_SAMPLES; i++, sequence++) {
+    TEST_ASSERT_TRUE(liveFrameAdd(writer, makeSample(sequence, sequence * 10)));
+  }
+  TEST_ASSERT_FALSE(liveFrameAdd(writer, makeSample(sequence, sequence * 10)));
+  TEST_ASSERT_EQUAL_UINT32(LIVE_FRAME_MAX_BYTES, liveFrameFinish(writer));
+  TEST_ASSERT_EQUAL_UINT32(0, liveFrameFinish(writer));
+
+  // The next frame continues from the last sample; three were dropped
+  TEST_ASSERT_TRUE(liveFrameAdd(writer, makeSample(sequence + 3, (sequence + 3) * 10)));
+  size_t len = liveFrameFinish(writer);
+  SensorSample out[1];
+  TEST_ASSERT_EQUAL_INT(1, liveFrameDecode(frame, len, out, 1));
+  TEST_ASSERT_EQUAL_UINT32(sequence + 3, out[0].sequence);
+  TEST_ASSERT_EQUAL_UINT32((sequence + 3) * 10, out[0].timestampMs);
+  LiveSampleRecord record;
+  memcpy(&record, frame + sizeof(LiveFrameHeader), sizeof(record));
+  TEST_ASSERT_EQUAL_UINT16(4, record.sequenceDelta);
+}
+
+static void test_live_frame_rejects_malformed() {
+  LiveFrameWriter writer;
+  liveFrameInit(writer, frame);
+  liveFrameAdd(writer, makeSample(1, 10));
+  size_t len = liveFrameFinish(writer);
+  SensorSample out[1];
+  TEST_ASSERT_EQUAL_INT(-1, liveFrameDecode(frame, len - 1, out, 1));
+  frame[0] = 'X';
+  TEST_ASSERT_EQUAL_INT(-1, liveFrameDecode(frame, len, out, 1));
+}
+
+static void test_history_stream_empty() {
+  HistoryStream stream;
+  historyStreamInit(stream, HISTORY_LEVEL_SECONDS);
+  char out[64];
+  drain(stream, out, sizeof(out), 512);
+  TEST_ASSERT_EQUAL_STRING("[]", out);
+}
+
+static void test_history_stream_oldest_first_in_small_chunks() {
+  fillSeconds(5);
+  HistoryStream stream;
+  historyStreamInit(stream, HISTORY_LEVEL_SECONDS);
+  static char out[8192];
+  // Small buffers: every chunk holds at most one bucket
+  drain(stream, out, sizeof(out), 200);
+  TEST_ASSERT_EQUAL_UINT32(0, strncmp(out, "[{\"t\":0,\"tilt\":[0.00,0.00,0.00]", 31));
+  TEST_ASSERT_NOT_NULL(strstr(out, "},{\"t\":4000,\"tilt\":[4.00,4.00,4.00]"));
+  TEST_ASSERT_NULL(strstr(out, "\"t\":5000"));  // still open
+  TEST_ASSERT_EQUAL_INT(']', out[strlen(out) - 1]);
+  int objects = 0;
+  for (const char *p = out; (p = strstr(p, "{\"t\":")) != NULL; p++) objects++;
+  TEST_ASSERT_EQUAL_INT(5, objects);
+}
+
+static void test_history_stream_picks_up_buckets_closed_meanwhile() {
+  fillSeconds(3);
+  HistoryStream stream;
+  historyStreamInit(stream, HISTORY_LEVEL_SECONDS);
+  char buffer[200];
+  size_t n = historyStreamFill(stream, readBucket, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(n > 0);
+  // Two more seconds close before the next chunk; nothing repeats or goes missing
+  SensorSample s = makeSample(0, 0);
+  s.angleY = 0;
+  for (int i = 4; i <= 5; i++) {
+    s.angleX = (float)i;
+    historyAdd(history, s, i * 1000);
+  }
+  static char rest[8192];
+  drain(stream, rest, sizeof(rest), sizeof(buffer));
+  int objects = 0;
+  for (const char *p = rest; (p = strstr(p, "{\"t\":")) != NULL; p++) objects++;
+  TEST_ASSERT_EQUAL_INT(4, objects);
+  TEST_ASSERT_EQUAL_UINT32(0, strncmp(rest, ",{\"t\":1000", 10));
+  TEST_ASSERT_NOT_NULL(strstr(rest, "{\"t\":4000"));
+}
+
+static void test_history_level_names() {
+  HistoryLevel level;
+  TEST_ASSERT_TRUE(historyLevelFromName("hours", level));
+  TEST_ASSERT_EQUAL(HISTORY_LEVEL_HOURS, level);
+  TEST_ASSERT_FALSE(historyLevelFromName("days", level));
+  TEST_ASSERT_FALSE(historyLevelFromName(NULL, level));
+}
+
+static void bench_live_frame_add() {
+  LiveFrameWriter writer;
+  liveFrameInit(writer, frame);
+  SensorSample s = makeSample(0, 0);
+  benchRun("liveFrameAdd", 200000, BUDGET_LIVE_FRAME_ADD_NS, [&](uint32_t i) {
+    s.sequence = i;
+    s.timestampMs = i * 10;
+    s.angleX = (float)(i % 100) / 10.0f;
+    if (!liveFrameAdd(writer, s)) {
+      benchSink = liveFrameFinish(writer);
+      liveFrameAdd(writer, s);
+    }
+  });
+}
+
+static void bench_history_stream() {
+  fillSeconds(HISTORY_SECONDS + 1);
+  static char buffer[1400];
+  benchRun("historyStreamFill (120 buckets)", 200, BUDGET_HISTORY_STREAM_NS, [&](uint32_t) {
+    HistoryStream stream;
+    historyStreamInit(stream, HISTORY_LEVEL_SECONDS);
+    size_t n, total = 0;
+    while ((n = historyStreamFill(stream, readBucket, buffer, sizeof(buffer))) > 0) total += n;
+    benchSink = total;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_live_frame_round_trip);
+  RUN_TEST(test_live_frames_chain_and_show_gaps);
+  RUN_TEST(test_live_frame_rejects_malformed);
+  RUN_TEST(test_history_stream_empty);
+  RUN_TEST(test_history_stream_oldest_first_in_small_chunks);
+  RUN_TEST(test_history_stream_picks_up_buckets_closed_meanwhile);
+  RUN_TEST(test_history_level_names);
+  RUN_TEST(bench_live_frame_add);
+  RUN_TEST(bench_history_stream);
+  return UNITY_END();
+}
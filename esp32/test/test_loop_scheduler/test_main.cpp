@@ -0,0 +1,209 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "loop_scheduler.h"
+
+// Fake clock: stages "take time" by advancing it
+static uint32_t nowUs;
+static uint32_t fakeClock() { return nowUs; }
+
+static uint32_t fastRuns, slowRuns, stageCost;
+static char order[16];
+static int orderLength;
+
+static void fastStage() {
+  fastRuns++;
+  if (orderLength < (int)sizeof(order) - 1) order[orderLength++] = 'f';
+  nowUs += stageCost;
+}
+
+static void slowStage() {
+  slowRuns++;
+  if (orderLength < (int)sizeof(order) - 1) order[orderLength++] = 's';
+  nowUs += stageCost;
+}
+
+static LoopScheduler scheduler;
+
+void setUp() {
+  nowUs = 0;
+  fastRuns = slowRuns = stageCost = 0;
+  memset(order, 0, sizeof(order));
+  orderLength = 0;
+  schedulerInit(scheduler, fakeClock);
+}
+void tearDown() {}
+
+// Runs the scheduler like loop() does, sleeping until each next deadline
+static void runFor(uint32_t durationUs) {
+  uint32_t end = nowUs + durationUs;
+  while ((int32_t)(nowUs - end) < 0) {
+    uint32_t wait = schedulerRunDue(scheduler);
+    nowUs += wait ? wait : 1;
+  }
+}
+
+static void test_each_stage_runs_at_its_own_rate() {
+  schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  schedulerAddStage(scheduler, "display", slowStage, 500000, 0);
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT32(20, fastRuns);
+  TEST_ASSERT_EQUAL_UINT32(2, slowRuns);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.stages[0].stats.overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.stages[0].stats.maxLatenessUs);
+}
+
+static void test_returns_time_to_next_deadline() {
+  schedulerAddStage(scheduler, "upload", fastStage, 200000, 0);
+  schedulerAddStage(scheduler, "display", slowStage, 500000, 30000);
+  stageCost = 1000;
+  TEST_ASSERT_EQUAL_UINT32(29000, schedulerRunDue(scheduler));
+  TEST_ASSERT_EQUAL_UINT32(1, fastRuns);
+  TEST_ASSERT_EQUAL_UINT32(0, slowRuns);
+}
+
+static void test_earliest_deadline_runs_first() {
+  schedulerAddStage(scheduler, "a", slowStage, 100000, 2000);
+  schedulerAddStage(scheduler, "b", fastStage, 100000, 1000);
+  nowUs = 5000;
+  schedulerRunDue(scheduler);
+  TEST_ASSERT_EQUAL_STRING("fs", order);
+  TEST_ASSERT_EQUAL_UINT32(4000, scheduler.stages[1].stats.maxLatenessUs);
+  TEST_ASSERT_EQUAL_UINT32(3000, scheduler.stages[0].stats.maxLatenessUs);
+}
+
+static void test_slow_stage_counts_overruns_and_skips() {
+  schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  stageCost = 120000;  // each run eats more than two periods
+  runFor(1000000);
+  const StageStats &s = scheduler.stages[0].stats;
+  TEST_ASSERT_EQUAL_UINT32(s.runs, s.overruns);
+  TEST_ASSERT_TRUE(s.skipped > 0);
+  // Dropped deadlines keep the stage from running back to back
+  TEST_ASSERT_TRUE(s.runs <= 1000000 / 120000 + 1);
+  TEST_ASSERT_TRUE(schedulerIdlePct(scheduler, nowUs) < 25);
+}
+
+static void test_deadlines_stay_on_the_grid() {
+  schedulerAddStage(scheduler, "upload", fastStage, 200000, 0);
+  nowUs = 30000;  // first run is late
+  schedulerRunDue(scheduler);
+  TEST_ASSERT_EQUAL_UINT32(200000, scheduler.stages[0].nextDueUs);
+}
+
+static void test_idle_accounting() {
+  schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  stageCost = 5000;
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT8(90, schedulerIdlePct(scheduler, nowUs));
+  schedulerResetStats(scheduler, nowUs);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.stages[0].stats.runs);
+  TEST_ASSERT_EQUAL_UINT8(0, schedulerIdlePct(scheduler, nowUs));
+}
+
+static void test_clock_wrap() {
+  nowUs = 0xFFFFFFFFu - 60000;
+  scheduler.windowStartUs = nowUs;
+  schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  runFor(300000);
+  TEST_ASSERT_EQUAL_UINT32(6, fastRuns);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.stages[0].stats.skipped);
+}
+
+static void test_shorter_period_takes_effect_at_once() {
+  int upload = schedulerAddStage(scheduler, "upload", fastStage, 5000000, 0);
+  schedulerRunDue(scheduler);
+  nowUs = 1000000;
+  schedulerSetPeriod(scheduler, upload, 200000);
+  TEST_ASSERT_EQUAL_UINT32(1200000, scheduler.stages[upload].nextDueUs);
+  schedulerSetPeriod(scheduler, upload, 5000000);
+  TEST_ASSERT_EQUAL_UINT32(1200000, scheduler.stages[upload].nextDueUs);
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT32(2, fastRuns);
+}
+
+static void test_full_table_is_refused() {
+  for (int i = 0; i < SCHED_MAX_STAGES; i++) {
+    TEST_ASSERT_EQUAL_INT(i, schedulerAddStage(scheduler, "s", fastStage, 1000, 0));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, schedulerAddStage(scheduler, "s", fastStage, 1000, 0));
+  TEST_ASSERT_EQUAL_INT(-1, schedulerAddStage(scheduler, "zero", fastStage, 0, 0));
+}
+
+static void test_skip_and_degrade() {
+  int classify = schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  schedulerSkipNext(scheduler, classify);
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT32(19, fastRuns);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.stages[classify].stats.shed);
+  schedulerSetDegrade(scheduler, classify, 1);
+  // A rate change keeps the degrade
+  schedulerSetPeriod(scheduler, classify, 50000);
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT32(29, fastRuns);
+  schedulerSetDegrade(scheduler, classify, 0);
+  runFor(1000000);
+  TEST_ASSERT_EQUAL_UINT32(49, fastRuns);
+}
+
+static int hookStage;
+static uint32_t hookBefore, hookRunUs;
+
+static void beforeHook(int stage, uint32_t runUs) {
+  hookBefore++;
+  TEST_ASSERT_EQUAL_INT(stage, scheduler.runningStage);
+}
+
+static void afterHook(int stage, uint32_t runUs) {
+  hookStage = stage;
+  hookRunUs = runUs;
+  TEST_ASSERT_EQUAL_INT(-1, scheduler.runningStage);
+}
+
+static void test_hooks_see_every_run() {
+  hookStage = -1;
+  hookBefore = hookRunUs = 0;
+  schedulerAddStage(scheduler, "classify", fastStage, 50000, 0);
+  int display = schedulerAddStage(scheduler, "display", slowStage, 500000, 1000);
+  schedulerSetHooks(scheduler, beforeHook, afterHook);
+  stageCost = 3000;
+  nowUs = 2000;
+  schedulerRunDue(scheduler);
+  TEST_ASSERT_EQUAL_UINT32(2, hookBefore);
+  TEST_ASSERT_EQUAL_INT(display, hookStage);
+  TEST_ASSERT_EQUAL_UINT32(3000, hookRunUs);
+  TEST_ASSERT_EQUAL_INT(-1, scheduler.runningStage);
+}
+
+static void noopStage() {}
+
+static void bench_scheduler_iteration() {
+  schedulerAddStage(scheduler, "classify", noopStage, 50, 0);
+  schedulerAddStage(scheduler, "upload", noopStage, 200, 10);
+  schedulerAddStage(scheduler, "mesh", noopStage, 50, 20);
+  schedulerAddStage(scheduler, "telegram", noopStage, 2000, 30);
+  schedulerAddStage(scheduler, "display", noopStage, 500, 40);
+  schedulerAddStage(scheduler, "report", noopStage, 60000, 60000);
+  benchRun("schedulerRunDue", 200000, BUDGET_SCHEDULER_RUN_NS, [&](uint32_t i) {
+    nowUs += 10;
+    benchSink = schedulerRunDue(scheduler);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_each_stage_runs_at_its_own_rate);
+  RUN_TEST(test_returns_time_to_next_deadline);
+  RUN_TEST(test_earliest_deadline_runs_first);
+  RUN_TEST(test_slow_stage_counts_overruns_and_skips);
+  RUN_TEST(test_deadlines_stay_on_the_grid);
+  RUN_TEST(test_idle_accounting);
+  RUN_TEST(test_clock_wrap);
+  RUN_TEST(test_shorter_period_takes_effect_at_once);
+  RUN_TEST(test_full_table_is_refused);
+  RUN_TEST(test_skip_and_degrade);
+  RUN_TEST(test_hooks_see_every_run);
+  RUN_TEST(bench_scheduler_iteration);
+  return UNITY_END();
+}
@@ -0,0 +1,197 @@
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "mesh_frame.h"
+#include "mesh_gateway.h"
+#include "sim_radio.h"
+
+static const uint8_t GATEWAY_MAC[MESH_MAC_LEN] = { 0x24, 0x6F, 0x28, 0x00, 0x00, 0x01 };
+static const uint8_t LEAF_A_MAC[MESH_MAC_LEN] = { 0x24, 0x6F, 0x28, 0x00, 0x00, 0x0A };
+static const uint8_t LEAF_B_MAC[MESH_MAC_LEN] = { 0x24, 0x6F, 0x28, 0x00, 0x00, 0x0B };
+
+static MeshGateway gateway;
+static uint32_t gatewayNow;
+
+void setUp() {
+  gatewayInit(gateway);
+  gatewayNow = 0;
+}
+
+void tearDown() {}
+
+static void onFrame(const uint8_t *mac, const uint8_t *data, size_t len, void *context) {
+  gatewayReceive(gateway, mac, data, len, gatewayNow);
+}
+
+static void sendSample(SimulatedRadio &radio, uint16_t sequence, uint32_t uptimeMs, float angleX) {
+  SensorSample sample = {};
+  RiskStatus risk = {};
+  sample.timestampMs = uptimeMs;
+  sample.angleX = angleX;
+  sample.accelZ = 9.81f;
+  sample.rain = 0.35f;
+  risk.level = RISK_WARNING;
+  MeshSampleFrame frame;
+  encodeMeshFrame(sample, risk, sequence, frame);
+  radio.send(GATEWAY_MAC, (const uint8_t*)&frame, sizeof(frame));
+}
+
+static void test_frame_round_trip_precision() {
+  SensorSample in = {}, out;
+  RiskStatus risk = { 0, 0, RISK_DANGER, true, 2 }, riskOut;
+  in.timestampMs = 987654;
+  in.accelX = -3.217f;
+  in.gyroZ = 0.1234f;
+  in.temperature = 31.26f;
+  in.angleY = -17.456f;
+  in.vibrationRMS = 0.8765f;
+  in.rain = 0.333f;
+  in.soilMoisture = 1.0f;
+  MeshSampleFrame frame;
+  encodeMeshFrame(in, risk, 513, frame);
+  TEST_ASSERT_EQUAL(31, sizeof(frame));
+  TEST_ASSERT_TRUE(decodeMeshFrame((const uint8_t*)&frame, sizeof(frame), frame, out, riskOut));
+  TEST_ASSERT_EQUAL_UINT32(987654, out.timestampMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -3.217f, out.accelX);
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, 0.1234f, out.gyroZ);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 31.26f, out.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -17.456f, out.angleY);
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, 0.8765f, out.vibrationRMS);
+  TEST_ASSERT_FLOAT_WITHIN(0.0025f, 0.333f, out.rain);
+  TEST_ASSERT_FLOAT_WITHIN(0.0025f, 1.0f, out.soilMoisture);
+  TEST_ASSERT_EQUAL(RISK_DANGER, riskOut.level);
+  TEST_ASSERT_TRUE(riskOut.alertTrigger);
+  TEST_ASSERT_EQUAL_UINT8(2, riskOut.rateProfile);
+}
+
+static void test_malformed_frames_are_rejected() {
+  uint8_t junk[31] = { 0x00 };
+  TEST_ASSERT_FALSE(gatewayReceive(gateway, LEAF_A_MAC, junk, sizeof(junk), 0));
+  TEST_ASSERT_FALSE(gatewayReceive(gateway, LEAF_A_MAC, junk, 12, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, gateway.rejectedFrames);
+  TEST_ASSERT_EQUAL(0, gatewayNodeCount(gateway));
+}
+
+static void test_loss_and_batching_over_lossy_air() {
+  SimulatedAir air(10, 7);  // 10% loss
+  SimulatedRadio gatewayRadio(air, GATEWAY_MAC), leafA(air, LEAF_A_MAC), leafB(air, LEAF_B_MAC);
+  MeshBatchEntry batch[MESH_BATCH_MAX];
+  int taken = 0;
+  for (uint16_t i = 1; i <= 200; i++) {
+    gatewayNow = 1000 + i * 200;
+    sendSample(leafA, i, i * 200, 1.0f);
+    sendSample(leafB, i, 50000 + i * 200, 2.0f);
+    gatewayRadio.poll(onFrame, NULL);
+    if (gatewayBatchReady(gateway, gatewayNow)) taken += gatewayTakeBatch(gateway, batch, MESH_BATCH_MAX);
+  }
+  taken += gatewayTakeBatch(gateway, batch, MESH_BATCH_MAX);
+
+  TEST_ASSERT_EQUAL(2, gatewayNodeCount(gateway));
+  uint32_t received = 0;
+  for (int i = 0; i < 2; i++) {
+    const MeshNodeState &node = gateway.nodes[i];
+    // Every sequence number is either received or counted lost
+    TEST_ASSERT_EQUAL_UINT32(200, node.received + node.lost + (200 - node.lastSequence));
+    TEST_ASSERT_GREATER_THAN(0, node.lost);
+    received += node.received;
+  }
+  TEST_ASSERT_EQUAL_UINT32(received, taken);
+  TEST_ASSERT_EQUAL_UINT32(0, gateway.overflowDrops);
+}
+
+static void test_leaf_clock_maps_onto_gateway_clock() {
+  SimulatedAir air;
+  SimulatedRadio gatewayRadio(air, GATEWAY_MAC), leaf(air, LEAF_A_MAC);
+  // Delivery latency varies 5..20 ms; the mapping keeps the fastest one
+  const uint32_t latency[] = { 20, 5, 12, 9 };
+  for (uint16_t i = 0; i < 4; i++) {
+    gatewayNow = 100000 + i * 1000 + latency[i];
+    sendSample(leaf, i + 1, 3000 + i * 1000, 0);
+    gatewayRadio.poll(onFrame, NULL);
+  }
+  TEST_ASSERT_EQUAL(97000 + 5, (int)gateway.nodes[0].clockOffsetMs);
+  MeshBatchEntry batch[MESH_BATCH_MAX];
+  int count = gatewayTakeBatch(gateway, batch, MESH_BATCH_MAX);
+  TEST_ASSERT_EQUAL(4, count);
+  TEST_ASSERT_EQUAL_UINT32(103005, batch[3].gatewayTimeMs);
+}
+
+static void test_duplicates_and_reboots() {
+  SimulatedAir air;
+  SimulatedRadio gatewayRadio(air, GATEWAY_MAC), leaf(air, LEAF_A_MAC);
+  gatewayNow = 10000;
+  sendSample(leaf, 10, 5000, 0);
+  sendSample(leaf, 10, 5000, 0);  // retransmission
+  sendSample(leaf, 11, 5200, 0);
+  sendSample(leaf, 1, 300, 0);    // leaf rebooted: uptime went back
+  gatewayRadio.poll(onFrame, NULL);
+  const MeshNodeState &node = gateway.nodes[0];
+  TEST_ASSERT_EQUAL_UINT32(1, node.duplicates);
+  TEST_ASSERT_EQUAL_UINT32(1, node.reboots);
+  TEST_ASSERT_EQUAL_UINT32(0, node.lost);
+  TEST_ASSERT_EQUAL_UINT32(3, node.received);
+}
+
+static void test_reordered_frames_are_late_not_progress() {
+  SimulatedAir air;
+  SimulatedRadio gatewayRadio(air, GATEWAY_MAC), leaf(air, LEAF_A_MAC);
+  gatewayNow = 10000;
+  sendSample(leaf, 1, 5000, 0);
+  sendSample(leaf, 2, 5200, 0);
+  sendSample(leaf, 4, 5600, 0);
+  sendSample(leaf, 3, 5400, 0);   // overtaken by 4
+  sendSample(leaf, 2, 5200, 0);   // stale retransmission
+  sendSample(leaf, 5, 5800, 0);
+  gatewayRadio.poll(onFrame, NULL);
+  const MeshNodeState &node = gateway.nodes[0];
+  TEST_ASSERT_EQUAL_UINT32(2, node.late);
+  TEST_ASSERT_EQUAL_UINT32(1, node.lost);
+  TEST_ASSERT_EQUAL_UINT32(0, node.duplicates);
+  TEST_ASSERT_EQUAL_UINT32(0, node.reboots);
+  TEST_ASSERT_EQUAL_UINT32(4, node.received);
+  TEST_ASSERT_EQUAL_UINT16(5, node.lastSequence);
+  TEST_ASSERT_EQUAL_UINT32(5800, node.lastUptimeMs);
+  TEST_ASSERT_EQUAL(4, gateway.batchCount);
+}
+
+static void test_batch_flushes_when_full_or_old() {
+  SimulatedAir air;
+  SimulatedRadio gatewayRadio(air, GATEWAY_MAC), leaf(air, LEAF_A_MAC);
+  gatewayNow = 0;
+  sendSample(leaf, 1, 0, 0);
+  gatewayRadio.poll(onFrame, NULL);
+  TEST_ASSERT_FALSE(gatewayBatchReady(gateway, MESH_BATCH_INTERVAL_MS - 1));
+  TEST_ASSERT_TRUE(gatewayBatchReady(gateway, MESH_BATCH_INTERVAL_MS));
+  for (uint16_t i = 2; i <= MESH_BATCH_MAX; i++) sendSample(leaf, i, i * 10, 0);
+  gatewayRadio.poll(onFrame, NULL);
+  TEST_ASSERT_TRUE(gatewayBatchReady(gateway, 1));
+  sendSample(leaf, MESH_BATCH_MAX + 1, 999, 0);
+  gatewayRadio.poll(onFrame, NULL);
+  TEST_ASSERT_EQUAL_UINT32(1, gateway.overflowDrops);
+}
+
+static void bench_gateway_receive() {
+  MeshSampleFrame frame;
+  SensorSample sample = {};
+  RiskStatus risk = {};
+  MeshBatchEntry batch[MESH_BATCH_MAX];
+  benchRun("gatewayReceive", 100000, BUDGET_MESH_GATEWAY_RECEIVE_NS, [&](uint32_t i) {
+    sample.timestampMs = i * 10;
+    encodeMeshFrame(sample, risk, (uint16_t)(i + 1), frame);
+    gatewayReceive(gateway, LEAF_A_MAC, (const uint8_t*)&frame, sizeof(frame), i * 10 + 3);
+    if (gateway.batchCount == MESH_BATCH_MAX) benchSink = gatewayTakeBatch(gateway, batch, MESH_BATCH_MAX);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_round_trip_precision);
+  RUN_TEST(test_malformed_frames_are_rejected);
+  RUN_TEST(test_loss_and_batching_over_lossy_air);
+  RUN_TEST(test_leaf_clock_maps_onto_gateway_clock);
+  RUN_TEST(test_duplicates_and_reboots);
+  RUN_TEST(test_reordered_frames_are_late_not_progress);
+  RUN_TEST(test_batch_flushes_when_full_or_old);
+  RUN_TEST(bench_gateway_receive);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <stdint.h>
+#include <unity.h>
+#include "../bench.h"
+#include "notify_scheduler.h"
+
+static NotificationScheduler scheduler;
+
+void setUp() {
+  notifyInit(scheduler, 0);
+}
+
+void tearDown() {}
+
+// Same order as the Telegram task: mark the push sent, then take its tokens
+// when the queued message goes out
+static void deliver(int slot, RiskLevel level, uint32_t nowMs) {
+  notifyMarkSent(scheduler, slot, level, nowMs);
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, scheduler.subscribers[slot].chatId, nowMs));
+}
+
+static void test_bucket_burst_and_refill() {
+  TokenBucket bucket;
+  bucketInit(bucket, 2.0f, 3.0f, 1000);
+  // Starts full: a burst of the whole capacity, then nothing
+  TEST_ASSERT_TRUE(bucketTake(bucket, 1000));
+  TEST_ASSERT_TRUE(bucketTake(bucket, 1000));
+  TEST_ASSERT_TRUE(bucketTake(bucket, 1000));
+  TEST_ASSERT_FALSE(bucketTake(bucket, 1000));
+  // Two tokens a second
+  TEST_ASSERT_FALSE(bucketCanTake(bucket, 1400));
+  TEST_ASSERT_TRUE(bucketTake(bucket, 1500));
+  TEST_ASSERT_FALSE(bucketTake(bucket, 1500));
+  // A long idle spell refills to the capacity, no further
+  TEST_ASSERT_TRUE(bucketTake(bucket, 60000));
+  TEST_ASSERT_TRUE(bucketTake(bucket, 60000));
+  TEST_ASSERT_TRUE(bucketTake(bucket, 60000));
+  TEST_ASSERT_FALSE(bucketTake(bucket, 60000));
+}
+
+static void test_private_chat_rate() {
+  notifySubscribe(scheduler, "1234", 60000, RISK_SAFE, 0);
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "1234", 0));
+  TEST_ASSERT_FALSE(notifyTryAcquire(scheduler, "1234", 500));
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "1234", 1000));
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.stats.throttled);
+  // Another chat is not held up by this one
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "5678", 1000));
+}
+
+static void test_group_chat_rate() {
+  notifySubscribe(scheduler, "-1001", 60000, RISK_SAFE, 0);
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "-1001", 0));
+  // 20 a minute: one every 3 s
+  TEST_ASSERT_FALSE(notifyTryAcquire(scheduler, "-1001", 1000));
+  TEST_ASSERT_FALSE(notifyTryAcquire(scheduler, "-1001", 2900));
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "-1001", 3100));
+}
+
+static void test_global_rate() {
+  // Command replies to chats without a subscription only use the global bucket
+  int sent = 0;
+  while (notifyTryAcquire(scheduler, "42", 0)) sent++;
+  TEST_ASSERT_EQUAL_INT((int)NOTIFY_GLOBAL_BURST, sent);
+  TEST_ASSERT_FALSE(notifyTryAcquire(scheduler, "42", 20));
+  TEST_ASSERT_TRUE(notifyTryAcquire(scheduler, "42", 40));
+}
+
+static void test_due_push_goes_out_once() {
+  int slot = notifySubscribe(scheduler, "1234", 10000, RISK_SAFE, 0);
+  // Due at once after subscribing
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_SAFE, 0));
+  deliver(slot, RISK_SAFE, 0);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 5000));
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_SAFE, 10000));
+  // A level change is pushed before the interval is up
+  deliver(slot, RISK_SAFE, 10000);
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_WARNING, 12000));
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.stats.sent);
+}
+
+static void test_rate_limited_push_is_coalesced() {
+  int slot = notifySubscribe(scheduler, "-1001", 1000, RISK_SAFE, 0);
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_SAFE, 0));
+  deliver(slot, RISK_SAFE, 0);
+  // Due every second, but a group chat gets a token every 3 s
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 1000));
+  TEST_ASSERT_TRUE(scheduler.subscribers[slot].pending);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 2000));
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.stats.coalesced);
+  // The windows missed meanwhile go out as that one push
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_SAFE, 3100));
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.stats.coalesced);
+  deliver(slot, RISK_SAFE, 3100);
+  TEST_ASSERT_FALSE(scheduler.subscribers[slot].pending);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 3100));
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.stats.sent);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.stats.delayed);
+  TEST_ASSERT_EQUAL_UINT32(2100, scheduler.stats.maxDelayMs);
+}
+
+static void test_min_level_gates_pushes() {
+  int slot = notifySubscribe(scheduler, "1234", 1000, RISK_WARNING, 0);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 0));
+  TEST_ASSERT_FALSE(scheduler.subscribers[slot].pending);
+  TEST_ASSERT_EQUAL_INT(slot, notifyNextDue(scheduler, RISK_DANGER, 0));
+  deliver(slot, RISK_DANGER, 0);
+  // Pending behind the chat limit, then the level drops: nothing is sent
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_WARNING, 100));
+  TEST_ASSERT_TRUE(scheduler.subscribers[slot].pending);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 200));
+  TEST_ASSERT_FALSE(scheduler.subscribers[slot].pending);
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 5000));
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.stats.sent);
+}
+
+static void test_no_chat_starves() {
+  char ids[NOTIFY_MAX_SUBSCRIBERS][4];
+  for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+    ids[i][0] = '1' + i;
+    ids[i][1] = '\0';
+    notifySubscribe(scheduler, ids[i], 1000, RISK_SAFE, 0);
+  }
+  TEST_ASSERT_EQUAL_INT(NOTIFY_MAX_SUBSCRIBERS, notifySubscriberCount(scheduler));
+  TEST_ASSERT_EQUAL_INT(-1, notifySubscribe(scheduler, "99", 1000, RISK_SAFE, 0));
+  // Every chat gets its push in the same round, in slot order
+  for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+    int slot = notifyNextDue(scheduler, RISK_SAFE, 0);
+    TEST_ASSERT_EQUAL_INT(i, slot);
+    deliver(slot, RISK_SAFE, 0);
+  }
+  TEST_ASSERT_EQUAL_INT(-1, notifyNextDue(scheduler, RISK_SAFE, 0));
+  TEST_ASSERT_TRUE(notifyUnsubscribe(scheduler, "3"));
+  TEST_ASSERT_FALSE(notifyUnsubscribe(scheduler, "3"));
+  TEST_ASSERT_EQUAL_INT(-1, notifyFind(scheduler, "3"));
+}
+
+static void bench_next_due() {
+  char ids[NOTIFY_MAX_SUBSCRIBERS][4];
+  for (int i = 0; i < NOTIFY_MAX_SUBSCRIBERS; i++) {
+    ids[i][0] = '1' + i;
+    ids[i][1] = '\0';
+    notifySubscribe(scheduler, ids[i], 60000, RISK_SAFE, 0);
+  }
+  benchRun("notifyNextDue", 200000, BUDGET_NOTIFY_NEXT_DUE_NS, [](uint32_t i) {
+    benchSink = notifyNextDue(scheduler, RISK_SAFE, i);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_burst_and_refill);
+  RUN_TEST(test_private_chat_rate);
+  RUN_TEST(test_group_chat_rate);
+  RUN_TEST(test_global_rate);
+  RUN_TEST(test_due_push_goes_out_once);
+  RUN_TEST(test_rate_limited_push_is_coalesced);
+  RUN_TEST(test_min_level_gates_pushes);
+  RUN_TEST(test_no_chat_starves);
+  RUN_TEST(bench_next_due);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <unity.h>
+#include "../bench.h"
+#include "raw_record.h"
+#include "risk.h"
+#include "runtime_config.h"
+#include "sensor_pipeline.h"
+
+void setUp() {}
+void tearDown() {}
+
+static RawSensorFrame makeFrame(uint32_t sequence) {
+  RawSensorFrame frame = {};
+  frame.sequence = sequence;
+  frame.timestampMs = sequence * 10;
+  frame.accel[0] = 0.25f;
+  frame.accel[1] = -1.5f;
+  frame.accel[2] = 9.75f;
+  frame.gyro[0] = 0.001f;
+  frame.gyro[1] = -0.002f;
+  frame.gyro[2] = 0.003f;
+  frame.temperature = 27.25f;
+  frame.rainRaw = 3900;
+  frame.soilRaw = 1234;
+  frame.flags = RAW_FLAG_MOTION | RAW_FLAG_ANALOG;
+  return frame;
+}
+
+static void test_record_round_trip_is_exact() {
+  uint8_t record[RAW_RECORD_SIZE];
+  RawSensorFrame in = makeFrame(42), out;
+  rawRecordEncode(in, record);
+  TEST_ASSERT_TRUE(rawRecordDecode(record, sizeof(record), out));
+  TEST_ASSERT_EQUAL_UINT32(42, out.sequence);
+  TEST_ASSERT_EQUAL_UINT32(420, out.timestampMs);
+  TEST_ASSERT_TRUE(memcmp(in.accel, out.accel, sizeof(in.accel)) == 0);
+  TEST_ASSERT_TRUE(memcmp(in.gyro, out.gyro, sizeof(in.gyro)) == 0);
+  TEST_ASSERT_TRUE(in.temperature == out.temperature);
+  TEST_ASSERT_EQUAL(3900, out.rainRaw);
+  TEST_ASSERT_EQUAL(1234, out.soilRaw);
+  TEST_ASSERT_EQUAL(RAW_FLAG_MOTION | RAW_FLAG_ANALOG, out.flags);
+}
+
+static void test_damaged_record_is_rejected() {
+  uint8_t record[RAW_RECORD_SIZE];
+  RawSensorFrame out;
+  rawRecordEncode(makeFrame(1), record);
+  record[12] ^= 0x10;
+  TEST_ASSERT_FALSE(rawRecordDecode(record, sizeof(record), out));
+  rawRecordEncode(makeFrame(1), record);
+  TEST_ASSERT_FALSE(rawRecordDecode(record, sizeof(record) - 1, out));
+}
+
+// Recorded slope: 60 s at 100 Hz, tilt ramping 0 -> 25 degrees, with log
+// text interleaved as in a Serial capture
+static std::vector<uint8_t> synthCapture() {
+  std::vector<uint8_t> capture;
+  uint8_t record[RAW_RECORD_SIZE];
+  const char *log = "AX: 0.10, AY: 0.00 | LCD Message: tanah aman\n";
+  for (uint32_t i = 1; i <= 6000; i++) {
+    RawSensorFrame frame = {};
+    float tilt = (i / 6000.0f) * 25.0f * (float)M_PI / 180.0f;
+    frame.sequence = i;
+    frame.timestampMs = i * 10;
+    frame.accel[0] = 9.8f * sinf(tilt);
+    frame.accel[2] = 9.8f * cosf(tilt);
+    frame.temperature = 25.0f;
+    frame.flags = RAW_FLAG_MOTION;
+    if (i % ANALOG_DECIMATION == 1) {
+      frame.flags |= RAW_FLAG_ANALOG;
+      frame.rainRaw = 4000;
+      frame.soilRaw = 2600;
+    }
+    rawRecordEncode(frame, record);
+    capture.insert(capture.end(), record, record + RAW_RECORD_SIZE);
+    if (i % 500 == 0) capture.insert(capture.end(), log, log + strlen(log));
+  }
+  return capture;
+}
+
+// Regression for the whole offline path: scan, decode, pipeline, classify.
+// The transition times pin down the current fusion and threshold behaviour.
+static void test_replay_of_tilt_ramp() {
+  std::vector<uint8_t> capture = synthCapture();
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  SensorPipeline pipeline;
+  pipelineInit(pipeline);
+  SensorSample sample;
+  RiskLevel level = RISK_UNKNOWN;
+  bool alert;
+  uint32_t records = 0, warningAt = 0, dangerAt = 0;
+
+  size_t pos = 0;
+  while (pos + RAW_RECORD_SIZE <= capture.size()) {
+    RawSensorFrame raw;
+    if (!rawRecordDecode(&capture[pos], capture.size() - pos, raw)) {
+      pos++;
+      continue;
+    }
+    pos += RAW_RECORD_SIZE;
+    records++;
+    RiskLevel previous = level;
+    pipelineProcess(pipeline, raw, sample);
+    classifyRisk(config.thresholds, sample.angleX, sample.angleY, sample.soilMoisture, sample.rain,
+                 sample.vibrationRMS, level, alert);
+    if (level == RISK_WARNING && previous != RISK_WARNING) warningAt = raw.timestampMs;
+    if (level == RISK_DANGER && previous != RISK_DANGER) dangerAt = raw.timestampMs;
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(6000, records);
+  TEST_ASSERT_EQUAL(RISK_DANGER, level);
+  TEST_ASSERT_TRUE(alert);
+  // Tilt passes 10 deg at 24 s and 15 deg (danger) at 36 s; the fused angle
+  // trails a ramp by about one time constant (2 s)
+  TEST_ASSERT_FLOAT_WITHIN(300, 26000, warningAt);
+  TEST_ASSERT_FLOAT_WITHIN(300, 38000, dangerAt);
+}
+
+static void bench_raw_record_decode() {
+  uint8_t record[RAW_RECORD_SIZE];
+  rawRecordEncode(makeFrame(7), record);
+  RawSensorFrame out;
+  benchRun("rawRecordDecode", 200000, BUDGET_RAW_RECORD_DECODE_NS, [&](uint32_t i) {
+    benchSink = rawRecordDecode(record, sizeof(record), out) ? out.accel[i % 3] : 0;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_record_round_trip_is_exact);
+  RUN_TEST(test_damaged_record_is_rejected);
+  RUN_TEST(test_replay_of_tilt_ramp);
+  RUN_TEST(bench_raw_record_decode);
+  return UNITY_END();
+}
@@ -0,0 +1,87 @@
+#include <unity.h>
+#include "../bench.h"
+#include "risk.h"
+#include "runtime_config.h"
+
+static RiskThresholds thresholds;
+
+void setUp() {
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  thresholds = config.thresholds;
+}
+
+void tearDown() {}
+
+static RiskLevel classify(float angleX, float angleY, float soil, float rain, float vibration, bool *alert = NULL) {
+  RiskLevel level;
+  bool alertTrigger;
+  classifyRisk(thresholds, angleX, angleY, soil, rain, vibration, level, alertTrigger);
+  if (alert) *alert = alertTrigger;
+  return level;
+}
+
+static void test_quiet_slope_is_safe() {
+  bool alert = true;
+  TEST_ASSERT_EQUAL(RISK_SAFE, classify(1.0f, -2.0f, 0.10f, 0.05f, 0.1f, &alert));
+  TEST_ASSERT_FALSE(alert);
+}
+
+static void test_each_sensor_can_raise_warning() {
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(12.0f, 0, 0.10f, 0.05f, 0.1f));  // tilt
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(0, 0, 0.50f, 0.05f, 0.1f));      // moist soil
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(0, 0, 0.10f, 0.25f, 0.1f));      // rain
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(0, 0, 0.10f, 0.05f, 0.7f));      // vibration
+}
+
+static void test_each_sensor_can_raise_danger() {
+  bool alert = false;
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(0, 20.0f, 0.10f, 0.05f, 0.1f, &alert));
+  TEST_ASSERT_TRUE(alert);
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(0, 0, 0.80f, 0.05f, 0.1f));
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(0, 0, 0.10f, 0.40f, 0.1f));
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(0, 0, 0.10f, 0.05f, 1.5f));
+}
+
+static void test_tilt_uses_largest_axis_either_sign() {
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(-16.0f, 3.0f, 0.10f, 0.05f, 0.1f));
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(2.0f, -11.0f, 0.10f, 0.05f, 0.1f));
+}
+
+static void test_danger_wins_over_warning_when_both_match() {
+  bool alert = false;
+  // A saturated slope that is also tilting
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(12.0f, 0, 0.90f, 0.05f, 0.1f, &alert));
+  TEST_ASSERT_TRUE(alert);
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(20.0f, 0, 0.50f, 0.25f, 0.7f));
+  TEST_ASSERT_EQUAL(RISK_DANGER, classify(0, 12.0f, 0.10f, 0.05f, 1.5f));
+}
+
+static void test_thresholds_follow_runtime_config() {
+  TEST_ASSERT_EQUAL(RISK_WARNING, classify(12.0f, 0, 0.10f, 0.05f, 0.1f));
+  thresholds.tiltSafeMax = 14.0f;
+  thresholds.tiltWarningMin = 13.0f;
+  TEST_ASSERT_EQUAL(RISK_SAFE, classify(12.0f, 0, 0.10f, 0.05f, 0.1f));
+}
+
+static void bench_classify_risk() {
+  benchRun("classifyRisk", 200000, BUDGET_CLASSIFY_RISK_NS, [](uint32_t i) {
+    RiskLevel level;
+    bool alert;
+    float x = (i % 400) * 0.05f;
+    classifyRisk(thresholds, x, -x, (i % 100) * 0.01f, (i % 50) * 0.01f, (i % 20) * 0.1f, level, alert);
+    benchSink = level;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_quiet_slope_is_safe);
+  RUN_TEST(test_each_sensor_can_raise_warning);
+  RUN_TEST(test_each_sensor_can_raise_danger);
+  RUN_TEST(test_tilt_uses_largest_axis_either_sign);
+  RUN_TEST(test_danger_wins_over_warning_when_both_match);
+  RUN_TEST(test_thresholds_follow_runtime_config);
+  RUN_TEST(bench_classify_risk);
+  return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include <math.h>
+#include <unity.h>
+#include "../bench.h"
+#include "sensor_pipeline.h"
+
+static SensorPipeline pipeline;
+
+void setUp() {
+  pipelineInit(pipeline);
+}
+
+void tearDown() {}
+
+static RawSensorFrame still(uint32_t sequence, float ax, float ay, float az) {
+  RawSensorFrame raw = {};
+  raw.sequence = sequence;
+  raw.timestampMs = sequence * 10;
+  raw.accel[0] = ax;
+  raw.accel[1] = ay;
+  raw.accel[2] = az;
+  raw.temperature = 24.5f;
+  raw.flags = RAW_FLAG_MOTION;
+  return raw;
+}
+
+static void test_vibration_rms_of_level_board() {
+  SensorSample sample;
+  for (uint32_t i = 1; i <= VIBRATION_SAMPLES; i++) pipelineProcess(pipeline, still(i, 0, 0, 9.8f), sample);
+  // Gravity is removed from Z; the firmware reports RMS minus a 0.6 offset
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.6f, sample.vibrationRMS);
+}
+
+static void test_vibration_rms_of_known_window() {
+  SensorSample sample;
+  // Alternating +-2 m/s^2 on X only: RMS over the three axes is 2/sqrt(3)
+  for (uint32_t i = 1; i <= VIBRATION_SAMPLES; i++) {
+    pipelineProcess(pipeline, still(i, (i & 1) ? 2.0f : -2.0f, 0, 9.8f), sample);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f / sqrtf(3.0f) - 0.6f, sample.vibrationRMS);
+}
+
+static void test_vibration_window_forgets_old_samples() {
+  SensorSample sample;
+  for (uint32_t i = 1; i <= VIBRATION_SAMPLES; i++) pipelineProcess(pipeline, still(i, 3.0f, 0, 9.8f), sample);
+  for (uint32_t i = 1; i <= VIBRATION_SAMPLES; i++) pipelineProcess(pipeline, still(100 + i, 0, 0, 9.8f), sample);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.6f, sample.vibrationRMS);
+}
+
+static void test_adc_calibration_matches_arduino_map() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, rainFromRaw(4095));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, rainFromRaw(0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.50f, rainFromRaw(2047));  // integer map truncates
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, soilMoistureFromRaw(4095));  // clamped below dry
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, soilMoistureFromRaw(DRY_SOIL_VALUE));
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, soilMoistureFromRaw(WET_SOIL_VALUE));
+}
+
+static void test_analog_values_hold_between_reads() {
+  SensorSample sample;
+  RawSensorFrame raw = still(1, 0, 0, 9.8f);
+  raw.flags |= RAW_FLAG_ANALOG;
+  raw.rainRaw = 0;
+  raw.soilRaw = 0;
+  pipelineProcess(pipeline, raw, sample);
+  pipelineProcess(pipeline, still(2, 0, 0, 9.8f), sample);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sample.rain);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, sample.soilMoisture);
+  TEST_ASSERT_EQUAL_UINT32(2, sample.sequence);
+}
+
+static void test_missing_motion_keeps_tilt_and_reports_rest() {
+  SensorSample sample;
+  float tilt = 8.0f * 3.14159265f / 180.0f;
+  for (uint32_t i = 1; i <= 400; i++) pipelineProcess(pipeline, still(i, 9.8f * sinf(tilt), 0, 9.8f * cosf(tilt)), sample);
+  float angleX = sample.angleX;
+  RawSensorFrame raw = still(401, 0, 0, 0);
+  raw.flags = 0;
+  pipelineProcess(pipeline, raw, sample);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, angleX, sample.angleX);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 9.8f, sample.accelZ);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, sample.vibrationRMS);
+}
+
+static void bench_pipeline_process() {
+  SensorSample sample;
+  benchRun("pipelineProcess", 100000, BUDGET_PIPELINE_PROCESS_NS, [&](uint32_t i) {
+    RawSensorFrame raw = still(i, 0.01f * (i % 7), -0.02f * (i % 5), 9.8f);
+    raw.gyro[0] = 0.001f * (i % 3);
+    if (i % ANALOG_DECIMATION == 0) raw.flags |= RAW_FLAG_ANALOG;
+    pipelineProcess(pipeline, raw, sample);
+    benchSink = sample.vibrationRMS;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_vibration_rms_of_level_board);
+  RUN_TEST(test_vibration_rms_of_known_window);
+  RUN_TEST(test_vibration_window_forgets_old_samples);
+  RUN_TEST(test_adc_calibration_matches_arduino_map);
+  RUN_TEST(test_analog_values_hold_between_reads);
+  RUN_TEST(test_missing_motion_keeps_tilt_and_reports_rest);
+  RUN_TEST(bench_pipeline_process);
+  return UNITY_END();
+}
@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "raw_record.h"
+#include "series_codec.h"
+
+static uint8_t block[SERIES_BLOCK_BYTES];
+static uint32_t rng;
+
+void setUp() {
+  rng = 12345;
+}
+void tearDown() {}
+
+static int noise(int span) {
+  rng = rng * 1664525u + 1013904223u;
+  return (int)((rng >> 16) % (2 * span + 1)) - span;
+}
+
+// A still slope as the MPU6050 reports it: readings are whole LSB counts
+// (+-2 g and +-500 deg/s ranges) scaled by the driver, with a few counts of
+// noise, 100 Hz timestamps with the odd millisecond of jitter, and the
+// rain/soil ADCs wandering by a count or two
+static RawSensorFrame syntheticFrame(uint32_t i) {
+  RawSensorFrame f = {};
+  f.sequence = 1000 + i;
+  f.timestampMs = 50000 + i * 10 + (i % 37 == 0 ? 1 : 0);
+  const int16_t accel[3] = { 512, -300, 16100 };
+  for (int a = 0; a < 3; a++) f.accel[a] = (accel[a] + noise(3)) / 16384.0f * 9.80665f;
+  for (int g = 0; g < 3; g++) f.gyro[g] = noise(2) / 65.5f * 0.017453292f;
+  f.temperature = (-4200 + noise(1)) / 340.0f + 36.53f;
+  f.rainRaw = 4000 + noise(2);
+  f.soilRaw = 3100 + noise(1);
+  f.flags = RAW_FLAG_MOTION;
+  return f;
+}
+
+static void assertSameFrame(const RawSensorFrame &a, const RawSensorFrame &b) {
+  TEST_ASSERT_EQUAL_UINT32(a.sequence, b.sequence);
+  TEST_ASSERT_EQUAL_UINT32(a.timestampMs, b.timestampMs);
+  // Lossless: compare the bits, not the values
+  TEST_ASSERT_EQUAL_INT(0, memcmp(a.accel, b.accel, sizeof(a.accel)));
+  TEST_ASSERT_EQUAL_INT(0, memcmp(a.gyro, b.gyro, sizeof(a.gyro)));
+  TEST_ASSERT_EQUAL_INT(0, memcmp(&a.temperature, &b.temperature, sizeof(float)));
+  TEST_ASSERT_EQUAL_UINT16(a.rainRaw, b.rainRaw);
+  TEST_ASSERT_EQUAL_UINT16(a.soilRaw, b.soilRaw);
+  TEST_ASSERT_EQUAL_UINT8(a.flags, b.flags);
+}
+
+// Fills one block from `frames`; returns how many went in
+static uint32_t fillBlock(const RawSensorFrame *frames, uint32_t count, size_t &used) {
+  SeriesEncoder encoder;
+  seriesEncoderInit(encoder, block, sizeof(block));
+  uint32_t n = 0;
+  while (n < count && seriesAppend(encoder, frames[n])) n++;
+  used = seriesFinish(encoder);
+  return n;
+}
+
+static void test_round_trip_synthetic() {
+  static RawSensorFrame frames[400];
+  for (uint32_t i = 0; i < 400; i++) frames[i] = syntheticFrame(i);
+  size_t used;
+  uint32_t n = fillBlock(frames, 400, used);
+  TEST_ASSERT_TRUE(n > 20);
+  TEST_ASSERT_TRUE(used <= sizeof(block));
+
+  SeriesDecoder decoder;
+  TEST_ASSERT_TRUE(seriesDecoderInit(decoder, block, used));
+  TEST_ASSERT_EQUAL_UINT16(n, decoder.count);
+  RawSensorFrame out;
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(seriesNext(decoder, out));
+    assertSameFrame(frames[i], out);
+  }
+  TEST_ASSERT_FALSE(seriesNext(decoder, out));
+}
+
+static void test_round_trip_edge_values() {
+  static RawSensorFrame frames[8];
+  memset(frames, 0, sizeof(frames));
+  for (int i = 0; i < 8; i++) {
+    frames[i].sequence = 7 + i;
+    frames[i].timestampMs = 1000 + i * 10;
+  }
+  frames[1].timestampMs = 0xFFFFFFF0u;  // large jumps and the millis() wrap
+  frames[2].timestampMs = 0x00000005u;
+  frames[3].sequence = 0;               // sequence restart
+  frames[4].accel[0] = -0.0f;
+  frames[4].gyro[1] = 1e-38f;
+  frames[5].accel[0] = 3.4e38f;
+  frames[5].temperature = -273.15f;
+  frames[6].rainRaw = 0xFFFF;
+  frames[6].flags = 0xFF;
+  frames[7].timestampMs = frames[6].timestampMs + 3000;  // dod in the 12-bit bucket
+
+  size_t used;
+  TEST_ASSERT_EQUAL_UINT32(8, fillBlock(frames, 8, used));
+  SeriesDecoder decoder;
+  TEST_ASSERT_TRUE(seriesDecoderInit(decoder, block, used));
+  RawSensorFrame out;
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT_TRUE(seriesNext(decoder, out));
+    assertSameFrame(frames[i], out);
+  }
+}
+
+static void test_repeated_frame_costs_a_few_bits() {
+  RawSensorFrame f = syntheticFrame(0);
+  SeriesEncoder encoder;
+  seriesEncoderInit(encoder, block, sizeof(block));
+  TEST_ASSERT_TRUE(seriesAppend(encoder, f));
+  uint32_t first = encoder.bitPos;
+  TEST_ASSERT_EQUAL_UINT32(8 * RAW_RECORD_PAYLOAD, first);
+  // Same spacing, next sequence, identical readings: one bit per field
+  for (int i = 0; i < 3; i++) {
+    f.sequence++;
+    f.timestampMs += 10;
+    TEST_ASSERT_TRUE(seriesAppend(encoder, f));
+  }
+  uint32_t second = encoder.bitPos;
+  f.sequence++;
+  f.timestampMs += 10;
+  TEST_ASSERT_TRUE(seriesAppend(encoder, f));
+  TEST_ASSERT_EQUAL_UINT32(1 + 1 + SERIES_FLOATS + 3, encoder.bitPos - second);
+}
+
+static void test_full_block_rejects_without_damage() {
+  static RawSensorFrame frames[400];
+  for (uint32_t i = 0; i < 400; i++) frames[i] = syntheticFrame(i);
+  SeriesEncoder encoder;
+  seriesEncoderInit(encoder, block, sizeof(block));
+  uint32_t n = 0;
+  while (seriesAppend(encoder, frames[n])) n++;
+  TEST_ASSERT_TRUE(n < 400);
+  uint32_t bits = encoder.bitPos;
+  TEST_ASSERT_FALSE(seriesAppend(encoder, frames[n]));
+  TEST_ASSERT_EQUAL_UINT32(bits, encoder.bitPos);
+  TEST_ASSERT_EQUAL_UINT16(n, encoder.count);
+
+  size_t used = seriesFinish(encoder);
+  SeriesDecoder decoder;
+  TEST_ASSERT_TRUE(seriesDecoderInit(decoder, block, used));
+  RawSensorFrame out;
+  for (uint32_t i = 0; i < n; i++) {
+    TEST_ASSERT_TRUE(seriesNext(decoder, out));
+    assertSameFrame(frames[i], out);
+  }
+
+  // The next block starts over from the rejected frame
+  used = 0;
+  TEST_ASSERT_TRUE(fillBlock(frames + n, 400 - n, used) > 0);
+  TEST_ASSERT_TRUE(seriesDecoderInit(decoder, block, used));
+  TEST_ASSERT_TRUE(seriesNext(decoder, out));
+  assertSameFrame(frames[n], out);
+}
+
+static void test_rejects_damaged_blocks() {
+  static RawSensorFrame frames[50];
+  for (uint32_t i = 0; i < 50; i++) frames[i] = syntheticFrame(i);
+  size_t used;
+  fillBlock(frames, 50, used);
+  SeriesDecoder decoder;
+  TEST_ASSERT_TRUE(seriesDecoderInit(decoder, block, used));
+  TEST_ASSERT_FALSE(seriesDecoderInit(decoder, block, used - 1));
+  block[SERIES_HEADER_BYTES + 10] ^= 0x04;
+  TEST_ASSERT_FALSE(seriesDecoderInit(decoder, block, used));
+  block[SERIES_HEADER_BYTES + 10] ^= 0x04;
+  block[0] = 'X';
+  TEST_ASSERT_FALSE(seriesDecoderInit(decoder, block, used));
+  // Erased flash
+  memset(block, 0xFF, sizeof(block));
+  TEST_ASSERT_FALSE(seriesDecoderInit(decoder, block, sizeof(block)));
+}
+
+static RawSensorFrame benchFrames[4096];
+
+static void bench_series_compression() {
+  for (uint32_t i = 0; i < 4096; i++) benchFrames[i] = syntheticFrame(i);
+  // Ratio against the raw record format over many blocks
+  uint32_t frames = 0, blocks = 0, stored = 0;
+  while (frames < 4096) {
+    size_t used;
+    frames += fillBlock(benchFrames + frames, 4096 - frames, used);
+    stored += used;
+    blocks++;
+  }
+  double ratio = (double)frames * RAW_RECORD_SIZE / stored;
+  printf("series: %u frames in %u blocks, %.1f bytes/frame, %.2fx vs %d-byte raw records\n",
+         (unsigned)frames, (unsigned)blocks, (double)stored / frames, ratio, RAW_RECORD_SIZE);
+  TEST_ASSERT_TRUE(ratio > 2.0);
+}
+
+static void bench_series_append() {
+  SeriesEncoder encoder;
+  seriesEncoderInit(encoder, block, sizeof(block));
+  benchRun("seriesAppend", 200000, BUDGET_SERIES_APPEND_NS, [&](uint32_t i) {
+    if (!seriesAppend(encoder, benchFrames[i & 4095])) {
+      seriesFinish(encoder);
+      seriesEncoderInit(encoder, block, sizeof(block));
+    }
+    benchSink = encoder.count;
+  });
+}
+
+static void bench_series_next() {
+  size_t used;
+  fillBlock(benchFrames, 4096, used);
+  SeriesDecoder decoder;
+  RawSensorFrame out;
+  seriesDecoderInit(decoder, block, used);
+  benchRun("seriesNext", 200000, BUDGET_SERIES_NEXT_NS, [&](uint32_t) {
+    if (!seriesNext(decoder, out)) {
+      decoder.bitPos = 0;
+      decoder.decoded = 0;
+      seriesNext(decoder, out);
+    }
+    benchSink = out.accel[0];
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_synthetic);
+  RUN_TEST(test_round_trip_edge_values);
+  RUN_TEST(test_repeated_frame_costs_a_few_bits);
+  RUN_TEST(test_full_block_rejects_without_damage);
+  RUN_TEST(test_rejects_damaged_blocks);
+  RUN_TEST(bench_series_compression);
+  RUN_TEST(bench_series_append);
+  RUN_TEST(bench_series_next);
+  return UNITY_END();
+}
@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "sleep_state.h"
+#include "sensor_pipeline.h"
+
+static RiskThresholds thresholds;
+static SensorSample calm;
+
+void setUp() {
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  thresholds = config.thresholds;
+  memset(&calm, 0, sizeof(calm));
+  calm.angleX = 1.0f;
+  calm.soilMoisture = 0.10f;
+}
+void tearDown() {}
+
+static RiskStatus safeStatus() {
+  RiskStatus risk = { 0, 0, RISK_SAFE, false, RATE_SAFE };
+  return risk;
+}
+
+// Settles a rate state in RATE_SAFE, classifying at 20 Hz
+static uint32_t settle(AdaptiveRate &rate) {
+  adaptiveRateInit(rate, 0);
+  uint32_t t = 0;
+  for (; rate.profile != RATE_SAFE; t += 50) adaptiveRateUpdate(rate, thresholds, RISK_SAFE, calm, t);
+  return t;
+}
+
+static void test_wake_levels_match_the_watch_level() {
+  UlpWakeLevels levels = ulpWakeLevels(thresholds);
+  float rain = rainFromRaw(levels.rainBelow) * 100;
+  float soil = soilMoistureFromRaw(levels.soilBelow) * 100;
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, thresholds.rainWarning * RATE_WATCH_FRACTION, rain);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, thresholds.moistureWarning * RATE_WATCH_FRACTION, soil);
+  // A dry reading stays above the levels, a wet one goes below
+  TEST_ASSERT_TRUE(4000 > levels.rainBelow);
+  TEST_ASSERT_TRUE(2600 > levels.soilBelow);
+  TEST_ASSERT_TRUE(500 < levels.soilBelow);
+}
+
+static void test_wake_levels_clamp() {
+  RiskThresholds t = thresholds;
+  t.rainWarning = 0;
+  t.moistureWarning = 500;
+  UlpWakeLevels levels = ulpWakeLevels(t);
+  TEST_ASSERT_EQUAL_UINT16(4095, levels.rainBelow);
+  TEST_ASSERT_EQUAL_UINT16(WET_SOIL_VALUE, levels.soilBelow);
+}
+
+static void test_only_a_calm_reported_node_sleeps() {
+  RiskStatus risk = safeStatus();
+  TEST_ASSERT_TRUE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS, 1));
+  TEST_ASSERT_FALSE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS - 1, 1));
+  TEST_ASSERT_FALSE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS, 0));
+  risk.rateProfile = RATE_WATCH;
+  TEST_ASSERT_FALSE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS, 1));
+  risk = safeStatus();
+  risk.level = RISK_WARNING;
+  TEST_ASSERT_FALSE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS, 1));
+  risk = safeStatus();
+  risk.alertTrigger = true;
+  TEST_ASSERT_FALSE(sleepAllowed(risk, DEEP_SLEEP_MIN_AWAKE_MS, 1));
+}
+
+static void test_seal_detects_damage() {
+  SleepState state;
+  memset(&state, 0, sizeof(state));
+  TEST_ASSERT_FALSE(sleepStateValid(state));
+  state.stats.sleeps = 3;
+  state.risk = safeStatus();
+  sleepStateSeal(state);
+  TEST_ASSERT_TRUE(sleepStateValid(state));
+  state.stats.sleeps++;
+  TEST_ASSERT_FALSE(sleepStateValid(state));
+  sleepStateSeal(state);
+  state.magic ^= 1;
+  TEST_ASSERT_FALSE(sleepStateValid(state));
+}
+
+static void test_rate_state_survives_sleep() {
+  SleepState state;
+  memset(&state, 0, sizeof(state));
+  uint32_t t = settle(state.rate);
+  state.savedAtMs = t;
+  // Slept 5 minutes; this boot is 800 ms old
+  AdaptiveRate rate;
+  AnomalyDetector anomaly;
+  sleepStateRestore(state, DEEP_SLEEP_REPORT_S * 1000UL + 800, 800, rate, anomaly);
+  TEST_ASSERT_EQUAL(RATE_SAFE, rate.profile);
+  TEST_ASSERT_EQUAL_UINT32(state.rate.transitions, rate.transitions);
+  // Time in the profile counts the sleep
+  TEST_ASSERT_EQUAL_UINT32(t - state.rate.profileSinceMs + DEEP_SLEEP_REPORT_S * 1000UL + 800,
+                           800 - rate.profileSinceMs);
+  // Still calm: stays in RATE_SAFE, no transition on the first classification
+  TEST_ASSERT_FALSE(adaptiveRateUpdate(rate, thresholds, RISK_SAFE, calm, 800));
+  TEST_ASSERT_EQUAL(RATE_SAFE, rate.profile);
+}
+
+static void test_trend_spans_the_sleep() {
+  SleepState state;
+  memset(&state, 0, sizeof(state));
+  uint32_t t = settle(state.rate);
+  state.savedAtMs = t;
+  AdaptiveRate rate;
+  AnomalyDetector anomaly;
+  sleepStateRestore(state, 5 * 60000UL, 1000, rate, anomaly);
+  // Moisture rose 20 points while asleep, measured from the last baseline
+  // before the sleep: a rising trend, though still far from the warning
+  SensorSample wetter = calm;
+  wetter.soilMoisture = calm.soilMoisture + 0.20f;
+  adaptiveRateUpdate(rate, thresholds, RISK_SAFE, wetter, 1000);
+  float minutes = (t - state.rate.trendStartMs + 5 * 60000UL) / 60000.0f;
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 20.0f / minutes, rate.moistureTrend);
+  TEST_ASSERT_EQUAL(RATE_WATCH, rate.profile);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_wake_levels_match_the_watch_level);
+  RUN_TEST(test_wake_levels_clamp);
+  RUN_TEST(test_only_a_calm_reported_node_sleeps);
+  RUN_TEST(test_seal_detects_damage);
+  RUN_TEST(test_rate_state_survives_sleep);
+  RUN_TEST(test_trend_spans_the_sleep);
+  return UNITY_END();
+}
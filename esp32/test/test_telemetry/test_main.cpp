@@ -0,0 +1,234 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include "../bench.h"
+#include "telemetry.h"
+#include "adaptive_rate.h"
+#include "anomaly.h"
+#include "history.h"
+
+static LatestSnapshot snapshot;
+
+void setUp() {
+  memset(&snapshot, 0, sizeof(snapshot));
+  SensorSample &s = snapshot.sample;
+  s.accelX = 0.123f;
+  s.accelY = -0.456f;
+  s.accelZ = 9.81f;
+  s.gyroX = 0.01f;
+  s.gyroY = -0.02f;
+  s.gyroZ = 0.0f;
+  s.vibrationRMS = 0.345f;
+  s.soilMoisture = 0.42f;
+  s.rain = 0.07f;
+  s.temperature = 26.5f;
+  s.timestampMs = 123456;
+  s.angleX = 3.26f;
+  s.angleY = -7.84f;
+  snapshot.risk.level = RISK_WARNING;
+  snapshot.risk.alertTrigger = false;
+}
+
+void tearDown() {}
+
+static void test_document_layout() {
+  char out[TELEMETRY_JSON_MAX];
+  int n = formatTelemetryJson(out, sizeof(out), snapshot, "esp32-a1b2c3d4e5f6", 1760000000);
+  TEST_ASSERT_EQUAL_STRING(
+    "{\"sensors\":{"
+      "\"accelerometer\":{\"x\":0.12,\"y\":-0.46,\"z\":9.81},"
+      "\"gyro\":{\"x\":0.01,\"y\":-0.02,\"z\":0.00},"
+      "\"vibrationRMS\":0.34,\"soilMoisture\":0.42,\"rainfall\":0.07,"
+      "\"temperature\":26.50,\"sampleTime\":123456,"
+      "\"tilt\":{\"angleX\":3.3,\"angleY\":-7.8,\"maxTilt\":7.8}},"
+    "\"status\":{\"landslideRisk\":\"warning\",\"alertTriggered\":false,"
+      "\"rateProfile\":\"full\",\"sampleHz\":100,\"uploadMs\":200,"
+      "\"anomaly\":{\"tilt\":0.00,\"moisture\":0.00,\"rain\":0.00,\"vibration\":0.00},"
+      "\"trend\":{\"tiltVelocity\":0.00,\"moistureRate\":0.00,\"rainEventHours\":0.00,\"rain24hHours\":0.00}},"
+    "\"deviceId\":\"esp32-a1b2c3d4e5f6\",\"ts\":1760000000}", out);
+  TEST_ASSERT_EQUAL((int)strlen(out), n);
+}
+
+static void test_timestamp_omitted_before_clock_sync() {
+  char out[TELEMETRY_JSON_MAX];
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NULL(strstr(out, "\"ts\""));
+  TEST_ASSERT_EQUAL('}', out[strlen(out) - 1]);
+}
+
+static void test_alert_and_danger() {
+  char out[TELEMETRY_JSON_MAX];
+  snapshot.risk.level = RISK_DANGER;
+  snapshot.risk.alertTrigger = true;
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"status\":{\"landslideRisk\":\"danger\",\"alertTriggered\":true,"));
+}
+
+static void test_rate_profile_is_reported() {
+  char out[TELEMETRY_JSON_MAX];
+  snapshot.risk.level = RISK_SAFE;
+  snapshot.risk.rateProfile = RATE_SAFE;
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"rateProfile\":\"safe\",\"sampleHz\":25,\"uploadMs\":5000,"));
+}
+
+static void test_anomaly_scores_are_reported() {
+  char out[TELEMETRY_JSON_MAX];
+  snapshot.risk.anomalyScore[ANOMALY_MOISTURE] = 1.25f;
+  snapshot.risk.anomalyMask = 1 << ANOMALY_MOISTURE;
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"anomaly\":{\"tilt\":0.00,\"moisture\":1.25,\"rain\":0.00,"));
+}
+
+static void test_non_finite_values_stay_valid_json() {
+  char out[TELEMETRY_JSON_MAX];
+  snapshot.sample.temperature = NAN;
+  snapshot.sample.angleX = INFINITY;
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NULL(strstr(out, ":nan"));
+  TEST_ASSERT_NULL(strstr(out, ":inf"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"temperature\":0.00"));
+}
+
+static void test_trends_are_reported() {
+  char out[TELEMETRY_JSON_MAX];
+  snapshot.risk.trend.ratesValid = true;
+  snapshot.risk.trend.tiltVelocity = 0.75f;
+  snapshot.risk.trend.rainEventHours = 3.5f;
+  formatTelemetryJson(out, sizeof(out), snapshot, "node", 0);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"trend\":{\"tiltVelocity\":0.75,\"moistureRate\":0.00,\"rainEventHours\":3.50,"));
+}
+
+static void test_worst_case_fits_buffer() {
+  char out[TELEMETRY_JSON_MAX];
+  SensorSample &s = snapshot.sample;
+  // Full-scale readings (8 g, 500 deg/s) and the longest device id
+  s.accelX = s.accelY = s.accelZ = -78.48f;
+  s.gyroX = s.gyroY = s.gyroZ = -8.73f;
+  s.vibrationRMS = -135.93f;
+  s.temperature = -40.0f;
+  s.timestampMs = 4294967295u;
+  s.angleX = s.angleY = -180.0f;
+  snapshot.risk.level = RISK_WARNING;
+  snapshot.risk.rateProfile = RATE_WATCH;
+  for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) snapshot.risk.anomalyScore[i] = ANOMALY_CUSUM_CAP;
+  // Steepest fits the history can produce, and a saturated rain event
+  snapshot.risk.trend.tiltVelocity = -1200.0f;
+  snapshot.risk.trend.moistureRate = -666.67f;
+  snapshot.risk.trend.rainEventHours = HISTORY_RAIN_EVENT_MAX_H + 0.99f;
+  snapshot.risk.trend.rain24hHours = 24.0f;
+  char id[32];
+  memset(id, 'x', sizeof(id) - 1);
+  id[sizeof(id) - 1] = '\0';
+  TEST_ASSERT_GREATER_THAN(0, formatTelemetryJson(out, sizeof(out), snapshot, id, 4294967295u));
+}
+
+static void test_small_buffer_is_rejected() {
+  char out[64];
+  TEST_ASSERT_EQUAL(-1, formatTelemetryJson(out, sizeof(out), snapshot, "node", 1760000000));
+}
+
+static void test_diagnostics_document() {
+  HeapReport report;
+  memset(&report, 0, sizeof(report));
+  report.uptimeS = 3600;
+  report.freeBytes = 120000;
+  report.minFreeBytes = 95000;
+  report.largestFreeBlock = 90000;
+  report.allocTracking = true;
+  report.subsystems[HEAP_TELEGRAM].allocs = 42;
+  report.subsystems[HEAP_TELEGRAM].allocBytes = 8192;
+  report.subsystems[HEAP_LOGIC].scopes = 7;
+  report.subsystems[HEAP_LOGIC].scopeDelta = -64;
+  report.arenas[ARENA_LOOP].capacity = 8192;
+  report.arenas[ARENA_LOOP].peak = 1530;
+  report.arenas[ARENA_TELEGRAM].overflows = 2;
+  DeadlineMonitor deadlines;
+  deadlineInit(deadlines);
+  deadlineAdd(deadlines, "classify", 20000, 0);
+  int upload = deadlineAdd(deadlines, "upload", 1000000, DEADLINE_ALLOW(DEADLINE_SKIP));
+  deadlineCheck(deadlines, upload, 1500000);
+  deadlineCheck(deadlines, upload, 2500000);
+  deadlines.resetReason = "task_wdt";
+  deadlines.resetItem = upload;
+  char out[DIAGNOSTICS_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, formatDiagnosticsJson(out, sizeof(out), report, deadlines, 1760000000));
+  TEST_ASSERT_NOT_NULL(strstr(out, "{\"uptime\":3600,\"heap\":{\"free\":120000,\"minFree\":95000,"
+                                   "\"largestBlock\":90000,\"fragmentation\":25,\"allocTracking\":true}"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"telegram\":{\"allocs\":42,\"allocBytes\":8192,"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"scopes\":7,\"scopeDelta\":-64}"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"arenas\":{\"loop\":{\"capacity\":8192,\"peak\":1530,\"overflows\":0},"
+                                   "\"telegram\":{\"capacity\":0,\"peak\":0,\"overflows\":2}}"));
+  TEST_ASSERT_NOT_NULL(strstr(out, ",\"deadlines\":{\"misses\":2,\"lastMiss\":\"upload\",\"reset\":\"task_wdt\","
+                                   "\"resetIn\":\"upload\",\"items\":{\"classify\":{\"budget\":20000,\"misses\":0,"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"upload\":{\"budget\":1000000,\"misses\":2,\"worst\":2500000,"
+                                   "\"escalations\":1,\"action\":\"skip\",\"degraded\":false}}}"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "}}},\"ts\":1760000000}"));
+}
+
+static void test_diagnostics_without_misses() {
+  HeapReport report;
+  memset(&report, 0, sizeof(report));
+  DeadlineMonitor deadlines;
+  deadlineInit(deadlines);
+  char out[DIAGNOSTICS_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, formatDiagnosticsJson(out, sizeof(out), report, deadlines, 0));
+  TEST_ASSERT_NOT_NULL(strstr(out, ",\"deadlines\":{\"misses\":0,\"lastMiss\":null,\"reset\":\"unknown\","
+                                   "\"resetIn\":null,\"items\":{}}}"));
+}
+
+static void test_diagnostics_worst_case_fits_buffer() {
+  HeapReport report;
+  memset(&report, 0xFF, sizeof(report));
+  for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; i++) report.subsystems[i].scopeDelta = INT32_MIN;
+  report.allocTracking = false;
+  // Every item with the longest stage name and all counters saturated
+  DeadlineMonitor deadlines;
+  deadlineInit(deadlines);
+  for (int i = 0; i < DEADLINE_MAX_ITEMS; i++) deadlineAdd(deadlines, "telegram", 4294967295u, 0);
+  for (int i = 0; i < DEADLINE_MAX_ITEMS; i++) {
+    DeadlineItem &item = deadlines.items[i];
+    item.misses = item.worstUs = item.escalations = 4294967295u;
+    item.worstAction = DEADLINE_RESTART;
+    item.degraded = false;
+  }
+  deadlines.misses = 4294967295u;
+  deadlines.lastMiss = deadlines.resetItem = 0;
+  deadlines.resetReason = "brownout";
+  char out[DIAGNOSTICS_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, formatDiagnosticsJson(out, sizeof(out), report, deadlines, 4294967295u));
+}
+
+static void test_fragmentation_percentage() {
+  TEST_ASSERT_EQUAL(0, heapFragmentationPct(0, 0));
+  TEST_ASSERT_EQUAL(0, heapFragmentationPct(50000, 50000));
+  TEST_ASSERT_EQUAL(75, heapFragmentationPct(40000, 10000));
+}
+
+static void bench_telemetry_json() {
+  char out[TELEMETRY_JSON_MAX];
+  benchRun("formatTelemetryJson", 50000, BUDGET_TELEMETRY_JSON_NS, [&](uint32_t i) {
+    snapshot.sample.timestampMs = i;
+    benchSink = formatTelemetryJson(out, sizeof(out), snapshot, "esp32-a1b2c3d4e5f6", 1760000000 + i);
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_document_layout);
+  RUN_TEST(test_timestamp_omitted_before_clock_sync);
+  RUN_TEST(test_alert_and_danger);
+  RUN_TEST(test_rate_profile_is_reported);
+  RUN_TEST(test_non_finite_values_stay_valid_json);
+  RUN_TEST(test_anomaly_scores_are_reported);
+  RUN_TEST(test_trends_are_reported);
+  RUN_TEST(test_worst_case_fits_buffer);
+  RUN_TEST(test_small_buffer_is_rejected);
+  RUN_TEST(test_diagnostics_document);
+  RUN_TEST(test_diagnostics_without_misses);
+  RUN_TEST(test_diagnostics_worst_case_fits_buffer);
+  RUN_TEST(test_fragmentation_percentage);
+  RUN_TEST(bench_telemetry_json);
+  return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <math.h>
+#include <unity.h>
+#include "../bench.h"
+#include "fastmath.h"
+#include "fusion.h"
+
+#define DT 0.01f
+#define TIME_CONSTANT 2.0f
+#define DECIMATION 4
+
+static TiltFusion fusion;
+
+void setUp() {
+  fusionInit(fusion, DT, TIME_CONSTANT, DECIMATION);
+}
+
+void tearDown() {}
+
+// Deterministic noise (LCG + Box-Muller) so the runs are reproducible
+static uint32_t noiseState = 12345;
+static float gaussian() {
+  noiseState = noiseState * 1664525u + 1013904223u;
+  float u1 = ((noiseState >> 8) + 1) / 16777217.0f;
+  noiseState = noiseState * 1664525u + 1013904223u;
+  float u2 = (noiseState >> 8) / 16777216.0f;
+  return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+static void test_fast_atan2_error_bound() {
+  double worst = 0;
+  for (int i = -200; i <= 200; i++) {
+    for (int j = -200; j <= 200; j++) {
+      if (i == 0 && j == 0) continue;
+      float y = i * 0.37f, x = j * 0.53f;
+      double err = fabs((double)fastAtan2(y, x) - atan2((double)y, (double)x));
+      if (err > worst) worst = err;
+    }
+  }
+  TEST_ASSERT_TRUE_MESSAGE(worst <= 2e-6, "fastAtan2 error above 2e-6 rad");
+}
+
+static void test_fast_sqrt_error_bound() {
+  double worst = 0;
+  for (float x = 1e-30f; x < 1e30f; x *= 1.37f) {
+    double exact = sqrt((double)x);
+    double relSqrt = fabs(fastSqrt(x) - exact) / exact;
+    double relInv = fabs(fastInvSqrt(x) - 1.0 / exact) * exact;
+    if (relSqrt > worst) worst = relSqrt;
+    if (relInv > worst) worst = relInv;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(worst <= 5e-6, "fastSqrt/fastInvSqrt relative error above 5e-6");
+  TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, fastSqrt(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, fastSqrt(-4));
+}
+
+static void test_fusion_seeds_from_accelerometer() {
+  float tilt = degToRad(12.0f);
+  fusionUpdate(fusion, 9.8f * sinf(tilt), 0, 9.8f * cosf(tilt), 0, 0);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 12.0f, fusion.angleX);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, fusion.angleY);
+}
+
+static void test_fusion_tracks_gyro_rotation() {
+  fusionUpdate(fusion, 0, 0, 9.8f, 0, 0);
+  // 10 deg/s about the X axis for one second; accelerometer still says level,
+  // so the result lies between the gyro estimate (10) and the accel (0)
+  float rate = degToRad(10.0f);
+  for (int i = 0; i < 100; i++) fusionUpdate(fusion, 0, 0, 9.8f, rate, 0);
+  TEST_ASSERT_FLOAT_WITHIN(1.5f, 8.5f, fusion.angleY);
+}
+
+static void test_fusion_converges_to_accelerometer_tilt() {
+  fusionUpdate(fusion, 0, 0, 9.8f, 0, 0);
+  float tilt = degToRad(-6.0f);
+  for (int i = 0; i < 3000; i++) fusionUpdate(fusion, 9.8f * sinf(tilt), 0, 9.8f * cosf(tilt), 0, 0);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, -6.0f, fusion.angleX);
+}
+
+// Replays a noisy still slope: the fused angle must be much steadier than
+// the raw accelerometer angle the firmware used before fusion
+static void test_fusion_reduces_accelerometer_noise() {
+  float tilt = degToRad(10.0f);
+  double rawSq = 0, fusedSq = 0;
+  int count = 0;
+  for (int i = 0; i < 6000; i++) {
+    float ax = 9.8f * sinf(tilt) + 0.3f * gaussian();
+    float ay = 0.3f * gaussian();
+    float az = 9.8f * cosf(tilt) + 0.3f * gaussian();
+    float gx = 0.002f * gaussian(), gy = 0.002f * gaussian();
+    fusionUpdate(fusion, ax, ay, az, gx, gy);
+    if (i < 1000) continue;  // settle
+    double raw = radToDeg(atan2f(ax, sqrtf(ay * ay + az * az))) - 10.0;
+    double fused = fusion.angleX - 10.0;
+    rawSq += raw * raw;
+    fusedSq += fused * fused;
+    count++;
+  }
+  double rawRms = sqrt(rawSq / count), fusedRms = sqrt(fusedSq / count);
+  char message[96];
+  snprintf(message, sizeof(message), "raw %.3f deg rms, fused %.3f deg rms", rawRms, fusedRms);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_TRUE_MESSAGE(fusedRms < rawRms / 4, message);
+}
+
+static void bench_fast_atan2() {
+  // libm reference on the same inputs, for comparison in the results
+  benchRun("atan2f", 500000, BUDGET_FAST_ATAN2_NS, [](uint32_t i) {
+    benchSink = atan2f((float)(i % 1000) - 500.0f, (float)(i % 777) + 1.0f);
+  });
+  benchRun("fastAtan2", 500000, BUDGET_FAST_ATAN2_NS, [](uint32_t i) {
+    benchSink = fastAtan2((float)(i % 1000) - 500.0f, (float)(i % 777) + 1.0f);
+  });
+}
+
+static void bench_fast_sqrt() {
+  benchRun("fastSqrt", 500000, BUDGET_FAST_SQRT_NS, [](uint32_t i) {
+    benchSink = fastSqrt((float)i * 0.25f + 1.0f);
+  });
+}
+
+static void bench_fusion_update() {
+  fusionUpdate(fusion, 0, 0, 9.8f, 0, 0);
+  benchRun("fusionUpdate", 200000, BUDGET_FUSION_UPDATE_NS, [](uint32_t i) {
+    fusionUpdate(fusion, 0.01f * (i % 9), 0.02f * (i % 5), 9.8f, 0.001f, -0.001f);
+    benchSink = fusion.angleX;
+  });
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fast_atan2_error_bound);
+  RUN_TEST(test_fast_sqrt_error_bound);
+  RUN_TEST(test_fusion_seeds_from_accelerometer);
+  RUN_TEST(test_fusion_tracks_gyro_rotation);
+  RUN_TEST(test_fusion_converges_to_accelerometer_tilt);
+  RUN_TEST(test_fusion_reduces_accelerometer_noise);
+  RUN_TEST(bench_fast_atan2);
+  RUN_TEST(bench_fast_sqrt);
+  RUN_TEST(bench_fusion_update);
+  return UNITY_END();
+}
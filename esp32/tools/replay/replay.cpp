@@ -0,0 +1,205 @@
+// Host replay of raw sensor recordings (see include/raw_record.h).
+//
+// Feeds every record through the firmware's own sensor pipeline, history,
+// risk classifier and anomaly detector as fast as possible, then prints a risk
+// timeline and the time spent in each stage. Build from esp32/:
+//
+//   g++ -O2 -std=c++17 -Iinclude -o replay tools/replay/replay.cpp
+//       src/raw_record.cpp src/sensor_pipeline.cpp src/fusion.cpp src/risk.cpp
+//       src/runtime_config.cpp src/snapshot.cpp src/adaptive_rate.cpp src/anomaly.cpp
+//       src/history.cpp
+//
+// Usage: replay [-t key=value]... [-m mode] [-e N] [-o timeline.csv] capture.bin
+//   -t  override a threshold (same keys as /devices/<id>/config/thresholds)
+//   -m  normal | silent | test
+//   -e  also write every Nth sample to the timeline (transitions are always written)
+//   -o  timeline CSV path (default: stdout)
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "anomaly.h"
+#include "history.h"
+#include "raw_record.h"
+#include "risk.h"
+#include "runtime_config.h"
+#include "sensor_pipeline.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(Clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> &data) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.insert(data.end(), buffer, buffer + n);
+  fclose(f);
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: replay [-t key=value]... [-m mode] [-e N] [-o timeline.csv] capture.bin\n");
+  exit(2);
+}
+
+static void writeRow(FILE *out, const SensorSample &s, RiskLevel level, bool alert) {
+  fprintf(out, "%u,%u,%.2f,%.2f,%.3f,%.2f,%.2f,%s,%d\n", s.sequence, s.timestampMs, s.angleX, s.angleY,
+          s.vibrationRMS, s.rain, s.soilMoisture, riskLevelName(level), alert ? 1 : 0);
+}
+
+int main(int argc, char **argv) {
+  RuntimeConfig config;
+  defaultRuntimeConfig(config);
+  const char *inputPath = NULL;
+  const char *outputPath = NULL;
+  unsigned every = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      char key[64];
+      float value;
+      if (sscanf(argv[++i], "%63[^=]=%f", key, &value) != 2 || !applyConfigValue(config, key, value)) {
+        fprintf(stderr, "bad threshold: %s\n", argv[i]);
+        return 2;
+      }
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      if (!applyConfigMode(config, argv[++i])) {
+        fprintf(stderr, "bad mode: %s\n", argv[i]);
+        return 2;
+      }
+    } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+      every = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else if (argv[i][0] == '-' || inputPath) {
+      usage();
+    } else {
+      inputPath = argv[i];
+    }
+  }
+  if (!inputPath) usage();
+  if (!validateRuntimeConfig(config)) {
+    fprintf(stderr, "thresholds are inconsistent\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> data;
+  if (!readFile(inputPath, data)) {
+    fprintf(stderr, "cannot read %s\n", inputPath);
+    return 1;
+  }
+  FILE *out = outputPath ? fopen(outputPath, "w") : stdout;
+  if (!out) {
+    fprintf(stderr, "cannot write %s\n", outputPath);
+    return 1;
+  }
+  fprintf(out, "sequence,timeMs,angleX,angleY,vibrationRMS,rain,soilMoisture,level,alert\n");
+
+  SensorPipeline pipeline;
+  pipelineInit(pipeline);
+  SensorSample sample = {};
+  RiskLevel level = RISK_UNKNOWN;
+  bool alert = false;
+  AnomalyDetector anomaly;
+  bool anomalyStarted = false;
+  static SensorHistory history;  // too big for the stack
+  historyInit(history);
+  TrendFeatures trend;
+
+  uint32_t records = 0, skippedBytes = 0, gaps = 0, transitions = 0;
+  uint32_t firstMs = 0, lastMs = 0, lastSequence = 0;
+  uint32_t levelMs[RISK_DANGER + 1] = {};
+  double decodeNs = 0, pipelineNs = 0, classifyNs = 0;
+  Clock::time_point total = Clock::now();
+
+  size_t pos = 0;
+  while (pos + RAW_RECORD_SIZE <= data.size()) {
+    RawSensorFrame raw;
+    Clock::time_point t0 = Clock::now();
+    bool ok = rawRecordDecode(&data[pos], data.size() - pos, raw);
+    decodeNs += elapsedNs(t0);
+    if (!ok) {
+      // Log text or a damaged record; resynchronise on the next byte
+      pos++;
+      skippedBytes++;
+      continue;
+    }
+    pos += RAW_RECORD_SIZE;
+
+    if (records == 0) {
+      firstMs = raw.timestampMs;
+    } else {
+      if (raw.sequence != lastSequence + 1) gaps++;
+      levelMs[level] += raw.timestampMs - lastMs;
+    }
+    records++;
+    lastSequence = raw.sequence;
+    lastMs = raw.timestampMs;
+
+    uint8_t previousRate = pipeline.rateProfile;
+    t0 = Clock::now();
+    pipelineProcess(pipeline, raw, sample);
+    pipelineNs += elapsedNs(t0);
+    if (pipeline.rateProfile != previousRate) {
+      fprintf(stderr, "%10.3f s  rate %s -> %s\n", (raw.timestampMs - firstMs) / 1000.0,
+              rateProfileName((RateProfile)previousRate), rateProfileName((RateProfile)pipeline.rateProfile));
+    }
+
+    RiskLevel previous = level;
+    t0 = Clock::now();
+    classifyRisk(config.thresholds, sample.angleX, sample.angleY, sample.soilMoisture, sample.rain,
+                 sample.vibrationRMS, level, alert);
+    historyAdd(history, sample, raw.timestampMs);
+    historyFeatures(history, trend);
+    applyTrendRisk(config.thresholds, trend, level, alert);
+    if (!anomalyStarted) {
+      anomalyInit(anomaly, raw.timestampMs);
+      anomalyStarted = true;
+    }
+    uint8_t previousMask = anomaly.mask;
+    anomalyUpdate(anomaly, sample, raw.timestampMs);
+    level = anomalyRiskLevel(level, anomaly.mask);
+    classifyNs += elapsedNs(t0);
+    for (int i = 0; i < ANOMALY_CHANNEL_COUNT; i++) {
+      uint8_t bit = 1 << i;
+      if ((anomaly.mask ^ previousMask) & bit) {
+        fprintf(stderr, "%10.3f s  %s anomaly %s (baseline %.2f)\n", (raw.timestampMs - firstMs) / 1000.0,
+                anomalyChannelName((AnomalyChannel)i), anomaly.mask & bit ? "on" : "off",
+                anomaly.channels[i].baseline);
+      }
+    }
+
+    bool changed = level != previous;
+    if (changed && previous != RISK_UNKNOWN) {
+      transitions++;
+      fprintf(stderr, "%10.3f s  %s -> %s\n", (raw.timestampMs - firstMs) / 1000.0,
+              riskLevelName(previous), riskLevelName(level));
+    }
+    if (changed || (every && records % every == 0)) writeRow(out, sample, level, alert);
+  }
+  double totalNs = elapsedNs(total);
+  if (out != stdout) fclose(out);
+
+  skippedBytes += data.size() - pos;
+  double recordedS = (lastMs - firstMs) / 1000.0;
+  fprintf(stderr, "\n%u records, %u bytes skipped, %u sequence gaps, %.1f s recorded (mode %s)\n",
+          records, skippedBytes, gaps, recordedS, deviceModeName(config.mode));
+  if (records == 0) return 1;
+  fprintf(stderr, "%u transitions; time safe %.1f s, warning %.1f s, danger %.1f s\n", transitions,
+          levelMs[RISK_SAFE] / 1000.0, levelMs[RISK_WARNING] / 1000.0, levelMs[RISK_DANGER] / 1000.0);
+  fprintf(stderr, "%u anomaly alarms; at the end creep %.2f deg/h, rain event %.2f h\n", anomaly.alarms,
+          trend.tiltVelocity, trend.rainEventHours);
+  fprintf(stderr, "stage      total ms   ns/record\n");
+  fprintf(stderr, "decode   %10.2f %11.1f\n", decodeNs / 1e6, decodeNs / records);
+  fprintf(stderr, "pipeline %10.2f %11.1f\n", pipelineNs / 1e6, pipelineNs / records);
+  fprintf(stderr, "classify %10.2f %11.1f\n", classifyNs / 1e6, classifyNs / records);
+  fprintf(stderr, "total    %10.2f   (%.0fx real time)\n", totalNs / 1e6,
+          totalNs > 0 ? recordedS * 1e9 / totalNs : 0);
+  return 0;
+}
@@ -33,10 +33,11 @@ from firebase_admin import credentials, db
 class LandslideDataSimulator:
     """Simulates landslide monitoring sensor data with different risk levels"""
     
-    def __init__(self, firebase_url: str, service_account_path: str):
+    def __init__(self, firebase_url: str, service_account_path: str, device_id: str = "SIMULATOR_001"):
         """Initialize the simulator with Firebase configuration"""
         self.firebase_url = firebase_url
         self.service_account_path = service_account_path
+        self.device_id = device_id
         self.firebase_ref = None
         
         # Risk level configurations
@@ -86,7 +87,7 @@ class LandslideDataSimulator:
                     'databaseURL': self.firebase_url
                 })
             
-            self.firebase_ref = db.reference('/')
+            self.firebase_ref = db.reference(f'/devices/{self.device_id}/live')
             print(f"✅ Firebase initialized successfully")
             return True
             
@@ -165,7 +166,7 @@ class LandslideDataSimulator:
                 "alertTriggered": alert_triggered
             },
             "timestamp": datetime.now().isoformat(),
-            "deviceId": "SIMULATOR_001"
+            "deviceId": self.device_id
         }
         
         return data
@@ -177,7 +178,7 @@ class LandslideDataSimulator:
                 print("❌ Firebase not initialized")
                 return False
             
-            # Send to root path (matching ESP32 behavior)
+            # Send to the device's live node (matching ESP32 behavior)
             self.firebase_ref.set(data)
             return True
             
@@ -275,11 +276,13 @@ def main():
     parser.add_argument("--service-account", 
                        default="../backend/serviceAccountKey.json",
                        help="Path to Firebase service account key")
+    parser.add_argument("--device-id", default="SIMULATOR_001",
+                       help="Device id to write under /devices/<id>/live")
     
     args = parser.parse_args()
     
     # Initialize simulator
-    simulator = LandslideDataSimulator(args.firebase_url, args.service_account)
+    simulator = LandslideDataSimulator(args.firebase_url, args.service_account, args.device_id)
     
     if not simulator.initialize_firebase():
         sys.exit(1)
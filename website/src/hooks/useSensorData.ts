@@ -8,7 +8,14 @@ export function useSensorData() {
     const [error, setError] = useState<string | null>(null)
 
     useEffect(() => {
-        const sensorRef = ref(database, `/`)
+        // Each node writes its live snapshot under /devices/<id>/live
+        const deviceId = import.meta.env.VITE_DEVICE_ID
+        if (!deviceId) {
+            setError("VITE_DEVICE_ID belum diatur")
+            setLoading(false)
+            return
+        }
+        const sensorRef = ref(database, `/devices/${deviceId}/live`)
 
         const unsubscribe = onValue(
             sensorRef,